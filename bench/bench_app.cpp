@@ -0,0 +1,209 @@
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <quickfix/FixFieldNumbers.h>
+#include <quickfix/Message.h>
+#include <quickfix/SessionID.h>
+
+#include <benchmark/benchmark.h>
+
+#include "application.h"
+#include "builtin.h"
+
+// Run from the repository root.
+constexpr auto kConfig = "cfg/cfg_1.yaml";
+
+// Reaches into Application for the pieces of the reply path. The
+// application is never given an acceptor, so nothing here may dispatch.
+class ApplicationBench {
+public:
+    ApplicationBench()
+        : m_app(std::make_shared<asio::io_context>(), loadConfig()) {}
+
+    static Config loadConfig() {
+        auto [cfg, error] = yaml_cpp_struct::from_yaml<Config>(kConfig);
+        if (!cfg)
+            throw std::runtime_error(error);
+        return std::move(cfg.value());
+    }
+
+    Config &config() { return m_app.m_cfg; }
+
+    void fill(FIX::Message &out, const FIX::Message &msg,
+              const FieldTemplate &field) {
+        m_app.fill(out, msg, field);
+    }
+    std::shared_ptr<FIX::Message> executionReport() {
+        return factory().execution_report();
+    }
+    bool buildReply(OutboundMessage &out, const ReplyData &reply,
+                    const FixFieldMap &common, const FIX::Message &msg) {
+        return m_app.buildReply(out, factory(), reply.reply, common, msg,
+                                reply.msg_type);
+    }
+    void addSession(const FIX::SessionID &id) { m_app.onCreate(id); }
+    const Reply *match(const FIX::Message &msg) { return m_app.match(msg); }
+    void addTimedTask(const FIX::SessionID &id, std::vector<ReplyData> &flow,
+                      FixFieldMap &common,
+                      const std::shared_ptr<FIX::Message> &msg) {
+        m_app.addTimedTask(id, flow, common, msg);
+    }
+    // Builds every queued reply and throws the batches away.
+    size_t drain() {
+        m_app.collectDue(std::chrono::system_clock::time_point::max());
+        size_t count = 0;
+        for (auto &[id, batch] : m_app.m_batches) {
+            count += batch.size();
+            batch.clear();
+        }
+        return count;
+    }
+
+private:
+    static const MessageFactory &factory() {
+        return *MessageFactory::find("FIX.4.2");
+    }
+
+    Application m_app;
+};
+
+namespace {
+
+ApplicationBench &bench() {
+    static ApplicationBench instance;
+    return instance;
+}
+
+FIX::Message newOrder(const std::string &cl_ord_id,
+                      const std::string &ord_type = "1") {
+    FIX::Message msg;
+    auto &hdr = msg.getHeader();
+    hdr.setField(FIX::FIELD::BeginString, "FIX.4.2");
+    hdr.setField(FIX::FIELD::MsgType, "D");
+    hdr.setField(FIX::FIELD::SenderCompID, "CLIENT");
+    hdr.setField(FIX::FIELD::TargetCompID, "FIXSIM");
+    msg.setField(FIX::FIELD::ClOrdID, cl_ord_id);
+    msg.setField(FIX::FIELD::HandlInst, "1");
+    msg.setField(FIX::FIELD::Symbol, "USDJPY");
+    msg.setField(FIX::FIELD::Side, "1");
+    msg.setField(FIX::FIELD::TransactTime, "20250101-09:30:00.123");
+    msg.setField(FIX::FIELD::OrdType, ord_type);
+    msg.setField(FIX::FIELD::OrderQty, "100");
+    return msg;
+}
+
+void BM_FillExecReport(benchmark::State &state, int field,
+                       const std::string &value) {
+    auto &app = bench();
+    const auto order = newOrder("ORDER123");
+    const auto tmpl = FieldTemplate::parse(field, value);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto report = app.executionReport();
+        state.ResumeTiming();
+        app.fill(*report, order, tmpl);
+        benchmark::DoNotOptimize(report.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_FillExecReport, constant, 39, "0");
+BENCHMARK_CAPTURE(BM_FillExecReport, input, 37, "input.11");
+BENCHMARK_CAPTURE(BM_FillExecReport, input_header, 115, "input_header.49");
+BENCHMARK_CAPTURE(BM_FillExecReport, uuid, 17, "call.uuid");
+BENCHMARK_CAPTURE(BM_FillExecReport, getTzDateTime, 60,
+                  "call.getTzDateTime");
+BENCHMARK_CAPTURE(BM_FillExecReport, createUniqueOrderID, 37,
+                  "call.createUniqueOrderID");
+BENCHMARK_CAPTURE(BM_FillExecReport, expr, 32,
+                  "expr: min(input.38 * 0.5, 100)");
+
+// One full accept report of cfg_1's default flow: message creation, every
+// common and reply field, and the encode.
+void BM_BuildReply(benchmark::State &state) {
+    auto &app = bench();
+    const auto order = newOrder("ORDER123");
+    const auto &flow = app.config().custom_reply.front().default_reply_flow;
+    OutboundMessage out;
+    for (auto _ : state) {
+        app.buildReply(out, flow.reply_flow.front(), flow.common_fields,
+                       order);
+        benchmark::DoNotOptimize(out.body.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BuildReply);
+
+void BM_MatchRule(benchmark::State &state) {
+    auto &app = bench();
+    // Market orders match the first rule, limit orders fall through to none.
+    const auto order = newOrder("ORDER123", state.range(0) ? "1" : "2");
+    for (auto _ : state)
+        benchmark::DoNotOptimize(app.match(order));
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(state.range(0) ? "hit" : "miss");
+}
+BENCHMARK(BM_MatchRule)->Arg(1)->Arg(0);
+
+void BM_GetTzDateTime(benchmark::State &state) {
+    for (auto _ : state)
+        benchmark::DoNotOptimize(getTzDateTime());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetTzDateTime);
+
+void BM_Uuid(benchmark::State &state) {
+    for (auto _ : state)
+        benchmark::DoNotOptimize(uuid());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Uuid);
+
+// range(0) orders go through m_timed: cfg_1's default flow with every
+// interval set to 0, so each order queues one entry per reply.
+void timedFlow(benchmark::State &state, bool time_drain) {
+    auto &app = bench();
+    const FIX::SessionID id("FIX.4.2", "FIXSIM", "CLIENT");
+    app.addSession(id);
+    // The config's own maps: replies are built from the templates
+    // compiled for them.
+    auto &common = app.config().custom_reply.front().default_reply_flow
+                       .common_fields;
+    auto &flow =
+        app.config().custom_reply.front().default_reply_flow.reply_flow;
+    for (auto &reply : flow)
+        reply.interval = 0;
+    std::vector<std::shared_ptr<FIX::Message>> orders;
+    for (int64_t i = 0; i < state.range(0); ++i)
+        orders.push_back(std::make_shared<FIX::Message>(
+            newOrder("ORDER" + std::to_string(i))));
+    for (auto _ : state) {
+        for (const auto &order : orders)
+            app.addTimedTask(id, flow, common, order);
+        if (!time_drain)
+            state.PauseTiming();
+        benchmark::DoNotOptimize(app.drain());
+        if (!time_drain)
+            state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) *
+                            flow.size());
+}
+
+void BM_TimedInsert(benchmark::State &state) {
+    timedFlow(state, false);
+}
+BENCHMARK(BM_TimedInsert)->Arg(1024)->Arg(16384);
+
+void BM_TimedInsertDrain(benchmark::State &state) {
+    timedFlow(state, true);
+}
+BENCHMARK(BM_TimedInsertDrain)->Arg(1024)->Arg(16384);
+
+}  // namespace
+
+BENCHMARK_MAIN();
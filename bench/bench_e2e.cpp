@@ -0,0 +1,509 @@
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <quickfix/Application.h>
+#include <quickfix/FixFieldNumbers.h>
+#include <quickfix/Log.h>
+#include <quickfix/MessageStore.h>
+#include <quickfix/Session.h>
+#include <quickfix/SessionSettings.h>
+#include <quickfix/SocketAcceptor.h>
+#include <quickfix/SocketInitiator.h>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include "application.h"
+#include "asio_acceptor.h"
+#include "builtin.h"
+#include "fix_encoder.h"
+#include "histogram.h"
+#include "io_pool.h"
+
+// Runs fixsim's acceptor and a QuickFIX initiator in one process over
+// loopback, fires NewOrderSingle at it and measures the time to the first
+// reply of every order.
+//
+// With --transport the rules are left out and every order gets one
+// ExecutionReport, so the transport alone is compared: "socket" is
+// QuickFIX's SocketAcceptor sending each reply with sendToTarget, as fixsim
+// did before AsioAcceptor, and "asio" is AsioAcceptor sending FixEncoder
+// bodies in batches. "socket,asio" runs both, one after the other, so the
+// two can be compared on the same box; a summary line per run goes to
+// stderr.
+//
+// bench_e2e [--orders N] [--rate N] [--timeout S] [--symbol S]
+//           [--ord-type T] [--transport socket|asio|socket,asio]
+//           [--out file.json]
+//           [cfg.yaml...]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    uint64_t orders{20000};
+    // Orders per second, 0 for as fast as the initiator takes them.
+    uint64_t rate{0};
+    std::chrono::seconds timeout{30};
+    std::string symbol{"USDJPY"};
+    std::string ord_type{"1"};
+    // Empty for the whole of fixsim.
+    std::vector<std::string> transports;
+    std::string out;
+    std::vector<std::string> configs;
+};
+
+class NullLogFactory : public FIX::LogFactory {
+public:
+    FIX::Log *create() override { return new FIX::NullLog; }
+    FIX::Log *create(const FIX::SessionID &) override {
+        return new FIX::NullLog;
+    }
+    void destroy(FIX::Log *log) override { delete log; }
+};
+
+constexpr std::string_view kPrefix = "e2e.";
+
+class Client : public FIX::Application {
+public:
+    explicit Client(uint64_t orders)
+        : m_sent(new std::atomic<int64_t>[orders]),
+          m_answered(new std::atomic<bool>[orders]),
+          m_orders(orders) {
+        for (uint64_t i = 0; i < orders; ++i) {
+            m_sent[i].store(0, std::memory_order::relaxed);
+            m_answered[i].store(false, std::memory_order::relaxed);
+        }
+    }
+
+    void onCreate(const FIX::SessionID &) override {}
+    void onLogon(const FIX::SessionID &) override { ++m_logged_on; }
+    void onLogout(const FIX::SessionID &) override { --m_logged_on; }
+    void toAdmin(FIX::Message &, const FIX::SessionID &) override {}
+    void toApp(FIX::Message &, const FIX::SessionID &) override {}
+    void fromAdmin(const FIX::Message &, const FIX::SessionID &) override {}
+    void fromApp(const FIX::Message &msg, const FIX::SessionID &) override {
+        const auto now = Clock::now().time_since_epoch().count();
+        const auto &type = msg.getHeader().getField(FIX::FIELD::MsgType);
+        if (type != FIX::MsgType_ExecutionReport &&
+            type != FIX::MsgType_OrderCancelReject)
+            return;
+        m_replies.fetch_add(1, std::memory_order::relaxed);
+        if (!msg.isSetField(FIX::FIELD::ClOrdID))
+            return;
+        std::string_view cl_ord_id = msg.getField(FIX::FIELD::ClOrdID);
+        if (!cl_ord_id.starts_with(kPrefix))
+            return;
+        cl_ord_id.remove_prefix(kPrefix.size());
+        uint64_t index = 0;
+        auto [ptr, ec] = std::from_chars(
+            cl_ord_id.data(), cl_ord_id.data() + cl_ord_id.size(), index);
+        if (ec != std::errc{} || index >= m_orders ||
+            m_answered[index].exchange(true, std::memory_order::relaxed))
+            return;
+        m_latency.record(
+            now - m_sent[index].load(std::memory_order::acquire));
+        m_last_reply.store(now, std::memory_order::relaxed);
+        m_answered_count.fetch_add(1, std::memory_order::release);
+    }
+
+    void sent(uint64_t index, Clock::time_point at) {
+        m_sent[index].store(at.time_since_epoch().count(),
+                            std::memory_order::release);
+    }
+    int loggedOn() const { return m_logged_on.load(); }
+    uint64_t answered() const {
+        return m_answered_count.load(std::memory_order::acquire);
+    }
+    uint64_t replies() const { return m_replies.load(); }
+    int64_t lastReply() const { return m_last_reply.load(); }
+    // Only read once the initiator has stopped.
+    const Histogram &latency() const { return m_latency; }
+
+private:
+    std::unique_ptr<std::atomic<int64_t>[]> m_sent;
+    std::unique_ptr<std::atomic<bool>[]> m_answered;
+    uint64_t m_orders;
+    std::atomic<int> m_logged_on{0};
+    std::atomic<uint64_t> m_answered_count{0};
+    std::atomic<uint64_t> m_replies{0};
+    std::atomic<int64_t> m_last_reply{0};
+    Histogram m_latency;
+};
+
+// Answers every NewOrderSingle with one ExecutionReport from a single app
+// thread, like fixsim's timer loop: one by one through QuickFIX without an
+// acceptor set, otherwise as one batch per session and wakeup.
+class Echo : public FIX::Application {
+public:
+    explicit Echo(asio::io_context &ctx) : m_ctx(ctx) {}
+
+    void setAcceptor(AsioAcceptor *acceptor) { m_acceptor = acceptor; }
+
+    void onCreate(const FIX::SessionID &) override {}
+    void onLogon(const FIX::SessionID &) override {}
+    void onLogout(const FIX::SessionID &) override {}
+    void toAdmin(FIX::Message &, const FIX::SessionID &) override {}
+    void toApp(FIX::Message &, const FIX::SessionID &) override {}
+    void fromAdmin(const FIX::Message &, const FIX::SessionID &) override {}
+    void fromApp(const FIX::Message &msg, const FIX::SessionID &id) override {
+        if (msg.getHeader().getField(FIX::FIELD::MsgType) !=
+            FIX::MsgType_NewOrderSingle)
+            return;
+        {
+            std::lock_guard lk(m_mutex);
+            m_pending.emplace_back(id, report(msg));
+            if (m_posted)
+                return;
+            m_posted = true;
+        }
+        asio::post(m_ctx, [this] { flush(); });
+    }
+
+private:
+    FIX::Message report(const FIX::Message &order) {
+        const auto &qty = order.getField(FIX::FIELD::OrderQty);
+        FIX::Message msg;
+        msg.getHeader().setField(FIX::FIELD::MsgType,
+                                 FIX::MsgType_ExecutionReport);
+        msg.setField(FIX::FIELD::OrderID, order.getField(FIX::FIELD::ClOrdID));
+        msg.setField(FIX::FIELD::ClOrdID, order.getField(FIX::FIELD::ClOrdID));
+        msg.setField(FIX::FIELD::ExecID, std::to_string(++m_exec_id));
+        msg.setField(FIX::FIELD::ExecTransType, "0");
+        msg.setField(FIX::FIELD::ExecType, "0");
+        msg.setField(FIX::FIELD::OrdStatus, "0");
+        msg.setField(FIX::FIELD::Symbol, order.getField(FIX::FIELD::Symbol));
+        msg.setField(FIX::FIELD::Side, order.getField(FIX::FIELD::Side));
+        msg.setField(FIX::FIELD::OrderQty, qty);
+        msg.setField(FIX::FIELD::LeavesQty, qty);
+        msg.setField(FIX::FIELD::CumQty, "0");
+        msg.setField(FIX::FIELD::AvgPx, "0");
+        return msg;
+    }
+
+    void flush() {
+        std::vector<std::pair<FIX::SessionID, FIX::Message>> pending;
+        {
+            std::lock_guard lk(m_mutex);
+            pending.swap(m_pending);
+            m_posted = false;
+        }
+        if (m_acceptor == nullptr) {
+            for (auto &[id, msg] : pending)
+                FIX::Session::sendToTarget(msg, id);
+            return;
+        }
+        for (auto &[id, msg] : pending) {
+            auto &out = m_batches[id].emplace_back();
+            out.msg_type = FIX::MsgType_ExecutionReport;
+            FixEncoder::appendFields(out.body, msg);
+        }
+        for (auto &[id, batch] : m_batches) {
+            if (!batch.empty())
+                m_acceptor->send(id, batch);
+            batch.clear();
+        }
+    }
+
+    asio::io_context &m_ctx;
+    AsioAcceptor *m_acceptor{nullptr};
+    std::mutex m_mutex;
+    std::vector<std::pair<FIX::SessionID, FIX::Message>> m_pending;
+    bool m_posted{false};
+    // Only touched on the app thread.
+    uint64_t m_exec_id{0};
+    std::map<FIX::SessionID, std::vector<OutboundMessage>> m_batches;
+};
+
+// One initiator session per acceptor session, with the comp ids swapped.
+FIX::SessionSettings initiatorSettings(const FIX::SessionSettings &acceptor) {
+    FIX::SessionSettings settings;
+    FIX::Dictionary defaults;
+    defaults.setString(FIX::CONNECTION_TYPE, "initiator");
+    defaults.setString(FIX::START_TIME, "00:00:00");
+    defaults.setString(FIX::END_TIME, "00:00:00");
+    defaults.setInt(FIX::HEARTBTINT, 30);
+    defaults.setInt(FIX::RECONNECT_INTERVAL, 1);
+    defaults.setBool(FIX::RESET_ON_LOGON, true);
+    defaults.setBool(FIX::USE_DATA_DICTIONARY, false);
+    defaults.setBool(FIX::SOCKET_NODELAY, true);
+    settings.set(defaults);
+    for (const auto &id : acceptor.getSessions()) {
+        FIX::Dictionary dict;
+        dict.setString(FIX::SOCKET_CONNECT_HOST, "127.0.0.1");
+        dict.setInt(FIX::SOCKET_CONNECT_PORT,
+                    acceptor.get(id).getInt(FIX::SOCKET_ACCEPT_PORT));
+        settings.set(FIX::SessionID(id.getBeginString(), id.getTargetCompID(),
+                                    id.getSenderCompID(),
+                                    id.getSessionQualifier()),
+                     dict);
+    }
+    return settings;
+}
+
+// Every reply echoes ClOrdID so it can be matched to its order.
+void echoClOrdID(Config &cfg) {
+    for (auto &rule : cfg.custom_reply) {
+        if (!rule.check_cl_order_id.empty())
+            rule.check_cl_order_id.try_emplace(FIX::FIELD::ClOrdID,
+                                               "input.11");
+        rule.default_reply_flow.common_fields.try_emplace(
+            FIX::FIELD::ClOrdID, "input.11");
+        for (auto &flow : rule.symbols_reply_flow)
+            flow.common_fields.try_emplace(FIX::FIELD::ClOrdID, "input.11");
+    }
+}
+
+FIX::Message newOrder(const Options &opts, uint64_t index) {
+    FIX::Message msg;
+    msg.getHeader().setField(FIX::FIELD::MsgType,
+                             FIX::MsgType_NewOrderSingle);
+    msg.setField(FIX::FIELD::ClOrdID,
+                 std::string(kPrefix) + std::to_string(index));
+    msg.setField(FIX::FIELD::HandlInst, "1");
+    msg.setField(FIX::FIELD::Symbol, opts.symbol);
+    msg.setField(FIX::FIELD::Side, "1");
+    msg.setField(FIX::FIELD::TransactTime, getTzDateTime());
+    msg.setField(FIX::FIELD::OrdType, opts.ord_type);
+    msg.setField(FIX::FIELD::OrderQty, "100");
+    return msg;
+}
+
+template <typename Pred>
+bool waitFor(std::chrono::seconds timeout, Pred &&pred) {
+    const auto deadline = Clock::now() + timeout;
+    while (!pred()) {
+        if (Clock::now() > deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Logs an initiator on to every session of settings, sends the orders and
+// reports how they were answered. The acceptor is already running.
+nlohmann::json measure(const Options &opts, const std::string &name,
+                       const FIX::SessionSettings &settings) {
+    Client client(opts.orders);
+    auto client_settings = initiatorSettings(settings);
+    FIX::MemoryStoreFactory client_store;
+    NullLogFactory client_log;
+    FIX::SocketInitiator initiator(client, client_store, client_settings,
+                                   client_log);
+    initiator.start();
+    std::vector<FIX::SessionID> ids;
+    for (const auto &id : client_settings.getSessions())
+        ids.push_back(id);
+    if (!waitFor(opts.timeout, [&] {
+            return client.loggedOn() == static_cast<int>(ids.size());
+        }))
+        throw std::runtime_error(name + ": logon timed out");
+
+    // With a rate each order is timed from when it was due, not when it
+    // went out, so a stalled sender shows up as latency.
+    const auto start = Clock::now();
+    const auto gap =
+        opts.rate == 0 ? Clock::duration::zero()
+                       : std::chrono::duration_cast<Clock::duration>(
+                             std::chrono::seconds(1)) /
+                             opts.rate;
+    for (uint64_t i = 0; i < opts.orders; ++i) {
+        auto msg = newOrder(opts, i);
+        auto due = start + gap * i;
+        if (opts.rate != 0) {
+            while (Clock::now() < due)
+                std::this_thread::yield();
+        } else {
+            due = Clock::now();
+        }
+        client.sent(i, due);
+        FIX::Session::sendToTarget(msg, ids[i % ids.size()]);
+    }
+    const auto sent = Clock::now();
+    waitFor(opts.timeout, [&] { return client.answered() == opts.orders; });
+
+    initiator.stop();
+
+    const auto &latency = client.latency();
+    const auto answered = client.answered();
+    const double elapsed =
+        answered == 0 ? 0
+                      : static_cast<double>(client.lastReply() -
+                                            start.time_since_epoch().count()) /
+                            1e9;
+    auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1e3; };
+    nlohmann::json json{
+        {"name", name},
+        {"sessions", ids.size()},
+        {"orders", opts.orders},
+        {"rate", opts.rate},
+        {"answered", answered},
+        {"replies", client.replies()},
+        {"send_seconds",
+         std::chrono::duration<double>(sent - start).count()},
+        {"elapsed_seconds", elapsed},
+        {"orders_per_second", elapsed > 0 ? answered / elapsed : 0},
+        {"latency_us",
+         {{"min", us(latency.min())},
+          {"p50", us(latency.percentile(0.5))},
+          {"p90", us(latency.percentile(0.9))},
+          {"p99", us(latency.percentile(0.99))},
+          {"p999", us(latency.percentile(0.999))},
+          {"max", us(latency.max())},
+          {"mean", latency.mean() / 1e3}}},
+    };
+    if (answered != opts.orders)
+        SPDLOG_ERROR("{}: {} of {} orders answered", name, answered,
+                     opts.orders);
+    return json;
+}
+
+nlohmann::json run(const Options &opts, const std::string &path,
+                   const std::string &transport) {
+    auto [cfg, error] = yaml_cpp_struct::from_yaml<Config>(path);
+    if (!cfg)
+        throw std::runtime_error(error);
+    echoClOrdID(cfg.value());
+
+    FIX::SessionSettings settings(cfg.value().fix_ini);
+    auto io_context = std::make_shared<asio::io_context>();
+    // Sequence numbers start from 1 and nothing touches the disk, so the
+    // numbers are those of the reply path alone.
+    FIX::MemoryStoreFactory store_factory;
+    NullLogFactory log_factory;
+    IoPool app_pool("app", std::nullopt, io_context);
+    const auto threads =
+        cfg.value().topology ? cfg.value().topology->fix : std::nullopt;
+    nlohmann::json json;
+    if (transport.empty()) {
+        ::Application application(io_context, cfg.value());
+        AsioAcceptor acceptor(application, store_factory, settings,
+                              log_factory, threads);
+        application.setAcceptor(&acceptor);
+        app_pool.start();
+        acceptor.start();
+        json = measure(opts, "e2e/" + path, settings);
+        acceptor.stop();
+        app_pool.stop();
+        application.stopHttpServer();
+        return json;
+    }
+    Echo echo(*io_context);
+    const auto name = "e2e/" + transport + "/" + path;
+    if (transport == "socket") {
+        FIX::SocketAcceptor acceptor(echo, store_factory, settings,
+                                     log_factory);
+        app_pool.start();
+        acceptor.start();
+        json = measure(opts, name, settings);
+        acceptor.stop();
+    } else if (transport == "asio") {
+        AsioAcceptor acceptor(echo, store_factory, settings, log_factory,
+                              threads);
+        echo.setAcceptor(&acceptor);
+        app_pool.start();
+        acceptor.start();
+        json = measure(opts, name, settings);
+        acceptor.stop();
+    } else {
+        throw std::invalid_argument("unknown transport: " + transport);
+    }
+    app_pool.stop();
+    return json;
+}
+
+Options parse(int argc, char **argv) {
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (++i == argc)
+                throw std::invalid_argument(std::string(arg) +
+                                            " needs a value");
+            return argv[i];
+        };
+        if (arg == "--orders")
+            opts.orders = std::stoull(value());
+        else if (arg == "--rate")
+            opts.rate = std::stoull(value());
+        else if (arg == "--timeout")
+            opts.timeout = std::chrono::seconds(std::stoll(value()));
+        else if (arg == "--symbol")
+            opts.symbol = value();
+        else if (arg == "--ord-type")
+            opts.ord_type = value();
+        else if (arg == "--transport") {
+            const auto list = value();
+            for (const auto part : std::views::split(list, ','))
+                opts.transports.emplace_back(part.begin(), part.end());
+        } else if (arg == "--out")
+            opts.out = value();
+        else
+            opts.configs.emplace_back(arg);
+    }
+    if (opts.configs.empty())
+        opts.configs = {"cfg/cfg_1.yaml", "cfg/cfg_2.yaml"};
+    return opts;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    try {
+        spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e][thread %t][%s:%#][%l] %v");
+        spdlog::set_level(spdlog::level::warn);
+        const auto opts = parse(argc, argv);
+        // Laid out like google benchmark's json so the same tooling can
+        // track both.
+        nlohmann::json json{
+            {"context",
+             {{"date", getTzDateTime()},
+              {"num_cpus", std::thread::hardware_concurrency()},
+              {"fix_checksum", FixEncoder::checksumImpl()}}},
+            {"benchmarks", nlohmann::json::array()},
+        };
+        std::vector<std::string> transports = opts.transports;
+        if (transports.empty())
+            transports.emplace_back();
+        for (const auto &path : opts.configs) {
+            for (const auto &transport : transports) {
+                auto result = run(opts, path, transport);
+                std::cerr << std::format(
+                    "{}: {:.0f} orders/s, p50 {:.1f} us, p99 {:.1f} us\n",
+                    result["name"].get<std::string>(),
+                    result["orders_per_second"].get<double>(),
+                    result["latency_us"]["p50"].get<double>(),
+                    result["latency_us"]["p99"].get<double>());
+                json["benchmarks"].push_back(std::move(result));
+            }
+        }
+        if (opts.out.empty()) {
+            std::cout << json.dump(2) << std::endl;
+        } else {
+            std::ofstream out(opts.out);
+            out << json.dump(2) << std::endl;
+            if (!out)
+                throw std::runtime_error("write: " + opts.out);
+        }
+        return 0;
+    } catch (const std::exception &e) {
+        SPDLOG_ERROR("{}", e.what());
+        return 1;
+    }
+}
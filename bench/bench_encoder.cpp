@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <string>
+
+#include <quickfix/FixFieldNumbers.h>
+#include <quickfix/Message.h>
+#include <quickfix/fix42/ExecutionReport.h>
+
+#include <benchmark/benchmark.h>
+
+#include "fix_encoder.h"
+
+namespace {
+
+std::string payload(int64_t size) {
+    std::string data(size, '\0');
+    for (int64_t i = 0; i < size; ++i)
+        data[i] = static_cast<char>('0' + i % 75);
+    return data;
+}
+
+// An ExecutionReport padded with free-text fields until the body reaches
+// roughly the requested size.
+FIX42::ExecutionReport report(int64_t size) {
+    FIX42::ExecutionReport msg;
+    auto &hdr = msg.getHeader();
+    hdr.setField(FIX::FIELD::BeginString, "FIX.4.2");
+    hdr.setField(FIX::FIELD::SenderCompID, "FIXSIM");
+    hdr.setField(FIX::FIELD::TargetCompID, "CLIENT");
+    hdr.setField(FIX::FIELD::MsgSeqNum, "12345");
+    hdr.setField(FIX::FIELD::SendingTime, "20250101-09:30:00.123");
+    msg.setField(FIX::FIELD::OrderID, "fixsim.20250101.093000.1");
+    msg.setField(FIX::FIELD::ExecID, "4f1c2a9e.7d2b.4f4e.9a51.0c3b9d7f2e11");
+    msg.setField(FIX::FIELD::ExecTransType, "0");
+    msg.setField(FIX::FIELD::ExecType, "2");
+    msg.setField(FIX::FIELD::OrdStatus, "2");
+    msg.setField(FIX::FIELD::Symbol, "USDJPY");
+    msg.setField(FIX::FIELD::Side, "1");
+    msg.setField(FIX::FIELD::LeavesQty, "0");
+    msg.setField(FIX::FIELD::CumQty, "100");
+    msg.setField(FIX::FIELD::AvgPx, "151.235");
+    msg.setField(FIX::FIELD::TransactTime, "20250101-09:30:00.123");
+    // Measured with FixEncoder so QuickFIX's cached field metrics stay cold.
+    FixEncoder encoder;
+    const int64_t base = static_cast<int64_t>(encoder.encode(msg).size());
+    if (size > base)
+        msg.setField(FIX::FIELD::Text, payload(size - base));
+    return msg;
+}
+
+void BM_ChecksumScalar(benchmark::State &state) {
+    const auto data = payload(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(FixEncoder::checksumScalar(data));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ChecksumScalar)->RangeMultiplier(4)->Range(64, 16 << 10);
+
+void BM_ChecksumDispatched(benchmark::State &state) {
+    const auto data = payload(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(FixEncoder::checksum(data));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+    state.SetLabel(std::string(FixEncoder::checksumImpl()));
+}
+BENCHMARK(BM_ChecksumDispatched)->RangeMultiplier(4)->Range(64, 16 << 10);
+
+// Fresh field objects every iteration, as each outbound message is built
+// from scratch on the send paths.
+void BM_QuickFixToString(benchmark::State &state) {
+    const auto base = report(state.range(0));
+    std::string out;
+    for (auto _ : state) {
+        state.PauseTiming();
+        FIX::Message msg(base);
+        state.ResumeTiming();
+        msg.toString(out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * out.size());
+}
+BENCHMARK(BM_QuickFixToString)->RangeMultiplier(4)->Range(256, 16 << 10);
+
+void BM_FixEncoderEncode(benchmark::State &state) {
+    const auto base = report(state.range(0));
+    FixEncoder encoder;
+    size_t size = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        FIX::Message msg(base);
+        state.ResumeTiming();
+        const auto &out = encoder.encode(msg);
+        size = out.size();
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_FixEncoderEncode)->RangeMultiplier(4)->Range(256, 16 << 10);
+
+void BM_FixEncoderFrame(benchmark::State &state) {
+    const auto body = payload(state.range(0));
+    const std::string header =
+        "35=8\x01"
+        "34=12345\x01"
+        "49=FIXSIM\x01"
+        "52=20250101-09:30:00.123\x01"
+        "56=CLIENT\x01";
+    std::string out;
+    for (auto _ : state) {
+        FixEncoder::frame(out, "FIX.4.2", header, body);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * out.size());
+}
+BENCHMARK(BM_FixEncoderFrame)->RangeMultiplier(4)->Range(256, 16 << 10);
+
+}  // namespace
+
+BENCHMARK_MAIN();
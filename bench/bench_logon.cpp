@@ -0,0 +1,323 @@
+#include <sys/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <quickfix/Application.h>
+#include <quickfix/FixFieldNumbers.h>
+#include <quickfix/Log.h>
+#include <quickfix/MessageStore.h>
+#include <quickfix/Session.h>
+#include <quickfix/SessionSettings.h>
+#include <quickfix/SocketInitiator.h>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include "application.h"
+#include "asio_acceptor.h"
+#include "builtin.h"
+#include "histogram.h"
+#include "io_pool.h"
+
+// Logs --sessions initiators on to fixsim at once over loopback, the way
+// every client reconnects at the open, and measures how long the storm
+// takes and the time from each logon to the first message after it.
+// The config supplies logon_response, trading_session_status and header;
+// its fix_ini is replaced by the generated sessions.
+//
+// bench_logon [--sessions N] [--port P] [--messages N] [--timeout S]
+//             [--out file.json] [cfg.yaml]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    uint32_t sessions{1000};
+    uint16_t port{20309};
+    // Application messages each session waits for; defaults to the logon
+    // response plus every trading_session_status step.
+    std::optional<uint32_t> messages;
+    std::chrono::seconds timeout{60};
+    std::string out;
+    std::string config{"cfg/cfg_1.yaml"};
+};
+
+class NullLogFactory : public FIX::LogFactory {
+public:
+    FIX::Log *create() override { return new FIX::NullLog; }
+    FIX::Log *create(const FIX::SessionID &) override {
+        return new FIX::NullLog;
+    }
+    void destroy(FIX::Log *log) override { delete log; }
+};
+
+class Client : public FIX::Application {
+public:
+    Client(const std::vector<FIX::SessionID> &ids, uint32_t messages)
+        : m_logon(new std::atomic<int64_t>[ids.size()]),
+          m_received(new std::atomic<uint32_t>[ids.size()]),
+          m_messages(messages) {
+        for (size_t i = 0; i < ids.size(); ++i) {
+            m_index.emplace(ids[i].toString(), i);
+            m_logon[i].store(0, std::memory_order::relaxed);
+            m_received[i].store(0, std::memory_order::relaxed);
+        }
+    }
+
+    void onCreate(const FIX::SessionID &) override {}
+    void onLogon(const FIX::SessionID &id) override {
+        const auto now = Clock::now().time_since_epoch().count();
+        m_logon[m_index.at(id.toString())].store(now,
+                                                 std::memory_order::release);
+        m_last_logon.store(now, std::memory_order::relaxed);
+        ++m_logged_on;
+    }
+    void onLogout(const FIX::SessionID &) override { --m_logged_on; }
+    void toAdmin(FIX::Message &, const FIX::SessionID &) override {}
+    void toApp(FIX::Message &, const FIX::SessionID &) override {}
+    void fromAdmin(const FIX::Message &, const FIX::SessionID &) override {}
+    void fromApp(const FIX::Message &, const FIX::SessionID &id) override {
+        const auto now = Clock::now().time_since_epoch().count();
+        const auto i = m_index.at(id.toString());
+        const auto received =
+            m_received[i].fetch_add(1, std::memory_order::relaxed) + 1;
+        if (received == 1)
+            m_first.record(now - m_logon[i].load(std::memory_order::acquire));
+        if (received == m_messages)
+            m_done.fetch_add(1, std::memory_order::release);
+    }
+
+    int loggedOn() const { return m_logged_on.load(); }
+    int64_t lastLogon() const { return m_last_logon.load(); }
+    // Sessions that got every message they wait for.
+    uint32_t done() const { return m_done.load(std::memory_order::acquire); }
+    // Only read once the initiator has stopped.
+    const Histogram &firstMessage() const { return m_first; }
+
+private:
+    // Built before the initiator starts, read-only afterwards.
+    std::unordered_map<std::string, size_t> m_index;
+    std::unique_ptr<std::atomic<int64_t>[]> m_logon;
+    std::unique_ptr<std::atomic<uint32_t>[]> m_received;
+    uint32_t m_messages;
+    std::atomic<int> m_logged_on{0};
+    std::atomic<int64_t> m_last_logon{0};
+    std::atomic<uint32_t> m_done{0};
+    Histogram m_first;
+};
+
+FIX::SessionSettings acceptorSettings(const Options &opts) {
+    FIX::SessionSettings settings;
+    FIX::Dictionary defaults;
+    defaults.setString(FIX::CONNECTION_TYPE, "acceptor");
+    defaults.setInt(FIX::SOCKET_ACCEPT_PORT, opts.port);
+    defaults.setBool(FIX::SOCKET_REUSE_ADDRESS, true);
+    defaults.setString(FIX::START_TIME, "00:00:00");
+    defaults.setString(FIX::END_TIME, "00:00:00");
+    defaults.setBool(FIX::USE_DATA_DICTIONARY, false);
+    settings.set(defaults);
+    for (uint32_t i = 0; i < opts.sessions; ++i)
+        settings.set(FIX::SessionID("FIX.4.2", "FIXSIM",
+                                    "STORM" + std::to_string(i)),
+                     FIX::Dictionary());
+    return settings;
+}
+
+// One initiator session per acceptor session, with the comp ids swapped.
+FIX::SessionSettings initiatorSettings(const Options &opts,
+                                       const FIX::SessionSettings &acceptor) {
+    FIX::SessionSettings settings;
+    FIX::Dictionary defaults;
+    defaults.setString(FIX::CONNECTION_TYPE, "initiator");
+    defaults.setString(FIX::SOCKET_CONNECT_HOST, "127.0.0.1");
+    defaults.setInt(FIX::SOCKET_CONNECT_PORT, opts.port);
+    defaults.setString(FIX::START_TIME, "00:00:00");
+    defaults.setString(FIX::END_TIME, "00:00:00");
+    defaults.setInt(FIX::HEARTBTINT, 30);
+    defaults.setInt(FIX::RECONNECT_INTERVAL, 1);
+    defaults.setBool(FIX::RESET_ON_LOGON, true);
+    defaults.setBool(FIX::USE_DATA_DICTIONARY, false);
+    defaults.setBool(FIX::SOCKET_NODELAY, true);
+    settings.set(defaults);
+    for (const auto &id : acceptor.getSessions())
+        settings.set(FIX::SessionID(id.getBeginString(), id.getTargetCompID(),
+                                    id.getSenderCompID()),
+                     FIX::Dictionary());
+    return settings;
+}
+
+// Two sockets per session live in this one process.
+void raiseFileLimit() {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0 ||
+        limit.rlim_cur == limit.rlim_max)
+        return;
+    limit.rlim_cur = limit.rlim_max;
+    if (setrlimit(RLIMIT_NOFILE, &limit) != 0)
+        SPDLOG_WARN("cannot raise the open file limit");
+}
+
+template <typename Pred>
+bool waitFor(std::chrono::seconds timeout, Pred &&pred) {
+    const auto deadline = Clock::now() + timeout;
+    while (!pred()) {
+        if (Clock::now() > deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+nlohmann::json latencyJson(const Histogram &latency) {
+    auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1e3; };
+    return {
+        {"min", us(latency.min())},
+        {"p50", us(latency.percentile(0.5))},
+        {"p90", us(latency.percentile(0.9))},
+        {"p99", us(latency.percentile(0.99))},
+        {"p999", us(latency.percentile(0.999))},
+        {"max", us(latency.max())},
+        {"mean", latency.mean() / 1e3},
+    };
+}
+
+nlohmann::json run(const Options &opts) {
+    auto [cfg, error] = yaml_cpp_struct::from_yaml<Config>(opts.config);
+    if (!cfg)
+        throw std::runtime_error(error);
+    const auto messages = opts.messages.value_or(
+        (cfg.value().logon_response ? 1 : 0) +
+        cfg.value().trading_session_status.size());
+    if (messages == 0)
+        throw std::invalid_argument(
+            opts.config + ": no logon_response or trading_session_status");
+
+    auto settings = acceptorSettings(opts);
+    auto io_context = std::make_shared<asio::io_context>();
+    ::Application application(io_context, cfg.value());
+    FIX::MemoryStoreFactory store_factory;
+    NullLogFactory log_factory;
+    auto acceptor = std::make_unique<AsioAcceptor>(
+        application, store_factory, settings, log_factory,
+        cfg.value().topology ? cfg.value().topology->fix : std::nullopt);
+    application.setAcceptor(acceptor.get());
+    IoPool app_pool("app", std::nullopt, io_context);
+    app_pool.start();
+    acceptor->start();
+
+    auto client_settings = initiatorSettings(opts, settings);
+    std::vector<FIX::SessionID> ids;
+    for (const auto &id : client_settings.getSessions())
+        ids.push_back(id);
+    Client client(ids, static_cast<uint32_t>(messages));
+    FIX::MemoryStoreFactory client_store;
+    NullLogFactory client_log;
+    FIX::SocketInitiator initiator(client, client_store, client_settings,
+                                   client_log);
+    const auto start = Clock::now();
+    initiator.start();
+    const bool logged_on = waitFor(opts.timeout, [&] {
+        return client.loggedOn() == static_cast<int>(ids.size());
+    });
+    const double logon_seconds =
+        logged_on ? static_cast<double>(client.lastLogon() -
+                                        start.time_since_epoch().count()) /
+                        1e9
+                  : 0;
+    waitFor(opts.timeout, [&] { return client.done() == ids.size(); });
+
+    initiator.stop();
+    const auto server = acceptor->logonLatency();
+    acceptor->stop();
+    app_pool.stop();
+    application.stopHttpServer();
+
+    const auto done = client.done();
+    nlohmann::json json{
+        {"name", "logon/" + opts.config},
+        {"sessions", ids.size()},
+        {"messages_per_session", messages},
+        {"logged_on", client.loggedOn()},
+        {"completed", done},
+        {"logon_seconds", logon_seconds},
+        {"logons_per_second",
+         logon_seconds > 0 ? ids.size() / logon_seconds : 0},
+        {"first_message_us", latencyJson(client.firstMessage())},
+        {"server_first_message_us", latencyJson(server)},
+    };
+    if (!logged_on)
+        SPDLOG_ERROR("{} of {} sessions logged on", client.loggedOn(),
+                     ids.size());
+    if (done != ids.size())
+        SPDLOG_ERROR("{} of {} sessions got {} messages", done, ids.size(),
+                     messages);
+    return json;
+}
+
+Options parse(int argc, char **argv) {
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (++i == argc)
+                throw std::invalid_argument(std::string(arg) +
+                                            " needs a value");
+            return argv[i];
+        };
+        if (arg == "--sessions")
+            opts.sessions = std::stoul(value());
+        else if (arg == "--port")
+            opts.port = static_cast<uint16_t>(std::stoul(value()));
+        else if (arg == "--messages")
+            opts.messages = std::stoul(value());
+        else if (arg == "--timeout")
+            opts.timeout = std::chrono::seconds(std::stoll(value()));
+        else if (arg == "--out")
+            opts.out = value();
+        else
+            opts.config = arg;
+    }
+    return opts;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    try {
+        spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e][thread %t][%s:%#][%l] %v");
+        spdlog::set_level(spdlog::level::warn);
+        const auto opts = parse(argc, argv);
+        raiseFileLimit();
+        nlohmann::json json{
+            {"context",
+             {{"date", getTzDateTime()},
+              {"num_cpus", std::thread::hardware_concurrency()}}},
+            {"benchmarks", nlohmann::json::array({run(opts)})},
+        };
+        if (opts.out.empty()) {
+            std::cout << json.dump(2) << std::endl;
+        } else {
+            std::ofstream out(opts.out);
+            out << json.dump(2) << std::endl;
+            if (!out)
+                throw std::runtime_error("write: " + opts.out);
+        }
+        return 0;
+    } catch (const std::exception &e) {
+        SPDLOG_ERROR("{}", e.what());
+        return 1;
+    }
+}
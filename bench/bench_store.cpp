@@ -0,0 +1,65 @@
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <quickfix/FileStore.h>
+#include <quickfix/MessageStore.h>
+#include <quickfix/SessionID.h>
+
+#include <benchmark/benchmark.h>
+
+#include "message_store.h"
+
+namespace {
+
+constexpr auto kPath = "bench_store";
+
+// What AsioAcceptor::send does per outbound message. items_per_second is
+// what the sender sees; persisted_per_second also counts destroy(), which
+// for Async waits until the writer has applied everything.
+void storeLoop(benchmark::State &state, FIX::MessageStoreFactory &factory) {
+    const FIX::SessionID id("FIX.4.2", "FIXSIM", "BENCH");
+    const std::string msg(state.range(0), 'x');
+    auto *store = factory.create(FIX::UtcTimeStamp::now(), id);
+    store->reset(FIX::UtcTimeStamp::now());
+    const auto start = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        store->set(store->getNextSenderMsgSeqNum(), msg);
+        store->incrNextSenderMsgSeqNum();
+    }
+    factory.destroy(store);
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+    state.counters["persisted_per_second"] =
+        static_cast<double>(state.iterations()) / elapsed.count();
+}
+
+void BM_FileStore(benchmark::State &state) {
+    FIX::FileStoreFactory factory(kPath);
+    storeLoop(state, factory);
+}
+BENCHMARK(BM_FileStore)->Arg(200)->Arg(1024);
+
+void BM_MemoryStore(benchmark::State &state) {
+    FIX::MemoryStoreFactory factory;
+    storeLoop(state, factory);
+}
+BENCHMARK(BM_MemoryStore)->Arg(200)->Arg(1024);
+
+void BM_MmapStore(benchmark::State &state) {
+    MmapStoreFactory factory(kPath, 64 << 20, std::chrono::milliseconds(100));
+    storeLoop(state, factory);
+}
+BENCHMARK(BM_MmapStore)->Arg(200)->Arg(1024);
+
+void BM_AsyncStore(benchmark::State &state) {
+    AsyncStoreFactory factory(kPath, 64 << 20, std::chrono::milliseconds(100));
+    storeLoop(state, factory);
+}
+BENCHMARK(BM_AsyncStore)->Arg(200)->Arg(1024);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,398 @@
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include <quickfix/FieldConvertors.h>
+#include <quickfix/FixFieldNumbers.h>
+#include <quickfix/Session.h>
+#include <quickfix/Values.h>
+
+#include <spdlog/spdlog.h>
+
+#include "load_client.h"
+
+namespace {
+
+// Live orders kept per session for cancels and replaces; the oldest are
+// forgotten beyond this, so a long run does not grow without bound.
+constexpr size_t kMaxLive = 1 << 16;
+
+constexpr std::string_view kKindNames[] = {"new", "cancel", "replace"};
+
+int64_t nanos(std::chrono::steady_clock::time_point at) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               at.time_since_epoch())
+        .count();
+}
+
+nlohmann::json latencyJson(const Histogram &h) {
+    auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1e3; };
+    return {{"count", h.count()},
+            {"min", us(h.min())},
+            {"p50", us(h.percentile(0.5))},
+            {"p90", us(h.percentile(0.9))},
+            {"p99", us(h.percentile(0.99))},
+            {"p999", us(h.percentile(0.999))},
+            {"max", us(h.max())},
+            {"mean", h.mean() / 1e3}};
+}
+
+}  // namespace
+
+LoadClient::LoadClient(const ClientConfig &cfg,
+                       const FIX::SessionSettings &settings)
+    : m_cfg(cfg),
+      m_price(std::format("{}", cfg.price.value_or(100))),
+      m_quantity(std::to_string(cfg.quantity.value_or(100))) {
+    if (m_cfg.symbols.empty())
+        throw std::invalid_argument("symbols is empty");
+    if (m_cfg.rate == 0)
+        throw std::invalid_argument("rate must be positive");
+    const auto mix = m_cfg.mix.value_or(ClientMix{100, 0, 0});
+    if (mix.new_order == 0)
+        throw std::invalid_argument("mix.new_order must be positive");
+    // Distinct per run, so a fixsim with check_cl_order_id set never sees
+    // a ClOrdID twice.
+    const auto run_id = std::chrono::duration_cast<std::chrono::seconds>(
+                            std::chrono::system_clock::now().time_since_epoch())
+                            .count();
+    for (const auto &id : settings.getSessions()) {
+        auto &session = m_sessions.emplace_back(std::make_unique<Session>());
+        session->id = id;
+        session->prefix = std::format("{}.{}.", run_id, m_sessions.size());
+        session->mix = std::discrete_distribution<int>(
+            {double(mix.new_order), double(mix.cancel), double(mix.replace)});
+        m_by_id.emplace(id, session.get());
+    }
+    if (m_sessions.empty())
+        throw std::invalid_argument(m_cfg.fix_ini + ": no session");
+}
+
+void LoadClient::onCreate(const FIX::SessionID &id) {
+    SPDLOG_INFO("onCreate: [{}]", id.toString());
+}
+
+void LoadClient::onLogon(const FIX::SessionID &id) {
+    SPDLOG_INFO("onLogon: [{}]", id.toString());
+    if (auto it = m_by_id.find(id); it != m_by_id.end())
+        it->second->logged_on.store(true);
+}
+
+void LoadClient::onLogout(const FIX::SessionID &id) {
+    SPDLOG_INFO("onLogout: [{}]", id.toString());
+    if (auto it = m_by_id.find(id); it != m_by_id.end())
+        it->second->logged_on.store(false);
+}
+
+void LoadClient::fromApp(const FIX::Message &msg, const FIX::SessionID &id) {
+    const auto now = nanos(Clock::now());
+    try {
+        auto it = m_by_id.find(id);
+        if (it == m_by_id.end())
+            return;
+        const auto &type = msg.getHeader().getField(FIX::FIELD::MsgType);
+        if (type == FIX::MsgType_ExecutionReport)
+            onExecutionReport(*it->second, msg, now);
+        else if (type == FIX::MsgType_OrderCancelReject)
+            onCancelReject(*it->second, msg, now);
+    } catch (const std::exception &e) {
+        SPDLOG_ERROR("{}", e.what());
+    }
+}
+
+nlohmann::json LoadClient::run() {
+    auto all_logged_on = [&] {
+        return std::ranges::all_of(m_sessions, [](const auto &session) {
+            return session->logged_on.load();
+        });
+    };
+    for (int i = 0; i < 300 && !all_logged_on(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (!all_logged_on())
+        SPDLOG_WARN("not every session logged on, sending on the others");
+
+    const auto threads = std::clamp<uint32_t>(m_cfg.sender_threads.value_or(1),
+                                              1, m_sessions.size());
+    const auto start = Clock::now() + std::chrono::milliseconds(10);
+    const auto end = start + std::chrono::seconds(m_cfg.duration);
+    std::vector<std::thread> senders;
+    for (uint32_t t = 0; t < threads; ++t)
+        senders.emplace_back([=, this] { sendLoop(t, threads, start, end); });
+
+    uint64_t last_sent = 0;
+    uint64_t last_answered = 0;
+    while (Clock::now() < end) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        const auto sent = m_sent_total.load();
+        const auto answered = m_answered_total.load();
+        SPDLOG_INFO("sent {}/s, answered {}/s, outstanding {}",
+                    sent - last_sent, answered - last_answered,
+                    sent - answered);
+        last_sent = sent;
+        last_answered = answered;
+    }
+    for (auto &sender : senders)
+        sender.join();
+
+    const auto deadline =
+        Clock::now() + std::chrono::seconds(m_cfg.drain.value_or(5));
+    while (m_answered_total.load() < m_sent_total.load() &&
+           Clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return report(std::chrono::duration<double>(end - start).count());
+}
+
+// Thread t owns sessions t, t + threads, ... and sends requests
+// t, t + threads, ... of the global schedule, each on the next of its
+// sessions. Latency is taken from when a request was due, not from when
+// it went out, so a sender that falls behind shows up in the numbers.
+void LoadClient::sendLoop(uint32_t thread, uint32_t threads,
+                          Clock::time_point start, Clock::time_point end) {
+    std::vector<Session *> sessions;
+    for (size_t i = thread; i < m_sessions.size(); i += threads)
+        sessions.push_back(m_sessions[i].get());
+    const auto gap = std::chrono::duration_cast<Clock::duration>(
+                         std::chrono::seconds(1)) /
+                     m_cfg.rate;
+    size_t next_session = 0;
+    for (uint64_t i = thread;; i += threads) {
+        const auto due = start + gap * i;
+        if (due >= end)
+            break;
+        if (due - Clock::now() > std::chrono::microseconds(100))
+            std::this_thread::sleep_until(due);
+        while (Clock::now() < due)
+            ;
+        auto &session = *sessions[next_session++ % sessions.size()];
+        if (!session.logged_on.load(std::memory_order::relaxed))
+            continue;
+        sendOne(session, due);
+    }
+}
+
+void LoadClient::sendOne(Session &session, Clock::time_point due) {
+    uint64_t n;
+    Request req{.due = nanos(due), .kind = New};
+    {
+        std::lock_guard lk(session.mutex);
+        req.kind = static_cast<Kind>(session.mix(session.gen));
+        if (req.kind != New) {
+            if (auto orig = takeLive(session)) {
+                const auto &live = session.requests.at(orig.value());
+                req.orig = orig.value();
+                req.symbol = live.symbol;
+                req.side = live.side;
+            } else {
+                req.kind = New;
+            }
+        }
+        if (req.kind == New) {
+            req.symbol = session.gen() % m_cfg.symbols.size();
+            req.side = session.gen() % 2 ? FIX::Side_BUY : FIX::Side_SELL;
+        }
+        n = ++session.next;
+        session.requests.emplace(n, req);
+        ++session.stats.sent[req.kind];
+    }
+    auto msg = build(session, n, req);
+    m_sent_total.fetch_add(1, std::memory_order::relaxed);
+    try {
+        FIX::Session::sendToTarget(msg, session.id);
+    } catch (const std::exception &e) {
+        SPDLOG_ERROR("{}: {}", session.id.toString(), e.what());
+    }
+}
+
+FIX::Message LoadClient::build(const Session &session, uint64_t n,
+                               const Request &req) {
+    static constexpr const char *kMsgTypes[] = {
+        FIX::MsgType_NewOrderSingle, FIX::MsgType_OrderCancelRequest,
+        FIX::MsgType_OrderCancelReplaceRequest};
+    FIX::Message msg;
+    msg.getHeader().setField(FIX::FIELD::MsgType, kMsgTypes[req.kind]);
+    msg.setField(FIX::FIELD::ClOrdID, session.prefix + std::to_string(n));
+    if (req.kind != New)
+        msg.setField(FIX::FIELD::OrigClOrdID,
+                     session.prefix + std::to_string(req.orig));
+    msg.setField(FIX::FIELD::Symbol, m_cfg.symbols[req.symbol]);
+    msg.setField(FIX::FIELD::Side, std::string(1, req.side));
+    msg.setField(FIX::FIELD::TransactTime,
+                 FIX::UtcTimeStampConvertor::convert(FIX::UtcTimeStamp::now(),
+                                                     3));
+    msg.setField(FIX::FIELD::OrderQty, m_quantity);
+    if (req.kind == Cancel)
+        return msg;
+    const auto ord_type = m_cfg.ord_type.value_or("2");
+    msg.setField(FIX::FIELD::HandlInst, "1");
+    msg.setField(FIX::FIELD::OrdType, ord_type);
+    if (ord_type != "1")
+        msg.setField(FIX::FIELD::Price, m_price);
+    return msg;
+}
+
+std::optional<uint64_t> LoadClient::parseClOrdID(
+    const Session &session, const FIX::Message &msg) const {
+    for (const auto tag : {FIX::FIELD::ClOrdID, FIX::FIELD::OrderID}) {
+        if (!msg.isSetField(tag))
+            continue;
+        std::string_view value = msg.getField(tag);
+        if (!value.starts_with(session.prefix))
+            continue;
+        value.remove_prefix(session.prefix.size());
+        uint64_t n = 0;
+        auto [ptr, ec] =
+            std::from_chars(value.data(), value.data() + value.size(), n);
+        if (ec == std::errc{} && ptr == value.data() + value.size())
+            return n;
+    }
+    return std::nullopt;
+}
+
+void LoadClient::onExecutionReport(Session &session, const FIX::Message &msg,
+                                   int64_t now) {
+    const auto n = parseClOrdID(session, msg);
+    const char status =
+        msg.isSetField(FIX::FIELD::OrdStatus)
+            ? msg.getField(FIX::FIELD::OrdStatus)[0]
+            : msg.getField(FIX::FIELD::ExecType)[0];
+    std::lock_guard lk(session.mutex);
+    auto it = n ? session.requests.find(n.value()) : session.requests.end();
+    if (it == session.requests.end()) {
+        ++session.stats.unmatched;
+        return;
+    }
+    auto &req = it->second;
+    answer(session, req, now);
+    switch (status) {
+        case FIX::OrdStatus_REJECTED:
+            ++session.stats.rejects;
+            if (req.kind != New)
+                addLive(session, req.orig);
+            session.requests.erase(it);
+            break;
+        case FIX::OrdStatus_CANCELED:
+            if (req.kind == Cancel)
+                session.requests.erase(req.orig);
+            session.requests.erase(it);
+            break;
+        case FIX::OrdStatus_REPLACED:
+            if (req.kind == Replace)
+                session.requests.erase(req.orig);
+            addLive(session, n.value());
+            break;
+        case FIX::OrdStatus_PARTIALLY_FILLED:
+            ++session.stats.partial_fills;
+            break;
+        case FIX::OrdStatus_FILLED:
+            ++session.stats.fills;
+            session.stats.fill.record(now - req.due);
+            if (req.kind == Replace)
+                session.requests.erase(req.orig);
+            session.requests.erase(it);
+            break;
+        default:
+            if (req.kind != Cancel && !req.live)
+                addLive(session, n.value());
+            break;
+    }
+}
+
+void LoadClient::onCancelReject(Session &session, const FIX::Message &msg,
+                                int64_t now) {
+    const auto n = parseClOrdID(session, msg);
+    std::lock_guard lk(session.mutex);
+    auto it = n ? session.requests.find(n.value()) : session.requests.end();
+    if (it == session.requests.end()) {
+        ++session.stats.unmatched;
+        return;
+    }
+    answer(session, it->second, now);
+    ++session.stats.rejects;
+    const auto orig = it->second.orig;
+    session.requests.erase(it);
+    addLive(session, orig);
+}
+
+void LoadClient::answer(Session &session, Request &req, int64_t now) {
+    if (req.answered)
+        return;
+    req.answered = true;
+    ++session.stats.answered[req.kind];
+    session.stats.latency[req.kind].record(now - req.due);
+    m_answered_total.fetch_add(1, std::memory_order::relaxed);
+}
+
+void LoadClient::addLive(Session &session, uint64_t n) {
+    auto it = session.requests.find(n);
+    if (it == session.requests.end() || it->second.live)
+        return;
+    it->second.live = true;
+    session.live.push_back(n);
+    while (session.live.size() > kMaxLive) {
+        auto old = session.requests.find(session.live.front());
+        if (old != session.requests.end() && old->second.live)
+            session.requests.erase(old);
+        session.live.pop_front();
+    }
+}
+
+// Removes and returns a random live order; entries that were filled,
+// cancelled or replaced in the meantime are dropped on the way.
+std::optional<uint64_t> LoadClient::takeLive(Session &session) {
+    while (!session.live.empty()) {
+        const auto i = session.gen() % session.live.size();
+        const auto n = session.live[i];
+        session.live[i] = session.live.back();
+        session.live.pop_back();
+        auto it = session.requests.find(n);
+        if (it != session.requests.end() && it->second.live) {
+            it->second.live = false;
+            return n;
+        }
+    }
+    return std::nullopt;
+}
+
+nlohmann::json LoadClient::report(double seconds) {
+    Stats total;
+    for (auto &session : m_sessions) {
+        std::lock_guard lk(session->mutex);
+        const auto &stats = session->stats;
+        for (int k = 0; k < KindCount; ++k) {
+            total.sent[k] += stats.sent[k];
+            total.answered[k] += stats.answered[k];
+            total.latency[k].merge(stats.latency[k]);
+        }
+        total.fills += stats.fills;
+        total.partial_fills += stats.partial_fills;
+        total.rejects += stats.rejects;
+        total.unmatched += stats.unmatched;
+        total.fill.merge(stats.fill);
+    }
+    const auto sent = m_sent_total.load();
+    const auto answered = m_answered_total.load();
+    nlohmann::json json{
+        {"sessions", m_sessions.size()},
+        {"rate", m_cfg.rate},
+        {"seconds", seconds},
+        {"sent_per_second", sent / seconds},
+        {"answered_per_second", answered / seconds},
+        {"outstanding", sent - answered},
+        {"fills", total.fills},
+        {"partial_fills", total.partial_fills},
+        {"rejects", total.rejects},
+        {"unmatched", total.unmatched},
+    };
+    for (int k = 0; k < KindCount; ++k) {
+        const std::string name(kKindNames[k]);
+        json["sent"][name] = total.sent[k];
+        json["answered"][name] = total.answered[k];
+        json["latency_us"][name] = latencyJson(total.latency[k]);
+    }
+    json["latency_us"]["fill"] = latencyJson(total.fill);
+    return json;
+}
@@ -0,0 +1,145 @@
+#ifndef _LOAD_CLIENT_H_
+#define _LOAD_CLIENT_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <quickfix/Application.h>
+#include <quickfix/Message.h>
+#include <quickfix/SessionID.h>
+#include <quickfix/SessionSettings.h>
+
+#include <nlohmann/json.hpp>
+#include <yaml_cpp_struct.hpp>
+
+#include "histogram.h"
+
+// Relative weights of the requests sent. Cancel and replace pick a random
+// acknowledged order of the same session and fall back to a new order
+// while there is none.
+struct ClientMix {
+    uint32_t new_order;
+    uint32_t cancel;
+    uint32_t replace;
+};
+YCS_ADD_STRUCT(ClientMix, new_order, cancel, replace)
+
+struct ClientConfig {
+    // Initiator settings; every [SESSION] is one concurrent session.
+    std::string fix_ini;
+    // Requests per second over all sessions.
+    uint64_t rate;
+    // Seconds of sending.
+    uint32_t duration;
+    // Seconds to wait for outstanding replies afterwards, default 5.
+    std::optional<uint32_t> drain;
+    // Sessions are split over this many sending threads, default 1.
+    std::optional<uint32_t> sender_threads;
+    std::optional<ClientMix> mix;
+    std::vector<std::string> symbols;
+    std::optional<std::string> ord_type;  // default "2" (limit)
+    std::optional<double> price;          // default 100
+    std::optional<uint32_t> quantity;     // default 100
+    // Report file; the report is printed either way.
+    std::optional<std::string> out;
+};
+YCS_ADD_STRUCT(ClientConfig, fix_ini, rate, duration, drain, sender_threads,
+               mix, symbols, ord_type, price, quantity, out)
+
+// Sends a paced mix of NewOrderSingle, OrderCancelRequest and
+// OrderCancelReplaceRequest over every configured session and follows each
+// request to its acknowledgement and fill.
+//
+// Replies are matched on ClOrdID (11), or OrderID (37) when the reply flow
+// copies ClOrdID there, so fixsim's reply flows have to echo one of them.
+class LoadClient : public FIX::Application {
+public:
+    enum Kind : uint8_t { New, Cancel, Replace, KindCount };
+
+    LoadClient(const ClientConfig &, const FIX::SessionSettings &);
+
+    void onCreate(const FIX::SessionID &) override;
+    void onLogon(const FIX::SessionID &) override;
+    void onLogout(const FIX::SessionID &) override;
+    void toAdmin(FIX::Message &, const FIX::SessionID &) override {}
+    void toApp(FIX::Message &, const FIX::SessionID &) override {}
+    void fromAdmin(const FIX::Message &, const FIX::SessionID &) override {}
+    void fromApp(const FIX::Message &, const FIX::SessionID &) override;
+
+    // Waits for every session to log on, sends for the configured duration,
+    // drains, and returns the report.
+    nlohmann::json run();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Request {
+        int64_t due;
+        Kind kind;
+        // ClOrdID number of the order a cancel or replace refers to.
+        uint64_t orig{0};
+        uint32_t symbol{0};
+        char side{'1'};
+        bool answered{false};
+        // An acknowledged order that may still be cancelled or replaced.
+        bool live{false};
+    };
+    struct Stats {
+        uint64_t sent[KindCount]{};
+        uint64_t answered[KindCount]{};
+        uint64_t fills{0};
+        uint64_t partial_fills{0};
+        uint64_t rejects{0};
+        uint64_t unmatched{0};
+        Histogram latency[KindCount];
+        Histogram fill;
+    };
+    struct Session {
+        FIX::SessionID id;
+        // "<run>.<session>.", followed by the request number.
+        std::string prefix;
+        std::atomic<bool> logged_on{false};
+        std::mutex mutex;
+        std::unordered_map<uint64_t, Request> requests;
+        std::deque<uint64_t> live;
+        uint64_t next{0};
+        std::mt19937_64 gen{std::random_device{}()};
+        std::discrete_distribution<int> mix;
+        Stats stats;
+    };
+
+    void sendLoop(uint32_t thread, uint32_t threads, Clock::time_point start,
+                  Clock::time_point end);
+    void sendOne(Session &, Clock::time_point due);
+    FIX::Message build(const Session &, uint64_t n, const Request &);
+    // Request number of a ClOrdID sent on this session.
+    std::optional<uint64_t> parseClOrdID(const Session &,
+                                         const FIX::Message &) const;
+    void onExecutionReport(Session &, const FIX::Message &, int64_t now);
+    void onCancelReject(Session &, const FIX::Message &, int64_t now);
+    void answer(Session &, Request &, int64_t now);
+    void addLive(Session &, uint64_t n);
+    std::optional<uint64_t> takeLive(Session &);
+    nlohmann::json report(double seconds);
+
+    ClientConfig m_cfg;
+    std::string m_price;
+    std::string m_quantity;
+    std::vector<std::unique_ptr<Session>> m_sessions;
+    // Built in the constructor, read-only afterwards.
+    std::map<FIX::SessionID, Session *> m_by_id;
+    std::atomic<uint64_t> m_sent_total{0};
+    std::atomic<uint64_t> m_answered_total{0};
+};
+
+#endif
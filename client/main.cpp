@@ -0,0 +1,71 @@
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include <quickfix/FileLog.h>
+#include <quickfix/Log.h>
+#include <quickfix/MessageStore.h>
+#include <quickfix/SessionSettings.h>
+#include <quickfix/ThreadedSocketInitiator.h>
+
+#include <spdlog/spdlog.h>
+
+#include "load_client.h"
+
+namespace {
+
+class NullLogFactory : public FIX::LogFactory {
+public:
+    FIX::Log *create() override { return new FIX::NullLog; }
+    FIX::Log *create(const FIX::SessionID &) override {
+        return new FIX::NullLog;
+    }
+    void destroy(FIX::Log *log) override { delete log; }
+};
+
+}  // namespace
+
+// fixsim-client <client.yaml>
+int main(int argc, char **argv) {
+    try {
+        spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e][thread %t][%s:%#][%l] %v");
+        if (argc < 2) {
+            SPDLOG_ERROR("usage: {} <client.yaml>", argv[0]);
+            return 1;
+        }
+        auto [cfg, error] = yaml_cpp_struct::from_yaml<ClientConfig>(argv[1]);
+        if (!cfg) {
+            SPDLOG_ERROR("{}", error);
+            return 1;
+        }
+        FIX::SessionSettings settings(cfg.value().fix_ini);
+        LoadClient client(cfg.value(), settings);
+        // Sequence numbers restart with every run (ResetOnLogon), and the
+        // message log is only written when FileLogPath asks for it.
+        FIX::MemoryStoreFactory store_factory;
+        std::unique_ptr<FIX::LogFactory> log_factory;
+        if (settings.get().has(FIX::FILE_LOG_PATH))
+            log_factory = std::make_unique<FIX::FileLogFactory>(settings);
+        else
+            log_factory = std::make_unique<NullLogFactory>();
+        FIX::ThreadedSocketInitiator initiator(client, store_factory, settings,
+                                               *log_factory);
+        initiator.start();
+        auto report = client.run();
+        initiator.stop();
+
+        std::cout << report.dump(2) << std::endl;
+        if (auto &out = cfg.value().out) {
+            std::ofstream file(out.value());
+            file << report.dump(2) << std::endl;
+            if (!file) {
+                SPDLOG_ERROR("write: {}", out.value());
+                return 1;
+            }
+        }
+        return 0;
+    } catch (const std::exception &e) {
+        SPDLOG_ERROR("{}", e.what());
+        return 1;
+    }
+}
@@ -5,13 +5,17 @@
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <map>
 #include <memory>
 #include <optional>
 #include <set>
+#include <span>
 #include <string>
-#include <thread>
+#include <string_view>
+#include <mutex>
 #include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <quickfix/Application.h>
@@ -23,17 +27,31 @@
 #include <quickfix/Values.h>
 
 #include <asio.hpp>
-#include <asio/thread_pool.hpp>
 #include <nlohmann/json.hpp>
 #include <yaml_cpp_struct.hpp>
 
-using FixFieldMap = std::unordered_map<int32_t, std::string>;
+#include "asio_acceptor.h"
+#include "field_template.h"
+#include "histogram.h"
+#include "http_server.h"
+#include "io_pool.h"
+#include "log_rotator.h"
+#include "market_data.h"
+#include "message_factory.h"
+#include "schema.h"
+#include "sharded_counter.h"
+#include "shm_metrics.h"
+#include "stress_scenario.h"
+#include "token_bucket.h"
 
 enum class MsgType : uint8_t {
     ExecutionReport,
     OrderCancelReject,
+    // FIX.4.2 and later.
+    BusinessMessageReject,
 };
-YCS_ADD_ENUM(MsgType, ExecutionReport, OrderCancelReject)
+YCS_ADD_ENUM(MsgType, ExecutionReport, OrderCancelReject,
+             BusinessMessageReject)
 
 enum class FixVersion : uint8_t {
     FIX40,
@@ -71,15 +89,35 @@ struct DefaultReplyData {
 };
 YCS_ADD_STRUCT(DefaultReplyData, common_fields, reply_flow)
 
+struct ThrottleConfig {
+    // Messages a second.
+    uint32_t rate;
+    // How many may arrive at once after a quiet spell. Defaults to rate.
+    std::optional<uint32_t> burst;
+    // Session ids or TargetCompIDs, each with a bucket of its own. Every
+    // session if absent.
+    std::optional<std::vector<std::string>> sessions;
+    // The MsgTypes counted. Every application message if absent.
+    std::optional<std::vector<std::string>> msg_types;
+    // Sent at once for a message over the limit, which gets no other reply.
+    MsgType msg_type;
+    FixFieldMap reply;
+};
+YCS_ADD_STRUCT(ThrottleConfig, rate, burst, sessions, msg_types, msg_type,
+               reply)
+
 struct Reply {
     FixFieldMap check_condition_header;
     FixFieldMap check_condition_body;
     FixFieldMap check_cl_order_id;
     DefaultReplyData default_reply_flow;
     std::vector<SymbolsReplyData> symbols_reply_flow;
+    // Limits the messages this rule matches, per session.
+    std::optional<ThrottleConfig> throttle;
 };
 YCS_ADD_STRUCT(Reply, check_condition_header, check_condition_body,
-               check_cl_order_id, default_reply_flow, symbols_reply_flow)
+               check_cl_order_id, default_reply_flow, symbols_reply_flow,
+               throttle)
 
 struct LogonResponse {
     std::string msgtype;
@@ -87,7 +125,79 @@ struct LogonResponse {
 };
 YCS_ADD_STRUCT(LogonResponse, msgtype, reply)
 
+enum class StoreType : uint8_t {
+    File,
+    Memory,
+    Mmap,
+    Async,
+};
+YCS_ADD_ENUM(StoreType, File, Memory, Mmap, Async)
+
+struct MessageStoreConfig {
+    StoreType type;
+    // Defaults to FileStorePath from fix_ini.
+    std::optional<std::string> path;
+    // Mmap: ring size per session in MB. Async: in-memory window in MB.
+    std::optional<uint32_t> capacity;
+    // Milliseconds between msync (Mmap) or file flushes (Async).
+    std::optional<int32_t> sync_interval;
+    // MB of recent application messages kept in memory per session to
+    // answer ResendRequests, whatever the type. Defaults to 64; 0 is off.
+    std::optional<uint32_t> resend_ring;
+};
+YCS_ADD_STRUCT(MessageStoreConfig, type, path, capacity, sync_interval,
+               resend_ring)
+
+YCS_ADD_ENUM(BackpressurePolicy, Pause, Drop, Disconnect)
+
+struct BackpressureConfig {
+    BackpressurePolicy policy;
+    // Bytes queued per session.
+    uint32_t high_watermark;
+    uint32_t low_watermark;
+};
+YCS_ADD_STRUCT(BackpressureConfig, policy, high_watermark, low_watermark)
+
+struct TopologyConfig {
+    // Order handling and reply timers. Their state is not locked, so this
+    // always runs on one thread; only cpus and busy_poll apply.
+    std::optional<ThreadConfig> app;
+    // Stress test and market data.
+    std::optional<ThreadConfig> worker;
+    // FIX sockets and sessions.
+    std::optional<ThreadConfig> fix;
+    // HTTP API; its threads run the connections, heavy requests hand
+    // their work to the worker pool.
+    std::optional<ThreadConfig> http;
+};
+YCS_ADD_STRUCT(TopologyConfig, app, worker, fix, http)
+
+struct DropCopyConfig {
+    // Session ids or TargetCompIDs that get a copy of every
+    // ExecutionReport sent to any other session.
+    std::vector<std::string> sessions;
+};
+YCS_ADD_STRUCT(DropCopyConfig, sessions)
+
+struct TraceConfig {
+    // Record tracepoints from the start; POST /trace switches them later.
+    bool enabled;
+    // Events kept, rounded up to a power of two. Defaults to 65536.
+    std::optional<uint32_t> capacity;
+};
+YCS_ADD_STRUCT(TraceConfig, enabled, capacity)
+
+struct MetricsConfig {
+    // The shared memory segment, /dev/shm/<name>. Defaults to "fixsim".
+    std::optional<std::string> name;
+    // How often it is rewritten, in milliseconds. Defaults to 100.
+    std::optional<uint32_t> interval;
+};
+YCS_ADD_STRUCT(MetricsConfig, name, interval)
+
 struct Config {
+    // The version compiled stress scenarios are built for. Replies follow
+    // each session's BeginString.
     FixVersion fix_version;
     std::string http_server_host;
     uint16_t http_server_port;
@@ -98,10 +208,23 @@ struct Config {
     std::optional<LogonResponse> logon_response;
     std::optional<FixFieldMap> header;
     std::vector<Reply> custom_reply;
+    std::optional<MessageStoreConfig> message_store;
+    std::optional<MessageLogConfig> message_log;
+    std::optional<MarketDataConfig> market_data;
+    std::optional<BackpressureConfig> backpressure;
+    std::optional<TopologyConfig> topology;
+    std::optional<DropCopyConfig> drop_copy;
+    std::optional<TraceConfig> trace;
+    std::optional<MetricsConfig> metrics;
+    // Limits every session's inbound application messages, before the
+    // rules are matched.
+    std::optional<std::vector<ThrottleConfig>> throttle;
 };
 YCS_ADD_STRUCT(Config, fix_version, http_server_host, http_server_port,
                interval, fix_ini, stress_interval, trading_session_status,
-               logon_response, header, custom_reply)
+               logon_response, header, custom_reply, message_store,
+               message_log, market_data, backpressure, topology, drop_copy,
+               trace, metrics, throttle)
 
 class Application : public FIX::Application {
 public:
@@ -116,35 +239,183 @@ public:
     void fromApp(const FIX::Message &, const FIX::SessionID &) override;
 
     void parseXml(const std::string &);
+    // Checks every reply template and condition against the dictionary
+    // loaded by parseXml. Returns one line per problem, empty if none.
+    std::vector<std::string> check();
+    // Parses a /stress csv and writes it in the compiled scenario format.
+    void compileScenario(const std::string &csv, const std::string &output,
+                         const std::string &create_time_func);
+    void setAcceptor(AsioAcceptor *);
+    // For the log backlog in the metrics. Must outlive the app thread.
+    void setLogRotator(const LogRotator *rotator) { m_log_rotator = rotator; }
     void startHttpServer();
     void stopHttpServer();
 
 private:
+    friend class ApplicationBench;
+
+    // First custom_reply rule whose header and body conditions hold.
+    // Throws if a condition names a field the message does not carry.
+    Reply *match(const FIX::Message &);
     void addTimedTask(const FIX::SessionID &, std::vector<ReplyData> &,
                       FixFieldMap &, const std::shared_ptr<FIX::Message> &);
-    std::shared_ptr<FIX::Message> createExecutionReport();
-    std::shared_ptr<FIX::Message> createOrderCancelReject();
-    std::shared_ptr<FIX::Message> createTradingSessionStatus();
+    // Throws if onCreate did not see the session.
+    const MessageFactory &factory(const FIX::SessionID &) const;
     void send(const FIX::SessionID &, const FixFieldMap &, const FixFieldMap &,
               const FIX::Message &, MsgType);
+    bool buildReply(OutboundMessage &, const MessageFactory &,
+                    const FixFieldMap &, const FixFieldMap &,
+                    const FIX::Message &, MsgType);
+    void encode(const FIX::Message &, OutboundMessage &);
+    void dispatch(const FIX::SessionID &, std::span<const OutboundMessage>);
+    void dispatch(const FIX::SessionID &, const StressScenario &,
+                  std::span<const std::string_view> bodies);
+    // Moves the replies due by now from m_timed into m_batches.
+    void collectDue(std::chrono::system_clock::time_point now);
     asio::awaitable<void> loopTimer();
-    asio::awaitable<void> startStress(std::vector<std::string>, std::string);
-    asio::awaitable<void> sendTss(FIX::SessionID);
-    void setField(FIX::Message &, int tag, const std::string &value);
+    // Sessions named by session id or TargetCompID; every session but the
+    // drop-copy ones if names is empty.
+    std::vector<FIX::Session *> findSessions(
+        const std::vector<std::string_view> &names) const;
+    // Resolves drop_copy.sessions once m_sessions is filled.
+    void buildDropCopies();
+    // Builds m_throttles once m_sessions and m_drop_copies are filled.
+    void buildThrottles();
+    struct Throttle;
+    struct SessionThrottles;
+    // Takes msg from every bucket of throttles that counts it, plus rule's,
+    // or rejects it and takes from none.
+    bool admit(const FIX::SessionID &, SessionThrottles &throttles,
+               Throttle *rule, const FIX::Message &msg);
+    // Sends the throttle's reject for msg from the app thread, at once.
+    void reject(const FIX::SessionID &, const ThrottleConfig &,
+                const FIX::Message &);
+    // Mirrors ExecutionReports sent to id to the drop-copy sessions.
+    void dropCopy(const FIX::SessionID &id,
+                  std::span<const std::string_view> bodies);
+    // Stops the runs of the named sessions, or every run and its scenario.
+    void closeStress(const std::vector<std::string_view> &sessions);
+    void startStress(const std::shared_ptr<StressScenario> &,
+                     const std::vector<FIX::Session *> &, bool auto_exit,
+                     uint32_t rate);
+    // Sends the scenario to one session, at most rate messages a second
+    // when rate is set.
+    asio::awaitable<void> streamStress(std::shared_ptr<StressScenario>,
+                                       FIX::Session *,
+                                       std::shared_ptr<std::atomic_bool> stop,
+                                       bool auto_exit, uint32_t rate);
     asio::awaitable<void> clear();
+    // Samples the counters into m_stats once a second, on the app thread.
+    asio::awaitable<void> sampleStats();
+    // The last sample as json.
+    std::string stats() const;
+    // Rewrites the metrics segment every metrics interval, on the app
+    // thread.
+    asio::awaitable<void> publishMetrics();
     std::string createUniqueOrderID(const FIX::Message &);
-    void fillExecReport(std::shared_ptr<FIX::Message> &, const FIX::Message &,
-                        int, const std::string &);
-    asio::awaitable<void> sendCustomizeLoginResponse(FIX::Message,
-                                                     FIX::SessionID);
+    void fill(FIX::Message &, const FIX::Message &, const FieldTemplate &);
+    // Hands the value of a non-group field to sink, or nothing if an
+    // if_input field is absent.
+    template <typename Sink>
+    void resolve(const FIX::Message &, const FieldTemplate &, Sink &&);
+    // Every reply map of the config, named by its place in the yaml.
+    std::vector<std::pair<std::string, const FixFieldMap *>> replyMaps() const;
+
+    // A message built straight into its encoded body, for the replies that
+    // do not depend on the FIX version: the logon response and trading
+    // session status.
+    struct CompiledReply {
+        std::string msg_type;
+        // The constant fields and groups, encoded once.
+        std::string constants;
+        // The rest in tag order, groups last.
+        std::vector<const FieldTemplate *> fields;
+    };
+    // Without inputs, fields that read the request are left out.
+    CompiledReply compile(std::string msg_type, const FixFieldMap &,
+                          bool inputs) const;
+    void build(OutboundMessage &, const CompiledReply &, const FIX::Message &);
+    void sendLogonResponse(const FIX::Message &, const FIX::SessionID &);
+    // Starts the session's trading_session_status over. App thread only.
+    void scheduleTss(FIX::Session *);
+    // Sends every trading_session_status step due by now. Each step is
+    // built once per tick for all the sessions it is due for.
+    void sendDueTss(std::chrono::steady_clock::time_point now);
 
     std::shared_ptr<asio::io_context> m_io_ctx;
     Config m_cfg;
-    asio::thread_pool m_pool{1};
+    AsioAcceptor *m_acceptor{nullptr};
+    // cfg.header, encoded once for the direct send path.
+    std::string m_header_fields;
+    std::vector<FieldTemplate> m_header;
+    // The parsed form of every map in replyMaps(), built by the
+    // constructor; m_cfg is not modified afterwards.
+    std::unordered_map<const FixFieldMap *, std::vector<FieldTemplate>>
+        m_templates;
+    struct RuleConditions {
+        std::vector<Condition> header;
+        std::vector<Condition> body;
+    };
+    // Parallel to m_cfg.custom_reply.
+    std::vector<RuleConditions> m_conditions;
+    // The common fields of a duplicate ClOrdID reject.
+    const FixFieldMap m_no_fields;
+    // Where fill evaluates expressions; only used on the app thread.
+    std::string m_scratch;
+    std::optional<CompiledReply> m_logon_response;
+    // Parallel to m_cfg.trading_session_status.
+    std::vector<CompiledReply> m_tss;
+    // One schedule for every session instead of a timer each, run by
+    // loopTimer. A step is dropped once its session logs out or logs on
+    // again, which starts a new generation.
+    struct TssStep {
+        FIX::Session *session;
+        size_t step;
+        uint64_t generation;
+    };
+    std::multimap<std::chrono::steady_clock::time_point, TssStep> m_tss_due;
+    std::unordered_map<FIX::Session *, uint64_t> m_tss_generation;
+    std::vector<OutboundMessage> m_tss_out;
+    std::vector<bool> m_tss_built;
+    std::unique_ptr<MarketDataPublisher> m_market_data;
+    IoPool m_pool;
+    // Filled by setAcceptor before anything runs, read-only afterwards.
     std::unordered_map<std::string, FIX::Session *> m_sessions;
+    // Filled by setAcceptor, read-only afterwards. The bodies of a primary
+    // session's reports go to every drop copy as they are, under a header
+    // built once per primary session: cfg.header plus OnBehalfOfCompID.
+    std::vector<FIX::Session *> m_drop_copies;
+    std::map<FIX::SessionID, std::string> m_drop_copy_headers;
+    // Filled by onCreate, which the acceptor calls for every session before
+    // it starts; read-only afterwards.
+    std::map<FIX::SessionID, const MessageFactory *> m_factories;
+    struct Throttle {
+        explicit Throttle(const ThrottleConfig &config)
+            : cfg(&config),
+              bucket(config.rate, config.burst.value_or(config.rate)) {}
+
+        // Whether msg is of a type this throttle limits.
+        bool counts(std::string_view msg_type) const;
+
+        const ThrottleConfig *cfg;
+        TokenBucket bucket;
+    };
+    struct SessionThrottles {
+        // Those of cfg.throttle that apply to the session.
+        std::vector<std::unique_ptr<Throttle>> session;
+        // Parallel to m_cfg.custom_reply, nullptr for a rule without a
+        // throttle for the session.
+        std::vector<std::unique_ptr<Throttle>> rules;
+    };
+    // Filled by setAcceptor and indexed by SessionSlot::index; only the
+    // buckets change afterwards, and only on the session's own thread.
+    // Empty without throttles, which then cost fromApp one branch.
+    std::vector<SessionThrottles> m_throttles;
+    ShardedCounter m_throttled;
 
     struct TimedData {
         FIX::SessionID id;
+        const MessageFactory *factory;
         FixFieldMap *fix_fields;
         FixFieldMap *common_fix_fields;
         std::shared_ptr<FIX::Message> msg;
@@ -152,15 +423,38 @@ private:
     };
 
     std::multimap<std::chrono::system_clock::time_point, TimedData> m_timed;
+    // Replies due in the same loopTimer tick, grouped per session.
+    std::map<FIX::SessionID, std::vector<OutboundMessage>> m_batches;
+    std::vector<OutboundMessage> m_immediate;
 
-    std::thread m_thread;
-    std::function<void()> m_stop = [] {};
+    std::unique_ptr<HttpServer> m_http;
+    ShardedCounter m_orders_in;
+    // Scenario messages handed to the acceptor.
+    ShardedCounter m_stress_sent;
+    // Created by setAcceptor if the config asks for it; the slots are in
+    // the order of the segment's sessions.
+    std::unique_ptr<ShmMetricsWriter> m_metrics;
+    std::vector<const SessionSlot *> m_metric_slots;
+    const LogRotator *m_log_rotator{nullptr};
+    // From fromApp to the app thread, and how late timed replies fire.
+    // Both are only touched on the app thread.
+    Histogram m_queue_latency;
+    Histogram m_timer_lateness;
+    mutable std::mutex m_stats_mutex;
+    std::string m_stats{"{}"};
 
-    nlohmann::json m_tag_list;
-    std::unordered_map<std::string, nlohmann::json> m_tag_mapping;
-    std::unordered_map<std::string, nlohmann::json> m_interface_mapping;
+    // Set by parseXml before the http server starts.
+    std::unique_ptr<Schema> m_schema;
     std::atomic_bool m_pause{false};
-    std::atomic_bool m_close_stress{false};
+    // The /stress senders still running, for /close/stress. A run stops
+    // on its own flag, or with its scenario when every run is closed.
+    struct StressRun {
+        FIX::Session *session;
+        std::weak_ptr<StressScenario> scenario;
+        std::shared_ptr<std::atomic_bool> stop;
+    };
+    std::mutex m_stress_mutex;
+    std::vector<StressRun> m_stress_runs;
     std::unordered_map<
         std::string,
         std::tuple<std::chrono::system_clock::time_point, std::string>>
@@ -0,0 +1,245 @@
+#ifndef _ASIO_ACCEPTOR_H_
+#define _ASIO_ACCEPTOR_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <quickfix/Acceptor.h>
+#include <quickfix/Parser.h>
+#include <quickfix/Responder.h>
+#include <quickfix/Session.h>
+#include <quickfix/SessionSettings.h>
+
+#include <asio.hpp>
+
+#include "histogram.h"
+#include "io_pool.h"
+#include "resend_ring.h"
+
+// An application message whose header is completed by the transport:
+// MsgType plus any extra header fields, and the already encoded body.
+struct OutboundMessage {
+    std::string msg_type;
+    std::string header;
+    std::string body;
+};
+
+// What happens to application messages for a session whose queue went
+// over the high watermark, until it drains below the low one.
+enum class BackpressurePolicy : uint8_t {
+    // Keep sending; the stress generator and market data hold back.
+    Pause,
+    // Discard and count; nothing is sequenced or stored.
+    Drop,
+    // Drop the connection; messages are stored for the resend on relogon.
+    Disconnect,
+};
+
+// What became of a batch handed to AsioAcceptor::send.
+enum class SendResult : uint8_t {
+    // Nothing was sequenced: no such session, or discarded under Drop.
+    Dropped,
+    // Sequenced and stored while the session is offline; the client gets
+    // it with a ResendRequest.
+    Stored,
+    // Sequenced, stored and handed to the connection.
+    Sent,
+};
+
+struct OutboundLimits {
+    size_t high_watermark{64 << 20};
+    size_t low_watermark{16 << 20};
+    BackpressurePolicy policy{BackpressurePolicy::Pause};
+};
+
+class AsioConnection;
+
+// Per-session state shared by the connection and the application threads.
+// The mutex serializes everything that touches the QuickFIX session, which
+// is what keeps fixsim's direct sends and QuickFIX's own admin traffic on
+// one sequence.
+struct SessionSlot {
+    std::recursive_mutex mutex;
+    FIX::Session *session{nullptr};
+    // 0 to slots().size() - 1, for tables kept per session elsewhere.
+    uint32_t index{0};
+    std::weak_ptr<AsioConnection> connection;
+    std::string begin_string;
+    // SenderCompID and TargetCompID, encoded once.
+    std::string comp_ids;
+    int timestamp_precision{3};
+    // Bytes handed to the connection and not yet accepted by the socket.
+    std::atomic<size_t> queued_bytes{0};
+    // Set at the high watermark, cleared at the low one.
+    std::atomic<bool> congested{false};
+    std::atomic<uint64_t> congestion_events{0};
+    std::atomic<uint64_t> dropped{0};
+    // Messages read from the connection and application messages written
+    // to it. Only changed under the mutex, with a relaxed load and store,
+    // and kept on a line of their own since every message touches them.
+    alignas(64) std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> sent{0};
+    std::atomic<uint64_t> logons{0};
+    // When the last logon completed, in steady_clock nanoseconds, until the
+    // first application message after it goes out.
+    int64_t logon_at{0};
+    // From logon to the first application message, of the last logon.
+    std::atomic<int64_t> logon_latency{0};
+    // Every message written, for ResendRequests; empty again whenever the
+    // store's creation time moves, i.e. the sequence was reset.
+    std::unique_ptr<ResendRing> resend_ring;
+    FIX::UtcTimeStamp resend_created;
+    // Messages sent again, on a ResendRequest or /fault.
+    std::atomic<uint64_t> resent{0};
+    // Left to sequence and store without writing, for /fault.
+    uint64_t drop_next{0};
+};
+
+class AsioAcceptor;
+
+class AsioConnection : public FIX::Responder,
+                       public std::enable_shared_from_this<AsioConnection> {
+public:
+    AsioConnection(asio::ip::tcp::socket, AsioAcceptor &);
+
+    void start();
+    // Queues fully framed messages and flushes them with one writev.
+    void write(std::vector<std::string> frames);
+
+    // FIX::Responder, used by the session for its own admin traffic.
+    bool send(const std::string &) override;
+    void disconnect() override;
+
+private:
+    void doRead();
+    void onMessage(const std::string &);
+    bool bindSession(const std::string &);
+    void doWrite();
+    void close();
+    void queued(size_t bytes);
+    void written(size_t bytes);
+
+    asio::ip::tcp::socket m_socket;
+    AsioAcceptor &m_acceptor;
+    FIX::Parser m_parser;
+    std::array<char, 64 * 1024> m_read_buf;
+    SessionSlot *m_slot{nullptr};
+    bool m_closed{false};
+
+    std::mutex m_write_mutex;
+    std::vector<std::string> m_queue;
+    std::vector<std::string> m_writing;
+    size_t m_write_index{0};
+    size_t m_write_offset{0};
+    bool m_write_pending{false};
+};
+
+// Replacement for FIX::SocketAcceptor that lets fixsim write to the socket
+// directly. QuickFIX still owns session state and admin traffic; fixsim's
+// own application messages are sequenced, persisted and logged per batch
+// under one lock and leave in a single gathered write.
+class AsioAcceptor : public FIX::Acceptor {
+    friend class AsioConnection;
+
+public:
+    AsioAcceptor(FIX::Application &, FIX::MessageStoreFactory &,
+                 const FIX::SessionSettings &, FIX::LogFactory &,
+                 const std::optional<ThreadConfig> & = std::nullopt);
+    ~AsioAcceptor() override;
+
+    // Sequences, stores and logs the batch, then flushes it to the session's
+    // connection. Messages for a session that is not logged on are stored
+    // only, so the client can recover them with a ResendRequest.
+    SendResult send(const FIX::SessionID &, std::span<const OutboundMessage>);
+    // Same, for a run of bodies that share MsgType and extra header fields.
+    SendResult send(const FIX::SessionID &, std::string_view msg_type,
+                    std::string_view header,
+                    std::span<const std::string_view> bodies);
+
+    // Faults for testing a client's gap recovery. False if the session is
+    // unknown; resend and requestResend also need it logged on.
+    // Moves the next MsgSeqNum count ahead, so the gap is only ever
+    // answered with a gap fill.
+    bool skip(const FIX::SessionID &, uint32_t count);
+    // Sequences and stores the next count messages but never writes them,
+    // so the gap is resent with their content.
+    bool drop(const FIX::SessionID &, uint32_t count);
+    // Sends [begin, end] again, unasked, with PossDupFlag, as far as the
+    // resend ring reaches. end 0 is the last message sent.
+    bool resend(const FIX::SessionID &, FIX::SEQNUM begin, FIX::SEQNUM end);
+    // Asks the client to resend [begin, end].
+    bool requestResend(const FIX::SessionID &, FIX::SEQNUM begin,
+                       FIX::SEQNUM end);
+
+    SessionSlot *slot(const FIX::SessionID &);
+    // The slot whose message the calling thread is handing to its session,
+    // so the application's callbacks can skip slot(). Null outside them.
+    static SessionSlot *current();
+    // Lock-free, so they are safe to call without the session lock.
+    size_t queuedBytes(const FIX::SessionID &);
+    bool congested(const FIX::SessionID &);
+
+    // Must be set before start().
+    void setLimits(const OutboundLimits &limits) { m_limits = limits; }
+    const OutboundLimits &limits() const { return m_limits; }
+    // Bytes of application messages kept per session for resends; 0 leaves
+    // every ResendRequest to QuickFIX and the store.
+    void setResendCapacity(size_t bytes) { m_resend_capacity = bytes; }
+    const std::unordered_map<std::string, std::unique_ptr<SessionSlot>> &
+    slots() const {
+        return m_slots;
+    }
+    // Logon to first application message, in nanoseconds, of every session.
+    Histogram logonLatency() const;
+
+private:
+    void onConfigure(const FIX::SessionSettings &) override;
+    void onInitialize(const FIX::SessionSettings &) override;
+    void onStart() override;
+    bool onPoll() override;
+    void onStop() override;
+
+    template <typename Get>
+    SendResult sendBatch(const FIX::SessionID &, size_t count, Get &&get);
+    // The slot's ring, emptied if the store was reset since it was filled.
+    // Null if resends are left to the store.
+    ResendRing *resendRing(SessionSlot &, const FIX::MessageStore &);
+    // Adds a message QuickFIX wrote itself to the ring.
+    void recordSent(SessionSlot &, std::string_view msg);
+    // Answers a ResendRequest from the ring if it is next in sequence,
+    // passes the header checks QuickFIX would make, and asks for a range
+    // the ring covers; otherwise QuickFIX does.
+    bool serveResend(SessionSlot &, AsioConnection &, const std::string &);
+    // Writes [begin, end] from the ring as possible duplicates, with a gap
+    // fill for every run of admin messages.
+    size_t resendFrom(SessionSlot &, AsioConnection &, const ResendRing &,
+                      FIX::SEQNUM begin, FIX::SEQNUM end);
+    void doAccept(asio::ip::tcp::acceptor &);
+    asio::awaitable<void> heartbeat();
+
+    // Runs the sockets, strands and heartbeat timer.
+    IoPool m_pool;
+    std::vector<std::unique_ptr<asio::ip::tcp::acceptor>> m_acceptors;
+    std::vector<uint16_t> m_ports;
+    bool m_reuse_address{true};
+    bool m_no_delay{true};
+    OutboundLimits m_limits;
+    size_t m_resend_capacity{0};
+    // Built once in onConfigure and never resized afterwards, so lookups
+    // from the application threads need no lock.
+    std::unordered_map<std::string, std::unique_ptr<SessionSlot>> m_slots;
+    // Recorded at most once per logon.
+    mutable std::mutex m_logon_mutex;
+    Histogram m_logon_latency;
+};
+
+#endif
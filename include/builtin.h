@@ -0,0 +1,15 @@
+#ifndef _BUILTIN_H_
+#define _BUILTIN_H_
+
+#include <string>
+#include <string_view>
+
+// Functions a reply field can call as "call.<name>".
+
+std::string getTzDateTime(std::string_view fmt = "{:%Y%m%d-%H:%M:%S}");
+std::string getTzDateTimeNoMs(std::string_view fmt = "{:%Y%m%d-%H:%M:%S}");
+std::string uuid();
+std::string randomNumber(int min = 1000, int max = 9999);
+std::string increment();
+
+#endif
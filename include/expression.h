@@ -0,0 +1,89 @@
+#ifndef _EXPRESSION_H_
+#define _EXPRESSION_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <quickfix/Message.h>
+
+// Fixed-point decimal with 8 places, enough for FIX prices and quantities
+// without the rounding noise of double.
+struct Decimal {
+    static constexpr int kPlaces = 8;
+    static constexpr int64_t kScale = 100'000'000;
+
+    int64_t raw{0};
+
+    // Throws std::invalid_argument on anything but [-]digits[.digits].
+    // Places beyond kPlaces are truncated.
+    static Decimal parse(std::string_view);
+    // Shortest form: no trailing zeros and no point for whole numbers.
+    // Returns the end of what was written; buf needs 32 bytes.
+    char *format(char *buf) const;
+};
+
+// A computed reply field, written in the config as
+//   38: "expr: input.38 * 0.5"
+//   31: "expr: round(input.44 * 1.001, 3)"
+//   32: "expr: min(input.38, 100)"
+//   58: "expr: concat(input_header.49, \"-\", input.11)"
+//
+// Operands are numbers, "strings", input.N and input_header.N; operators
+// are + - * / and parentheses; functions are min, max, abs, round(x, n)
+// and concat, which is only allowed as the whole expression. The text is
+// compiled once into a postfix program, which runs on a fixed stack with
+// fields read in place, so evaluating it does not allocate.
+class Expression {
+public:
+    Expression() = default;
+    // Throws std::invalid_argument with the position of the error.
+    explicit Expression(std::string_view text);
+
+    // Writes the result to out, reusing its capacity. Throws
+    // FIX::FieldNotFound for a missing input and std::invalid_argument for
+    // a field that is not a number or a division by zero.
+    void evaluate(const FIX::Message &, std::string &out) const;
+
+    bool empty() const { return m_program.empty(); }
+    // True if the result is text rather than a number.
+    bool text() const { return m_text; }
+    // Every input tag the expression reads.
+    std::vector<int> inputs() const;
+
+private:
+    enum class Op : uint8_t {
+        Number,
+        Text,
+        Input,
+        InputHeader,
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Neg,
+        Min,
+        Max,
+        Abs,
+        Round,
+        Concat,
+    };
+    struct Instr {
+        Op op;
+        // Concat: number of operands.
+        uint8_t count{0};
+        // Input*: tag. Text: offset into m_literals.
+        int32_t arg{0};
+        // Number: the value. Text: length.
+        int64_t value{0};
+    };
+
+    friend class ExpressionParser;
+
+    std::vector<Instr> m_program;
+    std::string m_literals;
+    bool m_text{false};
+};
+
+#endif
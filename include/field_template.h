@@ -0,0 +1,124 @@
+#ifndef _FIELD_TEMPLATE_H_
+#define _FIELD_TEMPLATE_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <quickfix/FieldMap.h>
+
+#include "expression.h"
+#include "schema.h"
+
+using FixFieldMap = std::unordered_map<int32_t, std::string>;
+
+// Tags from here up are user defined and may be missing from the
+// dictionary.
+inline constexpr int kFirstUserDefinedTag = 5000;
+
+// How a dictionary type is checked and encoded.
+enum class FieldType : uint8_t {
+    String,
+    Char,
+    Int,
+    Qty,
+    Price,
+    UtcTimestamp,
+    Boolean,
+    // Space separated values, each from the enum.
+    MultipleValue,
+};
+
+// The call.<name> functions.
+enum class Builtin : uint8_t {
+    Uuid,
+    GetTzDateTime,
+    GetTzDateTimeNoMs,
+    RandomNumber,
+    Increment,
+    CreateUniqueOrderID,
+    MarketPrice,
+};
+
+// "448=BRK 447=D 452=1": the fields of one group instance.
+using FieldList = std::vector<std::pair<int, std::string>>;
+
+// One "tag: value" of a reply in the yaml config, parsed once so that
+// building a reply is a switch over the source and a setField, with no
+// string matching, tag parsing or type checks left for the hot path.
+struct FieldTemplate {
+    enum class Source : uint8_t {
+        Constant,       // "0"; "bool:true" becomes "Y"
+        Input,          // "input.11"
+        IfInput,        // "if_input.11"
+        InputHeader,    // "input_header.49"
+        IfInputHeader,  // "if_input_header.49"
+        Call,           // "call.uuid"
+        Expr,           // "expr: input.38 * 0.5"
+        // Repeating groups are not set on the FIX::Message but appended to
+        // the encoded body by appendGroup, so no FIX::Group is built.
+        Group,       // "group: 448=BRK 447=D 452=1 | 448=C1 447=D 452=3"
+        InputGroup,  // "input_group.453", the request's group as is
+    };
+
+    int tag;
+    Source source;
+    // The request field an Input* copies.
+    int input_tag{0};
+    Builtin call{};
+    Expression expr{};
+    FieldType type{FieldType::String};
+    // A constant as it goes on the wire; for a Group the whole group,
+    // count first.
+    std::string value;
+    // Group: every instance's fields, for check.
+    std::vector<FieldList> instances{};
+    // The config text, for messages.
+    std::string text;
+
+    // Throws std::invalid_argument on a malformed value.
+    static FieldTemplate parse(int tag, const std::string &value);
+    // Resolves the field type from the dictionary and checks the constant,
+    // or what a call returns, against it. Returns an empty string or what
+    // is wrong.
+    std::string check(const Schema &);
+
+    bool group() const {
+        return source == Source::Group || source == Source::InputGroup;
+    }
+    // Appends a Group or InputGroup to an encoded body.
+    void appendGroup(std::string &body, const FIX::Message &in) const;
+};
+
+// One check_condition_header or check_condition_body entry.
+struct Condition {
+    enum class Kind : uint8_t {
+        Equal,    // "D"
+        Present,  // "optional(none)", any value
+        // "any(448=BRK 452=3)": some instance of the group carries all of
+        // these fields.
+        Any,
+    };
+
+    int tag;
+    Kind kind;
+    std::string value;
+    FieldList fields;
+
+    // Throws std::invalid_argument on a malformed value.
+    static Condition parse(int tag, const std::string &value);
+    // Throws FIX::FieldNotFound if an Equal or Present tag is missing.
+    bool matches(const FIX::FieldMap &) const;
+    std::string check(const Schema &) const;
+};
+
+std::vector<Condition> parseConditions(const FixFieldMap &);
+
+FieldType fieldType(std::string_view dictionary_type);
+// An empty string if value is valid for the field, or what is wrong.
+std::string checkValue(const Schema::Field &, std::string_view value);
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef _HTTP_SERVER_H_
+#define _HTTP_SERVER_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <asio.hpp>
+
+#include "io_pool.h"
+
+// One request and its response, handed to a route's handler.
+class HttpExchange {
+public:
+    HttpExchange(asio::ip::tcp::socket &, std::string &buffer);
+
+    const std::string &method() const { return m_method; }
+    const std::string &path() const { return m_path; }
+    // What a route ending in "*" matched.
+    std::string_view wildcard() const { return m_wildcard; }
+    // Names are matched without regard to case. Empty if absent.
+    std::string_view header(std::string_view name) const;
+    bool hasHeader(std::string_view name) const;
+
+    // The whole body, read before the handler runs unless the route
+    // streams it.
+    const std::string &body() const { return m_body; }
+    // The next piece of a streamed body, empty at its end.
+    asio::awaitable<std::string_view> read();
+
+    void reply(int status, std::string body,
+               std::string_view content_type = "text/plain");
+    // Sends a shared buffer without copying it.
+    void reply(int status, std::shared_ptr<const std::string> body,
+               std::string_view content_type);
+    void setHeader(std::string name, std::string value);
+
+    // Sends the headers of a response whose length is not known, which
+    // then ends with the connection. Each write() goes out as it is; it
+    // throws once the client is gone. For event streams.
+    asio::awaitable<void> begin(std::string_view content_type);
+    asio::awaitable<void> write(std::string_view);
+
+private:
+    friend class HttpServer;
+
+    // Parses the request line and headers; false on a malformed request.
+    bool parse(std::string_view head);
+    asio::awaitable<void> readBody();
+    asio::awaitable<void> respond(bool keep_alive);
+
+    asio::ip::tcp::socket &m_socket;
+    // Bytes read past the headers; the start of the body.
+    std::string &m_buffer;
+    std::string m_method;
+    std::string m_path;
+    std::string m_version;
+    std::string_view m_wildcard;
+    std::vector<std::pair<std::string, std::string>> m_headers;
+    std::string m_body;
+    size_t m_body_left{0};
+    std::string m_chunk;
+
+    int m_status{200};
+    std::string m_content_type;
+    std::vector<std::pair<std::string, std::string>> m_reply_headers;
+    std::string m_reply;
+    std::shared_ptr<const std::string> m_shared_reply;
+    bool m_streaming{false};
+};
+
+// A small HTTP/1.1 server for the control API, on its own IoPool. Every
+// connection is a coroutine, so a slow upload or an event stream holds
+// up nothing but itself; handlers that do heavy work hand it to another
+// executor and await it.
+class HttpServer {
+public:
+    using Handler = std::function<asio::awaitable<void>(HttpExchange &)>;
+
+    HttpServer(std::string name, const std::optional<ThreadConfig> &);
+    ~HttpServer();
+
+    // A path ending in "*" matches every path with that prefix; an exact
+    // path wins over it, and a longer prefix over a shorter one. A route
+    // that streams its body reads it with HttpExchange::read().
+    void route(std::string method, std::string path, Handler,
+               bool stream_body = false);
+    void get(std::string path, Handler handler) {
+        route("GET", std::move(path), std::move(handler));
+    }
+    void post(std::string path, Handler handler, bool stream_body = false) {
+        route("POST", std::move(path), std::move(handler), stream_body);
+    }
+
+    // Throws if the address cannot be bound.
+    void listen(const std::string &host, uint16_t port);
+    void stop();
+
+private:
+    struct Route {
+        Handler handler;
+        bool stream_body;
+    };
+
+    const Route *find(const std::string &method, const std::string &path,
+                      std::string_view &wildcard) const;
+    asio::awaitable<void> accept();
+    asio::awaitable<void> serve(asio::ip::tcp::socket);
+
+    static constexpr size_t kMaxHeader = 64 << 10;
+    static constexpr size_t kMaxBody = 16 << 20;
+
+    IoPool m_pool;
+    std::optional<asio::ip::tcp::acceptor> m_acceptor;
+    // "METHOD path" -> route, filled before listen().
+    std::unordered_map<std::string, Route> m_routes;
+    std::vector<std::pair<std::string, Route>> m_prefixes;
+};
+
+#endif
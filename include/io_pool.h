@@ -0,0 +1,61 @@
+#ifndef _IO_POOL_H_
+#define _IO_POOL_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <asio.hpp>
+#include <yaml_cpp_struct.hpp>
+
+struct ThreadConfig {
+    std::optional<uint32_t> threads;  // default 1
+    // Thread i is pinned to cpus[i % cpus.size()].
+    std::optional<std::vector<int32_t>> cpus;
+    // Spin on poll() instead of sleeping in epoll; only worth it on cores
+    // that nothing else runs on.
+    std::optional<bool> busy_poll;
+};
+YCS_ADD_STRUCT(ThreadConfig, threads, cpus, busy_poll)
+
+// An io_context and the threads that run it, named "<name>-<index>".
+class IoPool {
+public:
+    IoPool(std::string name, const std::optional<ThreadConfig> &,
+           std::shared_ptr<asio::io_context> ctx =
+               std::make_shared<asio::io_context>());
+    ~IoPool();
+
+    asio::io_context &context() { return *m_ctx; }
+    size_t threads() const { return m_threads_count; }
+
+    // Starts every thread in the background.
+    void start();
+    // Runs the calling thread as index 0 next to the other threads and
+    // returns once the pool is stopped and they have exited.
+    void run();
+    void stop();
+    void join();
+
+    // Names and pins the calling thread.
+    static void setup(const std::string &name, size_t index,
+                      const std::vector<int32_t> &cpus);
+
+private:
+    void spawn(size_t from);
+    void runThread(size_t index);
+
+    std::string m_name;
+    std::shared_ptr<asio::io_context> m_ctx;
+    size_t m_threads_count;
+    std::vector<int32_t> m_cpus;
+    bool m_busy_poll;
+    std::optional<asio::executor_work_guard<asio::io_context::executor_type>>
+        m_guard;
+    std::vector<std::thread> m_threads;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef _LOG_ROTATOR_H_
+#define _LOG_ROTATOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include <yaml_cpp_struct.hpp>
+
+#include "io_pool.h"
+
+struct MessageLogConfig {
+    // Rotate a session's log once its messages file reaches this many MB.
+    std::optional<uint32_t> max_size;
+    // Rotate every this many minutes.
+    std::optional<uint32_t> max_age;
+    // gzip rotated files. Defaults to true.
+    std::optional<bool> compress;
+};
+YCS_ADD_STRUCT(MessageLogConfig, max_size, max_age, compress)
+
+// Numbers and compresses the backups of the FIX message logs. A log
+// renames its files to <prefix>messages.backup.<n>.log and
+// <prefix>event.backup.<n>.log, which is all it waits for; the "log"
+// thread gzips them afterwards.
+class LogRotator {
+public:
+    explicit LogRotator(const MessageLogConfig &);
+    // Whatever is not compressed yet is left for the next start.
+    ~LogRotator();
+
+    const MessageLogConfig &config() const { return m_cfg; }
+    // The next backup number for prefix. The directory is only listed the
+    // first time a prefix is asked for; uncompressed backups found there
+    // are queued then. Safe to call from any thread.
+    uint64_t nextIndex(const std::string &prefix);
+    // Replaces path with path.gz in the background, if compress is on.
+    void compress(std::string path);
+    // Bytes of backups queued for compress and not done yet.
+    uint64_t backlog() const {
+        return m_backlog.load(std::memory_order::relaxed);
+    }
+
+private:
+    void gzip(const std::string &path);
+
+    MessageLogConfig m_cfg;
+    std::mutex m_mutex;
+    std::unordered_map<std::string, uint64_t> m_next;
+    std::atomic<bool> m_stopping{false};
+    std::atomic<uint64_t> m_backlog{0};
+    IoPool m_pool;
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef _MARKET_DATA_H_
+#define _MARKET_DATA_H_
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <quickfix/Message.h>
+#include <quickfix/SessionID.h>
+
+#include <asio.hpp>
+#include <yaml_cpp_struct.hpp>
+
+#include "asio_acceptor.h"
+
+struct MarketDataSymbol {
+    std::string symbol;
+    double price;  // initial bid
+    double tick;
+    std::optional<int32_t> spread;    // ticks, default 1
+    std::optional<int32_t> max_step;  // ticks per random walk step, default 1
+    std::optional<int64_t> size;      // default 1000000
+    // "bid,offer[,bid_size,offer_size]" per line, replayed in a loop
+    // instead of the random walk.
+    std::optional<std::string> file;
+};
+YCS_ADD_STRUCT(MarketDataSymbol, symbol, price, tick, spread, max_step, size,
+               file)
+
+struct MarketDataConfig {
+    // Every symbol moves one step per interval.
+    std::chrono::microseconds interval;
+    std::optional<uint32_t> max_entries;  // NoMDEntries per X, default 100
+    // Updates for a session with more than this many bytes queued are
+    // conflated until it drains, default 1 MB.
+    std::optional<uint32_t> conflate_bytes;
+    std::vector<MarketDataSymbol> symbols;
+};
+YCS_ADD_STRUCT(MarketDataConfig, interval, max_entries, conflate_bytes, symbols)
+
+// Answers MarketDataRequest (V) with a snapshot (W) and then publishes top of
+// book changes as incremental refreshes (X). Each session remembers the last
+// version it was sent per symbol, so a slow session simply skips the
+// intermediate prices instead of queueing them.
+class MarketDataPublisher {
+public:
+    MarketDataPublisher(const MarketDataConfig &, std::string header_fields);
+
+    void setAcceptor(AsioAcceptor *);
+    // Called from fromApp with the session lock held.
+    void onRequest(const FIX::Message &, const FIX::SessionID &);
+    void onLogout(const FIX::SessionID &);
+    // Current offer for a buy ('1') and bid for anything else.
+    std::optional<std::string> quote(const std::string &symbol, char side);
+
+    asio::awaitable<void> run();
+
+private:
+    struct Level {
+        int64_t bid;
+        int64_t offer;
+        int64_t bid_size;
+        int64_t offer_size;
+
+        bool operator==(const Level &) const = default;
+    };
+    struct Book {
+        std::string symbol;
+        int precision;
+        int64_t tick;
+        int64_t spread;
+        int32_t max_step;
+        Level level;
+        std::vector<Level> path;
+        size_t cursor{0};
+        uint64_t version{1};
+    };
+    struct Subscription {
+        std::string req_id;
+        std::vector<uint32_t> books;
+        // Book version last sent; 0 until the snapshot went out.
+        std::vector<uint64_t> sent;
+        bool updates;
+    };
+    struct Batch {
+        FIX::SessionID id;
+        std::vector<OutboundMessage> msgs;
+        size_t count{0};
+    };
+
+    void step(Book &);
+    void publish();
+    OutboundMessage &next(Batch &, const char *msg_type);
+    void appendEntries(std::string &, const Book &, bool incremental);
+    void reject(const FIX::SessionID &, const std::string &req_id,
+                const std::string &text);
+
+    MarketDataConfig m_cfg;
+    std::string m_header_fields;
+    AsioAcceptor *m_acceptor{nullptr};
+    size_t m_max_entries;
+    size_t m_conflate_bytes;
+    std::map<std::string, uint32_t> m_symbols;
+    std::mt19937_64 m_gen{std::random_device{}()};
+    // Reused across ticks by publish() only.
+    std::vector<Batch> m_batches;
+    std::string m_entries;
+
+    // Guards the books and subscriptions. Never held while sending: the
+    // send path takes the session lock, which onRequest already holds.
+    std::mutex m_mutex;
+    std::vector<Book> m_books;
+    std::map<FIX::SessionID, std::vector<Subscription>> m_subscriptions;
+};
+
+#endif
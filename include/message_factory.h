@@ -0,0 +1,27 @@
+#ifndef _MESSAGE_FACTORY_H_
+#define _MESSAGE_FACTORY_H_
+
+#include <memory>
+#include <string_view>
+
+#include <quickfix/Message.h>
+
+// The reply messages of one FIX version. Each function is a template
+// instance bound to that version's classes, so a session resolves its
+// factory once and creating a message never looks at the version again.
+struct MessageFactory {
+    using Create = std::shared_ptr<FIX::Message> (*)();
+
+    std::string_view begin_string;
+    Create execution_report;
+    Create order_cancel_reject;
+    // nullptr before FIX.4.2, which has no TradingSessionStatus or
+    // BusinessMessageReject.
+    Create trading_session_status;
+    Create business_message_reject;
+
+    // By BeginString; FIXT.1.1 gets FIX.5.0. nullptr if unknown.
+    static const MessageFactory *find(std::string_view begin_string);
+};
+
+#endif
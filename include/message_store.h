@@ -0,0 +1,169 @@
+#ifndef _MESSAGE_STORE_H_
+#define _MESSAGE_STORE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <quickfix/FileStore.h>
+#include <quickfix/MessageStore.h>
+#include <quickfix/SessionID.h>
+
+// Keeps the last `capacity` bytes of outbound messages in a file-backed
+// mmap ring. Sequence numbers live in the mapped header, so the hot path is
+// a memcpy; msync runs at most once per sync_interval.
+class MmapStore : public FIX::MessageStore {
+public:
+    MmapStore(const FIX::UtcTimeStamp &, const std::string &path,
+              const FIX::SessionID &, size_t capacity,
+              std::chrono::milliseconds sync_interval);
+    ~MmapStore() override;
+
+    bool set(FIX::SEQNUM, const std::string &) override;
+    void get(FIX::SEQNUM, FIX::SEQNUM,
+             std::vector<std::string> &) const override;
+    FIX::SEQNUM getNextSenderMsgSeqNum() const override;
+    FIX::SEQNUM getNextTargetMsgSeqNum() const override;
+    void setNextSenderMsgSeqNum(FIX::SEQNUM) override;
+    void setNextTargetMsgSeqNum(FIX::SEQNUM) override;
+    void incrNextSenderMsgSeqNum() override;
+    void incrNextTargetMsgSeqNum() override;
+    FIX::UtcTimeStamp getCreationTime() const override;
+    void reset(const FIX::UtcTimeStamp &) override;
+    void refresh() override;
+
+private:
+    struct Header;
+    struct Entry {
+        FIX::SEQNUM seq;
+        uint64_t offset;
+        uint32_t size;
+    };
+
+    void open(const FIX::UtcTimeStamp &);
+    void rebuildIndex();
+    void evict(uint64_t from, uint64_t to);
+    void maybeSync();
+
+    std::string m_file_name;
+    size_t m_capacity;
+    std::chrono::milliseconds m_sync_interval;
+    std::chrono::steady_clock::time_point m_last_sync;
+    int m_fd{-1};
+    char *m_base{nullptr};
+    size_t m_mapped{0};
+    Header *m_header{nullptr};
+    // Parsed from the header on open and reset; the acceptor asks for it on
+    // every send.
+    FIX::UtcTimeStamp m_creation_time;
+    std::deque<Entry> m_index;
+};
+
+class MmapStoreFactory : public FIX::MessageStoreFactory {
+public:
+    MmapStoreFactory(std::string path, size_t capacity,
+                     std::chrono::milliseconds sync_interval);
+
+    FIX::MessageStore *create(const FIX::UtcTimeStamp &,
+                              const FIX::SessionID &) override;
+    void destroy(FIX::MessageStore *) override;
+
+private:
+    std::string m_path;
+    size_t m_capacity;
+    std::chrono::milliseconds m_sync_interval;
+};
+
+class AsyncStoreFactory;
+
+// Answers from memory and persists through a regular FileStore on the
+// factory's writer thread, so the files stay readable by the File store.
+// Resends older than the in-memory window are read back from disk.
+class AsyncStore : public FIX::MessageStore {
+public:
+    AsyncStore(AsyncStoreFactory &, FIX::MessageStore *backend,
+               size_t capacity);
+    ~AsyncStore() override;
+
+    bool set(FIX::SEQNUM, const std::string &) override;
+    void get(FIX::SEQNUM, FIX::SEQNUM,
+             std::vector<std::string> &) const override;
+    FIX::SEQNUM getNextSenderMsgSeqNum() const override;
+    FIX::SEQNUM getNextTargetMsgSeqNum() const override;
+    void setNextSenderMsgSeqNum(FIX::SEQNUM) override;
+    void setNextTargetMsgSeqNum(FIX::SEQNUM) override;
+    void incrNextSenderMsgSeqNum() override;
+    void incrNextTargetMsgSeqNum() override;
+    FIX::UtcTimeStamp getCreationTime() const override;
+    void reset(const FIX::UtcTimeStamp &) override;
+    void refresh() override;
+
+private:
+    friend class AsyncStoreFactory;
+
+    AsyncStoreFactory &m_factory;
+    FIX::MessageStore *m_backend;
+    size_t m_capacity;
+    size_t m_cached_bytes{0};
+    FIX::SEQNUM m_next_sender;
+    FIX::SEQNUM m_next_target;
+    FIX::UtcTimeStamp m_creation_time;
+    std::map<FIX::SEQNUM, std::string> m_cache;
+};
+
+class AsyncStoreFactory : public FIX::MessageStoreFactory {
+public:
+    AsyncStoreFactory(const std::string &path, size_t capacity,
+                      std::chrono::milliseconds sync_interval);
+    ~AsyncStoreFactory() override;
+
+    FIX::MessageStore *create(const FIX::UtcTimeStamp &,
+                              const FIX::SessionID &) override;
+    void destroy(FIX::MessageStore *) override;
+
+private:
+    friend class AsyncStore;
+
+    enum class OpType : uint8_t { Set, NextSender, NextTarget, Reset };
+    struct Op {
+        FIX::MessageStore *backend;
+        OpType type;
+        FIX::SEQNUM seq;
+        std::string msg;
+        FIX::UtcTimeStamp time;
+    };
+
+    // Blocks while the writer is too far behind.
+    void enqueue(Op);
+    // Blocks until every queued operation has reached the backend.
+    void drain();
+    // Clears the backend of seqnum updates a later one in ops replaces.
+    static void fold(std::vector<Op> &ops);
+    void run();
+
+    FIX::FileStoreFactory m_backend_factory;
+    size_t m_capacity;
+    std::chrono::milliseconds m_sync_interval;
+    // Held by the writer while applying operations and by readers that fall
+    // back to the files; FileStore itself is not thread-safe.
+    std::mutex m_backend_mutex;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::condition_variable m_drained;
+    std::vector<Op> m_ops;
+    uint64_t m_enqueued{0};
+    uint64_t m_applied{0};
+    // Set by drain() to have the writer go before its interval is up.
+    uint64_t m_drain_to{0};
+    bool m_stop{false};
+    std::thread m_thread;
+};
+
+#endif
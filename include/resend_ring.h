@@ -0,0 +1,62 @@
+#ifndef _RESEND_RING_H_
+#define _RESEND_RING_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string_view>
+
+#include <quickfix/MessageStore.h>
+
+// The messages a session wrote last, indexed by MsgSeqNum: application
+// messages encoded, in a ring of `capacity` bytes, and admin messages as a
+// bare seqnum that a resend answers with a gap fill. A seqnum it holds
+// neither for was never written by this process, so only a range it
+// covers() can be resent from memory. Not thread-safe; the session lock
+// guards it.
+class ResendRing {
+public:
+    // The buffer is allocated, and touched, on the first push.
+    explicit ResendRing(size_t capacity) : m_capacity(capacity) {}
+
+    // A seq at or below last() means the sequence went back, and the ring
+    // starts over. A frame that does not fit empties the ring.
+    void push(FIX::SEQNUM, std::string_view frame);
+    void pushAdmin(FIX::SEQNUM);
+    void clear() { m_index.clear(); }
+
+    bool empty() const { return m_index.empty(); }
+    FIX::SEQNUM from() const { return empty() ? 0 : m_index.front().seq; }
+    FIX::SEQNUM last() const { return empty() ? 0 : m_index.back().seq; }
+    size_t size() const { return m_index.size(); }
+    // True if every seq in [begin, end] is held.
+    bool covers(FIX::SEQNUM begin, FIX::SEQNUM end) const;
+
+    // Calls f(seq, frame) for every seq held in [begin, end], in order. The
+    // frame of an admin message is empty.
+    template <typename F>
+    void forEach(FIX::SEQNUM begin, FIX::SEQNUM end, F &&f) const {
+        auto it = std::ranges::lower_bound(m_index, begin, {}, &Entry::seq);
+        for (; it != m_index.end() && it->seq <= end; ++it)
+            f(it->seq, std::string_view(m_data.get() + it->offset, it->size));
+    }
+
+private:
+    struct Entry {
+        FIX::SEQNUM seq;
+        size_t offset;
+        // 0 for an admin message.
+        size_t size;
+    };
+
+    void add(FIX::SEQNUM);
+    void evict(size_t from, size_t to);
+    size_t tail() const;
+
+    size_t m_capacity;
+    std::unique_ptr<char[]> m_data;
+    std::deque<Entry> m_index;
+};
+
+#endif
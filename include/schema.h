@@ -0,0 +1,78 @@
+#ifndef _SCHEMA_H_
+#define _SCHEMA_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <pugixml.hpp>
+
+// The messages and fields of a QuickFIX data dictionary, as served by the
+// HTTP API. Loading only parses the xml and indexes fields, components and
+// messages, so even a FIX50SP2 dictionary is ready in a few milliseconds.
+// Every document is rendered on its first request and kept as an immutable
+// buffer with its ETag.
+//
+// Documents, by name:
+//   <Message>      fields of the message as json, groups nested and
+//                  components expanded in place
+//   <Message>Yaml  the same as a reply skeleton for the yaml config
+//   tag_list       every field by tag
+//   messages       every message with its MsgType
+class Schema {
+public:
+    struct Document {
+        std::string body;
+        std::string etag;
+        std::string content_type;
+    };
+    struct Field {
+        int tag;
+        std::string_view name;
+        std::string_view type;
+        // Enumerated values, empty when any value goes.
+        std::vector<std::string_view> values;
+    };
+
+    // Throws std::runtime_error if the file cannot be parsed.
+    explicit Schema(const std::string &path);
+
+    // nullptr for an unknown name. Safe to call from any thread.
+    std::shared_ptr<const Document> get(std::string_view name) const;
+    size_t messages() const { return m_messages; }
+    // nullptr if the dictionary has no such field.
+    const Field *field(int tag) const;
+
+private:
+    enum class Kind { Json, Yaml, TagList, Messages };
+    struct Entry {
+        Kind kind;
+        pugi::xml_node node;
+        mutable std::once_flag once;
+        mutable std::shared_ptr<const Document> doc;
+    };
+
+    void add(std::string name, Kind, pugi::xml_node);
+    std::string render(const Entry &) const;
+    nlohmann::json message(pugi::xml_node) const;
+    void addFields(nlohmann::json &, pugi::xml_node, bool required,
+                   std::string_view component, int depth) const;
+    void describe(nlohmann::json &, std::string_view name) const;
+
+    pugi::xml_document m_doc;
+    // Views into m_doc, which lives as long as the schema.
+    std::unordered_map<std::string_view, pugi::xml_node> m_fields;
+    std::unordered_map<std::string_view, pugi::xml_node> m_components;
+    std::unordered_map<int, Field> m_tags;
+    // Filled by the constructor, never modified afterwards.
+    std::map<std::string, Entry, std::less<>> m_entries;
+    size_t m_messages{0};
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef _SHARDED_COUNTER_H_
+#define _SHARDED_COUNTER_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// A counter bumped by many threads without them sharing a cache line.
+// Each thread adds to its own slot with a relaxed load and store, and
+// load() sums the slots. The threads past kSlots share one more slot,
+// which they add to atomically.
+class ShardedCounter {
+public:
+    static constexpr size_t kSlots = 64;
+
+    void add(uint64_t n = 1) {
+        const auto i = threadIndex();
+        auto &value = m_slots[i].value;
+        if (i < kSlots)
+            value.store(value.load(std::memory_order::relaxed) + n,
+                        std::memory_order::relaxed);
+        else
+            value.fetch_add(n, std::memory_order::relaxed);
+    }
+    uint64_t load() const {
+        uint64_t sum = 0;
+        for (const auto &slot : m_slots)
+            sum += slot.value.load(std::memory_order::relaxed);
+        return sum;
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> value{0};
+    };
+
+    // The same for a thread in every counter.
+    static size_t threadIndex() {
+        static std::atomic<size_t> next{0};
+        thread_local const size_t index = std::min(next++, kSlots);
+        return index;
+    }
+
+    std::array<Slot, kSlots + 1> m_slots;
+};
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef _SHM_METRICS_H_
+#define _SHM_METRICS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// fixsim's counters in a shared memory segment, /dev/shm/<name>, so a
+// monitor reads them without a request to the process. fixsim rewrites
+// the sample every metrics interval under a sequence number, odd while it
+// writes; a reader copies the sample and retries if the number changed.
+//
+// The layout is versioned. Fields are only appended to the structs below,
+// and a reader checks the magic, the version and the struct sizes before
+// it trusts the segment.
+constexpr uint64_t kShmMetricsMagic = 0x5354454d4d495346;  // "FSIMMETS"
+constexpr uint32_t kShmMetricsVersion = 1;
+
+struct ShmSessionMetrics {
+    char name[64];
+    uint64_t messages_in;
+    uint64_t messages_out;
+    uint64_t queued_bytes;
+    uint64_t dropped;
+    uint32_t logged_on;
+    uint32_t congested;
+};
+
+struct ShmMetricsSample {
+    // steady_clock nanoseconds, so rates hold across clock changes.
+    int64_t time;
+    uint64_t orders_in;
+    uint64_t stress_sent;
+    // Replies waiting on their timer.
+    uint64_t timed;
+    // ClOrdIDs kept for the duplicate check and for OrderID lookups.
+    uint64_t order_ids;
+    uint64_t order_mappings;
+    // Bytes of rotated FIX message logs waiting to be compressed.
+    uint64_t log_backlog;
+    uint32_t sessions;
+    uint32_t reserved;
+};
+
+struct ShmMetricsSegment {
+    // Set once before magic is stored.
+    std::atomic<uint64_t> magic;
+    uint32_t version;
+    uint32_t sample_size;
+    uint32_t session_size;
+    uint32_t max_sessions;
+    int64_t pid;
+    // system_clock nanoseconds.
+    int64_t started;
+    alignas(64) std::atomic<uint64_t> seq;
+    alignas(64) ShmMetricsSample sample;
+    // max_sessions ShmSessionMetrics follow.
+};
+
+// Creates the segment, replacing one left by an earlier run, and removes
+// it again on destruction. Only one thread writes.
+class ShmMetricsWriter {
+public:
+    // Throws std::runtime_error if the segment cannot be created.
+    ShmMetricsWriter(std::string name, const std::vector<std::string> &sessions);
+    ~ShmMetricsWriter();
+    ShmMetricsWriter(const ShmMetricsWriter &) = delete;
+    ShmMetricsWriter &operator=(const ShmMetricsWriter &) = delete;
+
+    // fill writes the sample and the sessions, in the order they were
+    // given to the constructor; readers see all of it or none.
+    template <typename F>
+    void update(F &&fill) {
+        const auto seq = m_segment->seq.load(std::memory_order::relaxed);
+        m_segment->seq.store(seq + 1, std::memory_order::relaxed);
+        std::atomic_thread_fence(std::memory_order::release);
+        fill(m_segment->sample, m_sessions);
+        m_segment->seq.store(seq + 2, std::memory_order::release);
+    }
+
+private:
+    std::string m_name;
+    size_t m_size{0};
+    ShmMetricsSegment *m_segment{nullptr};
+    ShmSessionMetrics *m_sessions{nullptr};
+};
+
+class ShmMetricsReader {
+public:
+    // Throws std::runtime_error if there is no segment or it has another
+    // layout.
+    explicit ShmMetricsReader(std::string name);
+    ~ShmMetricsReader();
+    ShmMetricsReader(const ShmMetricsReader &) = delete;
+    ShmMetricsReader &operator=(const ShmMetricsReader &) = delete;
+
+    int64_t pid() const { return m_segment->pid; }
+    // A consistent copy of the sample and its sessions. False if the
+    // writer kept rewriting it.
+    bool read(ShmMetricsSample &, std::vector<ShmSessionMetrics> &) const;
+
+private:
+    std::string m_name;
+    size_t m_size{0};
+    const ShmMetricsSegment *m_segment{nullptr};
+};
+
+#endif
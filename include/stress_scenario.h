@@ -0,0 +1,94 @@
+#ifndef _STRESS_SCENARIO_H_
+#define _STRESS_SCENARIO_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Rows of a /stress CSV ("tag=value,tag=value,..." per line), encoded once
+// into FIX bodies and kept in fixed-size chunks. A chunk is published as
+// soon as it fills, so the stress loop can start sending while the rest of
+// the input is still being read.
+//
+// A parsed scenario can also be compiled to a binary file and loaded later
+// through a mapping, with only TransactTime refreshed at load.
+class StressScenario {
+public:
+    static constexpr size_t kChunkRows = 4096;
+    static constexpr uint32_t kNoTransactTime = UINT32_MAX;
+
+    // One arena holding the encoded bodies of up to kChunkRows rows. Bodies
+    // of a loaded scenario point into the mapping and data stays empty.
+    struct Chunk {
+        std::string data;
+        std::vector<std::string_view> bodies;
+        // Offset of the generated TransactTime value in each body, or
+        // kNoTransactTime when the row carried its own.
+        std::vector<uint32_t> transact_time;
+    };
+
+    StressScenario(std::string msg_type, std::string header,
+                   std::function<std::string()> transact_time);
+    ~StressScenario();
+
+    const std::string &msgType() const { return m_msg_type; }
+    const std::string &header() const { return m_header; }
+
+    // Parses every complete line in data; a trailing partial line is kept
+    // until the next call. Throws std::invalid_argument on a bad tag.
+    void feed(std::string_view data);
+    // Parses a server-side file through a read-only mapping.
+    void feedFile(const std::string &path);
+    // Flushes the last line and chunk. The scenario is complete afterwards.
+    void finish();
+    // Marks an aborted upload; the stress loop stops on its next tick.
+    void cancel();
+
+    // Writes a finished scenario in the compiled format.
+    void compile(const std::string &path, std::string_view fix_version) const;
+    // Maps a compiled scenario and stamps the current TransactTime into it.
+    // Throws if it was compiled for another FIX version or time format.
+    void load(const std::string &path, std::string_view fix_version);
+
+    bool finished() const {
+        return m_finished.load(std::memory_order::acquire);
+    }
+    bool cancelled() const {
+        return m_cancelled.load(std::memory_order::acquire);
+    }
+    uint64_t rows() const { return m_rows.load(std::memory_order::relaxed); }
+    // Snapshot of the chunks published so far.
+    std::vector<std::shared_ptr<const Chunk>> chunks() const;
+
+private:
+    void parseLine(std::string_view line);
+    void publish();
+
+    std::string m_msg_type;
+    std::string m_header;
+    std::function<std::string()> m_transact_time;
+
+    // Parser state, only touched by the feeding thread.
+    std::string m_partial;
+    std::vector<std::pair<int, std::string_view>> m_fields;
+    std::unique_ptr<Chunk> m_current;
+    std::vector<uint32_t> m_ends;
+    std::vector<uint32_t> m_times;
+    uint64_t m_exec_id{0};
+    void *m_map{nullptr};
+    size_t m_map_size{0};
+
+    mutable std::mutex m_mutex;
+    std::vector<std::shared_ptr<const Chunk>> m_chunks;
+    std::atomic<uint64_t> m_rows{0};
+    std::atomic<bool> m_finished{false};
+    std::atomic<bool> m_cancelled{false};
+};
+
+#endif
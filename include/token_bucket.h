@@ -0,0 +1,42 @@
+#ifndef _TOKEN_BUCKET_H_
+#define _TOKEN_BUCKET_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+// A token bucket of rate tokens a second holding at most burst, kept as
+// the time it would next be full (GCRA): one atomic, and taking a token
+// is a load and a compare-exchange that only repeats under contention.
+class TokenBucket {
+public:
+    TokenBucket(uint32_t rate, uint32_t burst)
+        : m_interval(1'000'000'000 / std::max<int64_t>(rate, 1)),
+          m_limit(m_interval * std::max<int64_t>(burst, 1)) {}
+
+    // Whether tryAcquire(now) would succeed, without taking the token.
+    bool available(int64_t now) const {
+        const auto full_at = m_full_at.load(std::memory_order::relaxed);
+        return std::max(full_at, now) + m_interval - now <= m_limit;
+    }
+
+    // now is steady_clock nanoseconds. False if the bucket is empty.
+    bool tryAcquire(int64_t now) {
+        auto full_at = m_full_at.load(std::memory_order::relaxed);
+        for (;;) {
+            const auto next = std::max(full_at, now) + m_interval;
+            if (next - now > m_limit)
+                return false;
+            if (m_full_at.compare_exchange_weak(full_at, next,
+                                                std::memory_order::relaxed))
+                return true;
+        }
+    }
+
+private:
+    const int64_t m_interval;
+    const int64_t m_limit;
+    std::atomic<int64_t> m_full_at{0};
+};
+
+#endif
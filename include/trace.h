@@ -0,0 +1,125 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// Static tracepoints along the reply path, so one slow order can be
+// followed through it. Each carries the order's ClOrdID, the session's
+// TargetCompID and a number whose meaning depends on the point:
+//   FromApp      an application message arrived
+//   Match        the rule it matched, -1 for none
+//   Post         handed to the app thread
+//   TimedInsert  a delayed reply was queued, detail is the delay in ms
+//   TimedFire    a delayed reply came due, detail is how late in us
+//   Fill         a reply is being built
+//   Send         replies left, detail is how many; ClOrdID is empty for
+//                a loopTimer batch
+//
+// A point costs one load and a branch unless someone listens. Listeners
+// are the in-process ring below, switched by the trace config or
+// POST /trace and dumped by GET /trace in Chrome trace format, and, when
+// fixsim is built against <sys/sdt.h>, USDT probes for perf and bpftrace:
+//   bpftrace -e 'usdt:./fixsim:fixsim:Fill { printf("%s %s\n",
+//       str(arg0), str(arg1)); }'
+#define FIXSIM_TRACE_POINTS(X) \
+    X(FromApp)                 \
+    X(Match)                   \
+    X(Post)                    \
+    X(TimedInsert)             \
+    X(TimedFire)               \
+    X(Fill)                    \
+    X(Send)
+
+enum class TracePoint : uint8_t {
+#define FIXSIM_TRACE_ENUM(point) point,
+    FIXSIM_TRACE_POINTS(FIXSIM_TRACE_ENUM)
+#undef FIXSIM_TRACE_ENUM
+};
+
+std::string_view traceName(TracePoint);
+
+// A fixed ring of events written by any thread without a lock. Each slot
+// carries the sequence number it was written for, so a dump skips the
+// slots that are being overwritten instead of reading them torn. Two
+// writers only share a slot if the ring wraps during one write.
+class TraceRing {
+public:
+    static constexpr size_t kDefaultCapacity = 1 << 16;
+
+    // The first start allocates capacity events, rounded up to a power of
+    // two; later ones keep the ring. Safe to call from any thread.
+    void start(size_t capacity = kDefaultCapacity);
+    void stop() { m_enabled.store(false, std::memory_order::relaxed); }
+    bool enabled() const { return m_enabled.load(std::memory_order::acquire); }
+
+    // Strings longer than an event's field are cut.
+    void record(TracePoint, std::string_view cl_ord_id,
+                std::string_view session, int64_t detail);
+    // {"traceEvents": [...]} with an instant event per point, oldest
+    // first, and the name of every thread that recorded one.
+    std::string chromeJson() const;
+
+private:
+    struct Event {
+        std::atomic<uint64_t> seq{0};
+        int64_t time;
+        int64_t detail;
+        TracePoint point;
+        uint8_t thread;
+        char cl_ord_id[38];
+        char session[32];
+    };
+    static constexpr size_t kMaxThreads = 256;
+
+    uint8_t threadIndex();
+
+    std::atomic<bool> m_enabled{false};
+    mutable std::mutex m_start_mutex;
+    std::unique_ptr<Event[]> m_events;
+    size_t m_mask{0};
+    std::atomic<uint64_t> m_next{0};
+    std::atomic<size_t> m_threads{0};
+    std::array<std::array<char, 16>, kMaxThreads> m_thread_names{};
+};
+
+extern TraceRing g_trace;
+
+#if __has_include(<sys/sdt.h>)
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+// Raised by perf or bpftrace while they are attached to the probe.
+#define FIXSIM_TRACE_SEMAPHORE(point) \
+    extern "C" volatile unsigned short fixsim_##point##_semaphore;
+FIXSIM_TRACE_POINTS(FIXSIM_TRACE_SEMAPHORE)
+#undef FIXSIM_TRACE_SEMAPHORE
+#define FIXSIM_USDT_ACTIVE(point) (fixsim_##point##_semaphore != 0)
+#define FIXSIM_USDT_PROBE(point, cl_ord_id, session, detail) \
+    DTRACE_PROBE3(fixsim, point, cl_ord_id, session, detail)
+#else
+#define FIXSIM_USDT_ACTIVE(point) false
+#define FIXSIM_USDT_PROBE(point, cl_ord_id, session, detail)
+#endif
+
+// cl_ord_id is only evaluated when the point is listened to. It must
+// yield a string_view of a NUL-terminated string, which the probe hands
+// out as a C string.
+#define FIXSIM_TRACE(point, cl_ord_id, id, detail)                          \
+    do {                                                                    \
+        if (g_trace.enabled() || FIXSIM_USDT_ACTIVE(point)) [[unlikely]] {  \
+            const std::string_view fixsim_cl_ord_id = (cl_ord_id);          \
+            const auto &fixsim_session = (id).getTargetCompID().getString(); \
+            const int64_t fixsim_detail = (detail);                         \
+            FIXSIM_USDT_PROBE(point, fixsim_cl_ord_id.data(),               \
+                              fixsim_session.c_str(), fixsim_detail);       \
+            g_trace.record(TracePoint::point, fixsim_cl_ord_id,             \
+                           fixsim_session, fixsim_detail);                  \
+        }                                                                   \
+    } while (0)
+
+#endif
@@ -3,213 +3,230 @@
 #include <chrono>
 #include <cstdint>
 #include <format>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <ranges>
-#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
-#include <thread>
 #include <unordered_map>
 #include <utility>
 
 #include <quickfix/FixFieldNumbers.h>
 #include <quickfix/Message.h>
 #include <quickfix/Session.h>
-#include <quickfix/fix40/ExecutionReport.h>
-#include <quickfix/fix41/ExecutionReport.h>
-#include <quickfix/fix42/ExecutionReport.h>
-#include <quickfix/fix43/ExecutionReport.h>
-#include <quickfix/fix44/ExecutionReport.h>
-#include <quickfix/fix50/ExecutionReport.h>
-
-#include <quickfix/fix40/OrderCancelReject.h>
-#include <quickfix/fix41/OrderCancelReject.h>
-#include <quickfix/fix42/OrderCancelReject.h>
-#include <quickfix/fix43/OrderCancelReject.h>
-#include <quickfix/fix44/OrderCancelReject.h>
-#include <quickfix/fix50/OrderCancelReject.h>
-
-#include <quickfix/fix42/TradingSessionStatus.h>
-#include <quickfix/fix43/TradingSessionStatus.h>
-#include <quickfix/fix44/TradingSessionStatus.h>
-#include <quickfix/fix50/TradingSessionStatus.h>
-
-#include <httplib.h>
 #include <spdlog/spdlog.h>
-#include <uuid/uuid.h>
 #include <asio/as_tuple.hpp>
 #include <asio/post.hpp>
-#include <pugixml.hpp>
 
 #include "application.h"
-
-namespace detail {
-
-template <typename C>
-struct to_helper {};
-
-template <typename Container, std::ranges::range R>
-    requires std::convertible_to<std::ranges::range_value_t<R>,
-                                 typename Container::value_type>
-Container operator|(R &&r, to_helper<Container>) {
-    return Container{r.begin(), r.end()};
-}
-
-}  // namespace detail
-
-template <std::ranges::range Container>
-    requires(!std::ranges::view<Container>)
-inline auto to() {
-    return detail::to_helper<Container>{};
-}
+#include "builtin.h"
+#include "fix_encoder.h"
+#include "http_server.h"
+#include "trace.h"
 
 namespace {
 
-auto spilt(const std::string &line, char flag) {
-    return line | std::views::split(flag) |
-           std::views::transform([](auto &&rng) {
-               return std::string(&*rng.begin(), std::ranges::distance(
-                                                     rng.begin(), rng.end()));
-           }) |
-           to<std::vector<std::string>>();
-}
-
-std::string getValue(const std::string &value) {
-    auto ret =
-        value | std::views::split('.') | std::views::transform([](auto &&rng) {
-            return std::string_view(
-                &*rng.begin(), std::ranges::distance(rng.begin(), rng.end()));
-        }) |
-        to<std::vector<std::string_view>>();
-    if (ret.size() != 2) {
-        SPDLOG_ERROR("invalid: {}", value);
-        exit(1);
-    }
-    return std::string{ret[1]};
-}
-
-std::string getTzDateTime(std::string_view fmt = "{:%Y%m%d-%H:%M:%S}") {
-    using namespace std::chrono;
-    auto now = system_clock::now();
-    auto now_ms = time_point_cast<milliseconds>(now);
-    auto tz = locate_zone("UTC");
-    zoned_time zt{tz, now_ms};
-    return std::vformat(fmt, std::make_format_args(zt));
+// The order's ClOrdID for tracepoints, empty if it has none.
+std::string_view clOrdId(const FIX::Message &msg) {
+    if (!msg.isSetField(FIX::FIELD::ClOrdID))
+        return "";
+    return msg.getField(FIX::FIELD::ClOrdID);
 }
 
-std::string getTzDateTimeNoMs(std::string_view fmt = "{:%Y%m%d-%H:%M:%S}") {
-    using namespace std::chrono;
-    auto now = system_clock::now();
-    auto now_ms = time_point_cast<seconds>(now);
-    auto tz = locate_zone("UTC");
-    zoned_time zt{tz, now_ms};
-    return std::vformat(fmt, std::make_format_args(zt));
+std::function<std::string()> transactTimeFunc(const std::string &name) {
+    if (name == "getTzDateTimeNoMs")
+        return [] { return getTzDateTimeNoMs(); };
+    return [] { return getTzDateTime(); };
 }
 
-std::string uuid() {
-    uuid_t uuid;
-    char uuid_str[37]{};
-    uuid_generate_random(uuid);
-    uuid_unparse(uuid, uuid_str);
-    std::string value(uuid_str);
-    std::ranges::replace(value, '-', '.');
-    return value;
+// count, p50, p99 and max in microseconds.
+nlohmann::json latencyJson(const Histogram &latency) {
+    auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1e3; };
+    return {
+        {"count", latency.count()},
+        {"p50", us(latency.percentile(0.5))},
+        {"p99", us(latency.percentile(0.99))},
+        {"max", us(latency.max())},
+    };
 }
 
-std::string randomNumber(int min = 1000, int max = 9999) {
-    thread_local std::mt19937 gen(std::random_device{}());
-    std::uniform_int_distribution<> dist(min, max);
-    return std::to_string(dist(gen));
+// Runs f on ctx and resumes the caller once it has returned or thrown.
+template <typename F>
+asio::awaitable<void> runOn(asio::io_context &ctx, F &&f) {
+    co_await asio::co_spawn(
+        ctx,
+        [&]() -> asio::awaitable<void> {
+            f();
+            co_return;
+        },
+        asio::use_awaitable);
 }
 
-std::string increment() {
-    static std::atomic_uint64_t init_value = 1;
-    return std::to_string(init_value.fetch_add(1, std::memory_order::relaxed));
+// "a, b,c" -> {"a", "b", "c"}
+std::vector<std::string_view> splitList(std::string_view list) {
+    std::vector<std::string_view> names;
+    for (auto item : list | std::views::split(',')) {
+        std::string_view name(item.begin(), item.end());
+        while (!name.empty() && name.front() == ' ')
+            name.remove_prefix(1);
+        while (!name.empty() && name.back() == ' ')
+            name.remove_suffix(1);
+        if (!name.empty())
+            names.push_back(name);
+    }
+    return names;
 }
 
 }  // namespace
 
 Application::Application(std::shared_ptr<asio::io_context> ctx,
                          const Config &cfg)
-    : m_io_ctx(std::move(ctx)), m_cfg(cfg) {
+    : m_io_ctx(std::move(ctx)),
+      m_cfg(cfg),
+      m_pool("worker", cfg.topology ? cfg.topology->worker : std::nullopt) {
+    // The most specific rule is tried first.
+    std::ranges::sort(m_cfg.custom_reply, [](auto &p1, auto &p2) {
+        return (p1.check_condition_header.size() +
+                p1.check_condition_body.size()) >
+               (p2.check_condition_header.size() +
+                p2.check_condition_body.size());
+    });
+    // Every template is parsed here, so a malformed one stops the startup
+    // with all of them listed instead of failing on the first order.
+    std::string errors;
+    for (const auto &[path, map] : replyMaps()) {
+        std::vector<FieldTemplate> fields;
+        fields.reserve(map->size());
+        for (const auto &[tag, value] : *map) {
+            try {
+                fields.push_back(FieldTemplate::parse(tag, value));
+            } catch (const std::exception &e) {
+                errors += std::format("\n  {}: {}", path, e.what());
+            }
+        }
+        m_templates.emplace(map, std::move(fields));
+    }
+    for (size_t i = 0; i < m_cfg.custom_reply.size(); ++i) {
+        const auto &rule = m_cfg.custom_reply[i];
+        try {
+            m_conditions.push_back(
+                {parseConditions(rule.check_condition_header),
+                 parseConditions(rule.check_condition_body)});
+        } catch (const std::exception &e) {
+            errors += std::format("\n  custom_reply[{}]: {}", i, e.what());
+        }
+    }
+    m_templates.emplace(&m_no_fields, std::vector<FieldTemplate>{});
+    for (size_t i = 0; i < m_cfg.custom_reply.size(); ++i) {
+        if (const auto &throttle = m_cfg.custom_reply[i].throttle;
+            throttle && throttle->rate == 0)
+            errors +=
+                std::format("\n  custom_reply[{}].throttle: rate is 0", i);
+    }
+    if (m_cfg.throttle) {
+        for (size_t i = 0; i < m_cfg.throttle->size(); ++i) {
+            if (m_cfg.throttle.value()[i].rate == 0)
+                errors += std::format("\n  throttle[{}]: rate is 0", i);
+        }
+    }
+    if (!errors.empty())
+        throw std::invalid_argument("invalid templates:" + errors);
+    if (m_cfg.header.has_value()) {
+        m_header = m_templates.at(&m_cfg.header.value());
+        for (const auto &field : m_header)
+            FixEncoder::appendField(m_header_fields, field.tag, field.value);
+    }
+    if (m_cfg.logon_response.has_value())
+        m_logon_response = compile(m_cfg.logon_response->msgtype,
+                                   m_cfg.logon_response->reply, true);
+    for (const auto &tss : m_cfg.trading_session_status)
+        m_tss.push_back(compile(FIX::MsgType_TradingSessionStatus, tss.reply,
+                                false));
+    m_tss_out.resize(m_tss.size());
+    if (m_cfg.trace && m_cfg.trace->enabled)
+        g_trace.start(
+            m_cfg.trace->capacity.value_or(TraceRing::kDefaultCapacity));
+    m_pool.start();
     asio::co_spawn(*m_io_ctx, loopTimer(), asio::detached);
     asio::co_spawn(*m_io_ctx, clear(), asio::detached);
+    asio::co_spawn(*m_io_ctx, sampleStats(), asio::detached);
+    if (m_cfg.market_data.has_value()) {
+        m_market_data = std::make_unique<MarketDataPublisher>(
+            m_cfg.market_data.value(), m_header_fields);
+        asio::co_spawn(m_pool.context(), m_market_data->run(),
+                       asio::detached);
+    }
 }
 
 void Application::onCreate(const FIX::SessionID &id) {
     SPDLOG_INFO("onCreate: [{}]", id.toString());
-    asio::post(m_pool, [this, id] {
-        m_sessions.emplace(id.toString(), FIX::Session::lookupSession(id));
-    });
+    const auto &begin_string = id.getBeginString().getString();
+    if (const auto *factory = MessageFactory::find(begin_string))
+        m_factories.emplace(id, factory);
+    else
+        SPDLOG_ERROR("unsupported BeginString: {}", begin_string);
 }
 
 void Application::onLogon(const FIX::SessionID &id) {
     SPDLOG_INFO("onLogon: [{}]", id.toString());
     if (m_cfg.trading_session_status.empty())
         return;
-    SPDLOG_INFO("start send Tss: [{}]", id.toString());
-    asio::co_spawn(*m_io_ctx, sendTss(id), [](std::exception_ptr ep) {
-        if (ep) {
-            try {
-                std::rethrow_exception(ep);
-            } catch (const std::exception &e) {
-                SPDLOG_ERROR("Caught exception in completion handler: {}",
-                             e.what());
-            }
-        }
-    });
+    if (auto it = m_factories.find(id);
+        it == m_factories.end() || !it->second->trading_session_status) {
+        SPDLOG_ERROR("no TradingSessionStatus in {}",
+                     id.getBeginString().getString());
+        return;
+    }
+    auto it = m_sessions.find(id.toString());
+    if (it == m_sessions.end() || it->second == nullptr)
+        return;
+    asio::post(*m_io_ctx,
+               [this, session = it->second] { scheduleTss(session); });
 }
 
 void Application::onLogout(const FIX::SessionID &id) {
     SPDLOG_INFO("onLogout: [{}]", id.toString());
+    if (m_market_data)
+        m_market_data->onLogout(id);
 }
 
 void Application::toAdmin(FIX::Message &, const FIX::SessionID &) {}
 
 void Application::toApp(FIX::Message &message, const FIX::SessionID &) {
-    if (!m_cfg.header.has_value())
-        return;
-    for (auto &[tag, value] : m_cfg.header.value()) {
-        if (value.starts_with("bool:")) {
-            FIX::BoolField field(tag, value == "bool:true" ? true : false);
-            message.getHeader().setField(field);
-        } else {
-            message.getHeader().setField(tag, value);
-        }
-    }
+    for (const auto &field : m_header)
+        message.getHeader().setField(field.tag, field.value);
 }
 
-asio::awaitable<void> Application::sendCustomizeLoginResponse(
-    FIX::Message msg, FIX::SessionID id) {
-    SPDLOG_INFO("sendCustomizeLoginResponse: [{}]", id.toString());
-    auto message = std::make_shared<FIX::Message>();
-    message->getHeader().setField(
-        FIX::MsgType(m_cfg.logon_response.value().msgtype));
-    for (auto &[id, value] : m_cfg.logon_response.value().reply) {
-        fillExecReport(message, msg, id, value);
+void Application::sendLogonResponse(const FIX::Message &logon,
+                                    const FIX::SessionID &id) {
+    SPDLOG_INFO("sendLogonResponse: [{}]", id.toString());
+    const auto &reply = m_logon_response.value();
+    if (reply.fields.empty()) {
+        // Nothing to fill in: the body is sent as compiled.
+        OutboundMessage out{reply.msg_type, m_header_fields, reply.constants};
+        dispatch(id, {&out, 1});
+        return;
     }
-    FIX::Session::sendToTarget(*message, id);
-    co_return;
+    OutboundMessage out;
+    build(out, reply, logon);
+    dispatch(id, {&out, 1});
 }
 
 void Application::fromAdmin(const FIX::Message &msg, const FIX::SessionID &id) {
     try {
         FIX::MsgType msgType;
         msg.getHeader().getField(msgType);
-        if (msgType == FIX::MsgType_Logon && m_cfg.logon_response.has_value()) {
-            asio::co_spawn(*m_io_ctx, sendCustomizeLoginResponse(msg, id),
-                           [](std::exception_ptr ep) {
-                               if (ep) {
-                                   try {
-                                       std::rethrow_exception(ep);
-                                   } catch (const std::exception &e) {
-                                       SPDLOG_ERROR(
-                                           "fromAdmin Caught exception in "
-                                           "completion handler: {}",
-                                           e.what());
-                                   }
-                               }
-                           });
+        if (msgType == FIX::MsgType_Logon && m_logon_response) {
+            // Posted, so it goes out after QuickFIX's own Logon reply.
+            asio::post(*m_io_ctx, [this, msg, id] {
+                try {
+                    sendLogonResponse(msg, id);
+                } catch (const std::exception &e) {
+                    SPDLOG_ERROR("logon_response: {}", e.what());
+                }
+            });
         }
     } catch (const std::exception &e) {
         SPDLOG_ERROR("{}", e.what());
@@ -217,43 +234,49 @@ void Application::fromAdmin(const FIX::Message &msg, const FIX::SessionID &id) {
 }
 
 void Application::fromApp(const FIX::Message &msg, const FIX::SessionID &id) {
+    FIXSIM_TRACE(FromApp, clOrdId(msg), id, 0);
+    m_orders_in.add();
     try {
-        for (auto &[check_cond_header, check_cond_body, check_cl_order_id,
-                    default_reply_flow, symbols_reply_flow] :
-             m_cfg.custom_reply) {
-            const auto &hdr = msg.getHeader();
-            const auto &body = msg;
-
-            bool header_match =
-                std::ranges::all_of(check_cond_header, [&](const auto &cond) {
-                    const auto &[field, expected] = cond;
-                    auto value = hdr.getField(field);
-                    if (expected == "optional(none)") {
-                        return true;
-                    }
-                    return value == expected;
-                });
-
-            if (!header_match)
-                continue;
-
-            bool body_match =
-                std::ranges::all_of(check_cond_body, [&](const auto &cond) {
-                    const auto &[field, expected] = cond;
-                    auto value = body.getField(field);
-                    if (expected == "optional(none)") {
-                        return true;
-                    }
-                    return value == expected;
-                });
-
-            if (!body_match)
-                continue;
-
+        SessionThrottles *throttles = nullptr;
+        if (!m_throttles.empty()) {
+            const auto *slot = AsioAcceptor::current();
+            if (slot == nullptr)
+                slot = m_acceptor->slot(id);
+            if (slot != nullptr)
+                throttles = &m_throttles[slot->index];
+        }
+        if (m_market_data && msg.getHeader().getField(FIX::FIELD::MsgType) ==
+                                 FIX::MsgType_MarketDataRequest) {
+            if (throttles && !admit(id, *throttles, nullptr, msg))
+                return;
+            m_market_data->onRequest(msg, id);
+            return;
+        }
+        auto *rule = match(msg);
+        FIXSIM_TRACE(Match, clOrdId(msg), id,
+                     rule ? rule - m_cfg.custom_reply.data() : -1);
+        if (throttles) {
+            Throttle *throttle = nullptr;
+            if (rule && !throttles->rules.empty())
+                throttle =
+                    throttles->rules[rule - m_cfg.custom_reply.data()].get();
+            if (!admit(id, *throttles, throttle, msg))
+                return;
+        }
+        if (rule) {
+            auto &[check_cond_header, check_cond_body, check_cl_order_id,
+                   default_reply_flow, symbols_reply_flow, throttle] = *rule;
             auto msg_ptr = std::make_shared<FIX::Message>(msg);
+            FIXSIM_TRACE(Post, clOrdId(msg), id, 0);
             asio::post(*m_io_ctx, [id, this, &default_reply_flow,
                                    &symbols_reply_flow, &check_cl_order_id,
-                                   msg_ptr = std::move(msg_ptr)]() mutable {
+                                   msg_ptr = std::move(msg_ptr),
+                                   posted = std::chrono::steady_clock::now()]()
+                                      mutable {
+                m_queue_latency.record(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - posted)
+                        .count());
                 std::string symbol;
                 try {
                     auto &cl_ord_id = msg_ptr->getField(FIX::FIELD::ClOrdID);
@@ -262,8 +285,7 @@ void Application::fromApp(const FIX::Message &msg, const FIX::SessionID &id) {
                         if (auto result = m_order_ids.insert(cl_ord_id);
                             !result.second) {
                             SPDLOG_INFO("duplicated order: {}", cl_ord_id);
-                            static FixFieldMap map;
-                            send(id, check_cl_order_id, map, *msg_ptr,
+                            send(id, check_cl_order_id, m_no_fields, *msg_ptr,
                                  MsgType::ExecutionReport);
                             return;
                         }
@@ -297,160 +319,338 @@ void Application::fromApp(const FIX::Message &msg, const FIX::SessionID &id) {
     }
 }
 
+Reply *Application::match(const FIX::Message &msg) {
+    auto holds = [](const std::vector<Condition> &conds,
+                    const FIX::FieldMap &map) {
+        return std::ranges::all_of(
+            conds, [&](const auto &cond) { return cond.matches(map); });
+    };
+    for (size_t i = 0; i < m_conditions.size(); ++i) {
+        const auto &[header, body] = m_conditions[i];
+        if (holds(header, msg.getHeader()) && holds(body, msg))
+            return &m_cfg.custom_reply[i];
+    }
+    return nullptr;
+}
+
 void Application::addTimedTask(const FIX::SessionID &id,
                                std::vector<ReplyData> &reply_flow,
                                FixFieldMap &common_fix_fields,
                                const std::shared_ptr<FIX::Message> &msg_ptr) {
+    const MessageFactory *factory;
+    try {
+        factory = &this->factory(id);
+    } catch (const std::exception &e) {
+        SPDLOG_ERROR("{}", e.what());
+        return;
+    }
     std::chrono::milliseconds dut{0};
+    m_immediate.clear();
     for (auto &[fix_fields, interval, msg_type] : reply_flow) {
         if (interval < 0) {
-            send(id, fix_fields, common_fix_fields, *msg_ptr, msg_type);
+            FIXSIM_TRACE(Fill, clOrdId(*msg_ptr), id, 0);
+            if (!buildReply(m_immediate.emplace_back(), *factory, fix_fields,
+                            common_fix_fields, *msg_ptr, msg_type)) {
+                m_immediate.pop_back();
+            }
         } else {
             dut += std::chrono::milliseconds{interval};
             auto expiry = std::chrono::system_clock::now() + dut;
+            FIXSIM_TRACE(TimedInsert, clOrdId(*msg_ptr), id, dut.count());
             m_timed.emplace(expiry,
                             TimedData{.id = id,
+                                      .factory = factory,
                                       .fix_fields = &fix_fields,
                                       .common_fix_fields = &common_fix_fields,
                                       .msg = msg_ptr,
                                       .msg_type = msg_type});
         }
     }
+    if (!m_immediate.empty()) {
+        dispatch(id, m_immediate);
+        FIXSIM_TRACE(Send, clOrdId(*msg_ptr), id, m_immediate.size());
+    }
 }
 
-#define CREATE_FIX_MESSAGE_BY_VERSION(msg_type)         \
-    switch (m_cfg.fix_version) {                        \
-        case FixVersion::FIX40:                         \
-            return std::make_shared<FIX40::msg_type>(); \
-        case FixVersion::FIX41:                         \
-            return std::make_shared<FIX41::msg_type>(); \
-        case FixVersion::FIX42:                         \
-            return std::make_shared<FIX42::msg_type>(); \
-        case FixVersion::FIX43:                         \
-            return std::make_shared<FIX43::msg_type>(); \
-        case FixVersion::FIX44:                         \
-            return std::make_shared<FIX44::msg_type>(); \
-        case FixVersion::FIX50:                         \
-            return std::make_shared<FIX50::msg_type>(); \
-    }                                                   \
-    throw std::runtime_error("Unsupported FIX version");
-
-std::shared_ptr<FIX::Message> Application::createExecutionReport(){
-    CREATE_FIX_MESSAGE_BY_VERSION(ExecutionReport)}
-
-std::shared_ptr<FIX::Message> Application::createOrderCancelReject(){
-    CREATE_FIX_MESSAGE_BY_VERSION(OrderCancelReject)}
-
-std::shared_ptr<FIX::Message> Application::createTradingSessionStatus() {
-    switch (m_cfg.fix_version) {
-        case FixVersion::FIX40:
-        case FixVersion::FIX41: {
-            SPDLOG_DEBUG("error fix version");
-            std::terminate();
-        }
-        case FixVersion::FIX42:
-            return std::make_shared<FIX42::TradingSessionStatus>();
-        case FixVersion::FIX43:
-            return std::make_shared<FIX43::TradingSessionStatus>();
-        case FixVersion::FIX44:
-            return std::make_shared<FIX44::TradingSessionStatus>();
-        case FixVersion::FIX50:
-            return std::make_shared<FIX50::TradingSessionStatus>();
-    }
-    throw std::runtime_error("Unsupported FIX version");
-}
-
-void Application::setField(FIX::Message &message, int tag,
-                           const std::string &value) {
-    if (value == "bool:true" || value == "bool:false") {
-        FIX::BoolField field(tag, value == "bool:true" ? true : false);
-        message.setField(field);
-    } else {
-        message.setField(tag, value);
-    }
-}
-
-void Application::fillExecReport(std::shared_ptr<FIX::Message> &message,
-                                 const FIX::Message &msg, int field,
-                                 const std::string &value) {
-    if (value.starts_with("input.")) {
-        auto val = getValue(value);
-        setField(*message, field, msg.getField(std::stoi(val)));
-    } else if (value.starts_with("if_input.")) {
-        auto val = getValue(value);
-        auto field = std::stoi(val);
-        if (msg.isSetField(field)) {
-            setField(*message, field, msg.getField(field));
-        }
-    } else if (value.starts_with("input_header.")) {
-        auto val = getValue(value);
-        setField(*message, field, msg.getHeader().getField(std::stoi(val)));
-    } else if (value.starts_with("if_input_header.")) {
-        auto val = getValue(value);
-        auto field = std::stoi(val);
-        if (msg.getHeader().isSetField(field)) {
-            setField(*message, field, msg.getHeader().getField(field));
-        }
-    } else if (value.starts_with("call.")) {
-        auto func_name = getValue(value);
-        if (func_name == "uuid") {
-            setField(*message, field, uuid());
-        } else if (func_name == "getTzDateTime") {
-            setField(*message, field, getTzDateTime());
-        } else if (func_name == "randomNumber") {
-            setField(*message, field, randomNumber());
-        } else if (func_name == "increment") {
-            setField(*message, field, increment());
-        } else if (func_name == "createUniqueOrderID") {
-            setField(*message, field, createUniqueOrderID(msg));
-        } else if (func_name == "getTzDateTimeNoMs") {
-            setField(*message, field, getTzDateTimeNoMs());
-        } else {
-            SPDLOG_ERROR("Unrecognized: {}", value);
+const MessageFactory &Application::factory(const FIX::SessionID &id) const {
+    auto it = m_factories.find(id);
+    if (it == m_factories.end())
+        throw std::runtime_error("no message factory for " + id.toString());
+    return *it->second;
+}
+
+template <typename Sink>
+void Application::resolve(const FIX::Message &msg, const FieldTemplate &field,
+                          Sink &&sink) {
+    using enum FieldTemplate::Source;
+    switch (field.source) {
+        case Constant:
+            sink(field.value);
+            return;
+        case Input:
+            sink(msg.getField(field.input_tag));
+            return;
+        case IfInput:
+            if (msg.isSetField(field.input_tag))
+                sink(msg.getField(field.input_tag));
+            return;
+        case InputHeader:
+            sink(msg.getHeader().getField(field.input_tag));
+            return;
+        case IfInputHeader:
+            if (msg.getHeader().isSetField(field.input_tag))
+                sink(msg.getHeader().getField(field.input_tag));
+            return;
+        case Expr:
+            field.expr.evaluate(msg, m_scratch);
+            sink(m_scratch);
+            return;
+        case Group:
+        case InputGroup:
+            // Appended after encode.
+            return;
+        case Call:
+            break;
+    }
+    switch (field.call) {
+        case Builtin::Uuid:
+            sink(uuid());
+            break;
+        case Builtin::GetTzDateTime:
+            sink(getTzDateTime());
+            break;
+        case Builtin::GetTzDateTimeNoMs:
+            sink(getTzDateTimeNoMs());
+            break;
+        case Builtin::RandomNumber:
+            sink(randomNumber());
+            break;
+        case Builtin::Increment:
+            sink(increment());
+            break;
+        case Builtin::CreateUniqueOrderID:
+            sink(createUniqueOrderID(msg));
+            break;
+        case Builtin::MarketPrice: {
+            if (!m_market_data)
+                break;
+            const auto &symbol = msg.getField(FIX::FIELD::Symbol);
+            auto px =
+                m_market_data->quote(symbol, msg.getField(FIX::FIELD::Side)[0]);
+            if (px)
+                sink(px.value());
+            else
+                SPDLOG_ERROR("no market data: {}", symbol);
+            break;
         }
-    } else {
-        setField(*message, field, value);
+    }
+}
+
+void Application::fill(FIX::Message &message, const FIX::Message &msg,
+                       const FieldTemplate &field) {
+    resolve(msg, field, [&](const std::string &value) {
+        message.setField(field.tag, value);
+    });
+}
+
+Application::CompiledReply Application::compile(std::string msg_type,
+                                                 const FixFieldMap &map,
+                                                 bool inputs) const {
+    CompiledReply reply;
+    reply.msg_type = std::move(msg_type);
+    std::vector<const FieldTemplate *> constants;
+    using enum FieldTemplate::Source;
+    for (const auto &field : m_templates.at(&map)) {
+        if (field.source == Constant || field.source == Group)
+            constants.push_back(&field);
+        else if (inputs || field.source == Call ||
+                 (field.source == Expr && field.expr.inputs().empty()))
+            reply.fields.push_back(&field);
+    }
+    auto order = [](const FieldTemplate *a, const FieldTemplate *b) {
+        return std::pair(a->group(), a->tag) < std::pair(b->group(), b->tag);
+    };
+    std::ranges::sort(constants, order);
+    std::ranges::sort(reply.fields, order);
+    const FIX::Message none;
+    for (const auto *field : constants) {
+        if (field->group())
+            field->appendGroup(reply.constants, none);
+        else
+            FixEncoder::appendField(reply.constants, field->tag, field->value);
+    }
+    return reply;
+}
+
+void Application::build(OutboundMessage &out, const CompiledReply &reply,
+                        const FIX::Message &msg) {
+    out.msg_type = reply.msg_type;
+    out.header = m_header_fields;
+    out.body = reply.constants;
+    for (const auto *field : reply.fields) {
+        if (field->group())
+            field->appendGroup(out.body, msg);
+        else
+            resolve(msg, *field, [&](std::string_view value) {
+                FixEncoder::appendField(out.body, field->tag, value);
+            });
     }
 }
 
 void Application::send(const FIX::SessionID &id, const FixFieldMap &fix_fields,
                        const FixFieldMap &common_fix_fields,
                        const FIX::Message &msg, MsgType msg_type) {
+    OutboundMessage out;
+    FIXSIM_TRACE(Fill, clOrdId(msg), id, 0);
     try {
-        std::shared_ptr<FIX::Message> message;
-        if (msg_type == MsgType::ExecutionReport)
-            message = createExecutionReport();
-        else
-            message = createOrderCancelReject();
-        for (const auto &[field, value] : common_fix_fields) {
-            fillExecReport(message, msg, field, value);
+        if (!buildReply(out, factory(id), fix_fields, common_fix_fields, msg,
+                        msg_type))
+            return;
+    } catch (const std::exception &e) {
+        SPDLOG_ERROR("{}", e.what());
+        return;
+    }
+    dispatch(id, {&out, 1});
+    FIXSIM_TRACE(Send, clOrdId(msg), id, 1);
+}
+
+bool Application::buildReply(OutboundMessage &out,
+                             const MessageFactory &factory,
+                             const FixFieldMap &fix_fields,
+                             const FixFieldMap &common_fix_fields,
+                             const FIX::Message &msg, MsgType msg_type) {
+    try {
+        MessageFactory::Create create = nullptr;
+        switch (msg_type) {
+            case MsgType::ExecutionReport:
+                create = factory.execution_report;
+                break;
+            case MsgType::OrderCancelReject:
+                create = factory.order_cancel_reject;
+                break;
+            case MsgType::BusinessMessageReject:
+                create = factory.business_message_reject;
+                break;
+        }
+        if (create == nullptr)
+            throw std::invalid_argument(
+                std::format("no {} in {}", magic_enum::enum_name(msg_type),
+                            factory.begin_string));
+        auto message = create();
+        const auto &common = m_templates.at(&common_fix_fields);
+        const auto &fields = m_templates.at(&fix_fields);
+        for (const auto &field : common)
+            fill(*message, msg, field);
+        for (const auto &field : fields)
+            fill(*message, msg, field);
+        encode(*message, out);
+        // A group in the reply replaces the common one.
+        for (const auto &field : common) {
+            if (field.group() && std::ranges::none_of(fields, [&](auto &f) {
+                    return f.tag == field.tag;
+                }))
+                field.appendGroup(out.body, msg);
         }
-        for (const auto &[field, value] : fix_fields) {
-            fillExecReport(message, msg, field, value);
+        for (const auto &field : fields) {
+            if (field.group())
+                field.appendGroup(out.body, msg);
         }
-        FIX::Session::sendToTarget(*message, id);
+        return true;
     } catch (const std::exception &e) {
         SPDLOG_ERROR("{}", e.what());
+        return false;
     }
 }
 
-asio::awaitable<void> Application::sendTss(FIX::SessionID id) {
-    asio::steady_timer timer(*m_io_ctx);
-    for (auto &[reply, interval] : m_cfg.trading_session_status) {
-        auto message = createTradingSessionStatus();
-        for (auto &[tag, value] : reply) {
-            setField(*message, tag, value);
+void Application::encode(const FIX::Message &message, OutboundMessage &out) {
+    out.msg_type = message.getHeader().getField(FIX::FIELD::MsgType);
+    out.header = m_header_fields;
+    out.body.clear();
+    FixEncoder::appendFields(out.body, message);
+}
+
+void Application::dispatch(const FIX::SessionID &id,
+                           std::span<const OutboundMessage> msgs) {
+    try {
+        // Only what the client can get, now or by resend, is mirrored.
+        if (m_acceptor->send(id, msgs) == SendResult::Dropped ||
+            m_drop_copies.empty())
+            return;
+        // Reused by each calling thread.
+        thread_local std::vector<std::string_view> bodies;
+        bodies.clear();
+        for (const auto &msg : msgs) {
+            if (msg.msg_type == FIX::MsgType_ExecutionReport)
+                bodies.push_back(msg.body);
         }
-        if (interval < 0) {
-            FIX::Session::sendToTarget(*message, id);
+        dropCopy(id, bodies);
+    } catch (const std::exception &e) {
+        SPDLOG_ERROR("{}", e.what());
+    }
+}
+
+void Application::dispatch(const FIX::SessionID &id,
+                           const StressScenario &scenario,
+                           std::span<const std::string_view> bodies) {
+    try {
+        const auto result = m_acceptor->send(id, scenario.msgType(),
+                                             scenario.header(), bodies);
+        if (result != SendResult::Dropped &&
+            scenario.msgType() == FIX::MsgType_ExecutionReport)
+            dropCopy(id, bodies);
+    } catch (const std::exception &e) {
+        SPDLOG_ERROR("{}", e.what());
+    }
+}
+
+void Application::dropCopy(const FIX::SessionID &id,
+                           std::span<const std::string_view> bodies) {
+    if (bodies.empty())
+        return;
+    auto it = m_drop_copy_headers.find(id);
+    if (it == m_drop_copy_headers.end())
+        return;
+    for (auto *session : m_drop_copies)
+        m_acceptor->send(session->getSessionID(), FIX::MsgType_ExecutionReport,
+                         it->second, bodies);
+}
+
+void Application::scheduleTss(FIX::Session *session) {
+    const auto generation = ++m_tss_generation[session];
+    auto due = std::chrono::steady_clock::now();
+    due += std::chrono::milliseconds(
+        std::max(m_cfg.trading_session_status.front().interval, 0));
+    m_tss_due.emplace(due, TssStep{session, 0, generation});
+}
+
+void Application::sendDueTss(std::chrono::steady_clock::time_point now) {
+    if (m_tss_due.empty() || m_tss_due.begin()->first > now)
+        return;
+    m_tss_built.assign(m_tss.size(), false);
+    // There is no request to copy from; input.* fields are left out.
+    const FIX::Message none;
+    while (!m_tss_due.empty() && m_tss_due.begin()->first <= now) {
+        auto node = m_tss_due.extract(m_tss_due.begin());
+        auto &[session, step, generation] = node.mapped();
+        if (generation != m_tss_generation[session] || !session->isLoggedOn())
             continue;
+        if (!m_tss_built[step]) {
+            try {
+                build(m_tss_out[step], m_tss[step], none);
+            } catch (const std::exception &e) {
+                SPDLOG_ERROR("trading_session_status[{}]: {}", step, e.what());
+                continue;
+            }
+            m_tss_built[step] = true;
         }
-        timer.expires_after(std::chrono::milliseconds(interval));
-        auto [ec] =
-            co_await timer.async_wait(asio::as_tuple(asio::use_awaitable));
-        if (ec)
-            break;
-        FIX::Session::sendToTarget(*message, id);
+        dispatch(session->getSessionID(), {&m_tss_out[step], 1});
+        // A negative interval follows the previous step at once, in this
+        // same tick.
+        if (++step == m_tss.size())
+            continue;
+        node.key() += std::chrono::milliseconds(
+            std::max(m_cfg.trading_session_status[step].interval, 0));
+        m_tss_due.insert(std::move(node));
     }
 }
 
@@ -462,15 +662,39 @@ asio::awaitable<void> Application::loopTimer() {
             co_await timer.async_wait(asio::as_tuple(asio::use_awaitable));
         if (ec)
             break;
+        sendDueTss(std::chrono::steady_clock::now());
         if (m_pause.load(std::memory_order::relaxed)) {
             continue;
         }
-        const auto now = std::chrono::system_clock::now();
-        while (!m_timed.empty() && m_timed.begin()->first <= now) {
-            auto data = std::move(m_timed.begin()->second);
-            m_timed.erase(m_timed.begin());
-            auto &[id, fix_fields, common_fix_fields, msg, msg_type] = data;
-            send(id, *fix_fields, *common_fix_fields, *msg, msg_type);
+        collectDue(std::chrono::system_clock::now());
+        for (auto &[id, batch] : m_batches) {
+            if (batch.empty())
+                continue;
+            dispatch(id, batch);
+            FIXSIM_TRACE(Send, "", id, batch.size());
+            batch.clear();
+        }
+    }
+}
+
+void Application::collectDue(std::chrono::system_clock::time_point now) {
+    while (!m_timed.empty() && m_timed.begin()->first <= now) {
+        const auto due = m_timed.begin()->first;
+        auto data = std::move(m_timed.begin()->second);
+        m_timed.erase(m_timed.begin());
+        auto &[id, factory, fix_fields, common_fix_fields, msg, msg_type] =
+            data;
+        const auto late =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - due);
+        m_timer_lateness.record(late.count());
+        FIXSIM_TRACE(TimedFire, clOrdId(*msg), id,
+                     std::chrono::duration_cast<std::chrono::microseconds>(late)
+                         .count());
+        FIXSIM_TRACE(Fill, clOrdId(*msg), id, 0);
+        auto &batch = m_batches[id];
+        if (!buildReply(batch.emplace_back(), *factory, *fix_fields,
+                        *common_fix_fields, *msg, msg_type)) {
+            batch.pop_back();
         }
     }
 }
@@ -492,256 +716,672 @@ asio::awaitable<void> Application::clear() {
     }
 }
 
-void Application::parseXml(const std::string &xml) {
-    pugi::xml_document doc;
-    if (!doc.load_file(xml.c_str())) {
-        SPDLOG_ERROR("Failed to load XML: {}", xml);
-        return;
-    }
-    pugi::xml_node fields = doc.child("fix").child("fields");
-    for (pugi::xml_node field : fields.children("field")) {
-        std::string name = field.attribute("name").as_string();
-        int number = field.attribute("number").as_int();
-        std::string type = field.attribute("type").as_string();
-        nlohmann::json json;
-        if (type == "CHAR" || type == "BOOLEAN") {
-            for (pugi::xml_node value : field.children("value")) {
-                std::string enum_val = value.attribute("enum").as_string();
-                std::string desc = value.attribute("description").as_string();
-                nlohmann::json enum_json;
-                enum_json["value"] = enum_val;
-                enum_json["description"] = desc;
-                json["enum"].emplace_back(enum_json);
+asio::awaitable<void> Application::sampleStats() {
+    asio::steady_timer timer(*m_io_ctx);
+    auto last = std::chrono::steady_clock::now();
+    uint64_t last_in = 0;
+    uint64_t last_out = 0;
+    for (;;) {
+        timer.expires_after(std::chrono::seconds(1));
+        auto [ec] =
+            co_await timer.async_wait(asio::as_tuple(asio::use_awaitable));
+        if (ec)
+            break;
+        const auto now = std::chrono::steady_clock::now();
+        const auto seconds =
+            std::chrono::duration<double>(now - last).count();
+        const auto in = m_orders_in.load();
+        uint64_t out = 0;
+        size_t logged_on = 0;
+        if (m_acceptor) {
+            for (const auto &[name, slot] : m_acceptor->slots()) {
+                out += slot->sent.load(std::memory_order::relaxed);
+                logged_on += slot->session->isLoggedOn() ? 1 : 0;
             }
         }
-        m_tag_list[std::to_string(number)]["name"] = name;
-        m_tag_list[std::to_string(number)]["type"] = type;
-        json["tag"] = number;
-        json["type"] = type;
-        m_tag_mapping[name] = std::move(json);
+        nlohmann::json json{
+            {"orders_in", in},
+            {"messages_out", out},
+            {"throttled", m_throttled.load()},
+            {"orders_in_per_second", (in - last_in) / seconds},
+            {"messages_out_per_second", (out - last_out) / seconds},
+            {"logged_on", logged_on},
+            {"pending_replies", m_timed.size()},
+            {"paused", m_pause.load()},
+            {"queue_latency_us", latencyJson(m_queue_latency)},
+            {"timer_lateness_us", latencyJson(m_timer_lateness)},
+        };
+        m_queue_latency.reset();
+        m_timer_lateness.reset();
+        last = now;
+        last_in = in;
+        last_out = out;
+        std::lock_guard lk(m_stats_mutex);
+        m_stats = json.dump();
     }
-    auto parse_interface = [&](const std::string &interface_name) {
-        nlohmann::json json;
-        pugi::xml_node node =
-            doc.child("fix")
-                .child("messages")
-                .find_child_by_attribute("message", "name",
-                                         interface_name.c_str());
-        if (node) {
-            json["MsgType"] = node.attribute("msgtype").value();
-            json["Name"] = node.attribute("name").value();
-            for (pugi::xml_node field : node.children("field")) {
-                auto name = field.attribute("name").value();
-                auto &tag_json = m_tag_mapping[name];
-                json["Field"][name]["tag"] = tag_json["tag"];
-                json["Field"][name]["type"] = tag_json["type"];
-                json["Field"][name]["required"] =
-                    field.attribute("required").value();
-                if (tag_json.contains("enum")) {
-                    json["Field"][name]["enum"] = tag_json["enum"];
-                }
+}
+
+std::string Application::stats() const {
+    std::lock_guard lk(m_stats_mutex);
+    return m_stats;
+}
+
+asio::awaitable<void> Application::publishMetrics() {
+    asio::steady_timer timer(*m_io_ctx);
+    const std::chrono::milliseconds interval(
+        m_cfg.metrics->interval.value_or(100));
+    for (;;) {
+        timer.expires_after(interval);
+        auto [ec] =
+            co_await timer.async_wait(asio::as_tuple(asio::use_awaitable));
+        if (ec)
+            break;
+        m_metrics->update([&](ShmMetricsSample &sample,
+                              ShmSessionMetrics *sessions) {
+            sample.time =
+                std::chrono::steady_clock::now().time_since_epoch().count();
+            sample.orders_in = m_orders_in.load();
+            sample.stress_sent = m_stress_sent.load();
+            sample.timed = m_timed.size();
+            sample.order_ids = m_order_ids.size();
+            sample.order_mappings = m_ClOrdID_OrderID_mapping.size();
+            sample.log_backlog = m_log_rotator ? m_log_rotator->backlog() : 0;
+            for (size_t i = 0; i < m_metric_slots.size(); ++i) {
+                const auto &slot = *m_metric_slots[i];
+                auto &out = sessions[i];
+                out.messages_in = slot.received.load(std::memory_order::relaxed);
+                out.messages_out = slot.sent.load(std::memory_order::relaxed);
+                out.queued_bytes =
+                    slot.queued_bytes.load(std::memory_order::relaxed);
+                out.dropped = slot.dropped.load(std::memory_order::relaxed);
+                out.logged_on = slot.session->isLoggedOn();
+                out.congested = slot.congested.load(std::memory_order::relaxed);
             }
-            for (pugi::xml_node field : node.children("group")) {
-                auto name = field.attribute("name").value();
-                auto &tag_json = m_tag_mapping[name];
-                json["Field"][name]["tag"] = tag_json["tag"];
-                json["Field"][name]["type"] = tag_json["type"];
-                json["Field"][name]["required"] =
-                    field.attribute("required").value();
+        });
+    }
+}
+
+void Application::parseXml(const std::string &xml) {
+    try {
+        m_schema = std::make_unique<Schema>(xml);
+        SPDLOG_INFO("{}: {} messages", xml, m_schema->messages());
+    } catch (const std::exception &e) {
+        SPDLOG_ERROR("Failed to load XML: {}", e.what());
+    }
+}
+
+std::vector<std::pair<std::string, const FixFieldMap *>>
+Application::replyMaps() const {
+    std::vector<std::pair<std::string, const FixFieldMap *>> maps;
+    for (size_t i = 0; i < m_cfg.custom_reply.size(); ++i) {
+        const auto &rule = m_cfg.custom_reply[i];
+        const auto prefix = std::format("custom_reply[{}]", i);
+        maps.emplace_back(prefix + ".check_cl_order_id",
+                          &rule.check_cl_order_id);
+        const auto &flow = rule.default_reply_flow;
+        maps.emplace_back(prefix + ".default_reply_flow.common_fields",
+                          &flow.common_fields);
+        for (size_t j = 0; j < flow.reply_flow.size(); ++j)
+            maps.emplace_back(
+                std::format("{}.default_reply_flow.reply_flow[{}]", prefix, j),
+                &flow.reply_flow[j].reply);
+        for (size_t j = 0; j < rule.symbols_reply_flow.size(); ++j) {
+            const auto &symbols = rule.symbols_reply_flow[j];
+            const auto name =
+                std::format("{}.symbols_reply_flow[{}]", prefix, j);
+            maps.emplace_back(name + ".common_fields", &symbols.common_fields);
+            for (size_t k = 0; k < symbols.reply_flow.size(); ++k)
+                maps.emplace_back(std::format("{}.reply_flow[{}]", name, k),
+                                  &symbols.reply_flow[k].reply);
+        }
+        if (rule.throttle.has_value())
+            maps.emplace_back(prefix + ".throttle.reply",
+                              &rule.throttle.value().reply);
+    }
+    if (m_cfg.throttle.has_value()) {
+        for (size_t i = 0; i < m_cfg.throttle->size(); ++i)
+            maps.emplace_back(std::format("throttle[{}].reply", i),
+                              &m_cfg.throttle.value()[i].reply);
+    }
+    if (m_cfg.logon_response.has_value())
+        maps.emplace_back("logon_response.reply",
+                          &m_cfg.logon_response.value().reply);
+    for (size_t i = 0; i < m_cfg.trading_session_status.size(); ++i)
+        maps.emplace_back(std::format("trading_session_status[{}]", i),
+                          &m_cfg.trading_session_status[i].reply);
+    if (m_cfg.header.has_value())
+        maps.emplace_back("header", &m_cfg.header.value());
+    return maps;
+}
+
+std::vector<std::string> Application::check() {
+    if (!m_schema)
+        return {"no data dictionary"};
+    std::vector<std::string> errors;
+    for (const auto &[path, map] : replyMaps()) {
+        for (auto &field : m_templates.at(map)) {
+            if (auto error = field.check(*m_schema); !error.empty())
+                errors.push_back(std::format("{}.{}: {}", path, field.tag,
+                                             error));
+            if (field.source == FieldTemplate::Source::Call &&
+                field.call == Builtin::MarketPrice && !m_market_data)
+                errors.push_back(std::format(
+                    "{}.{}: call.marketPrice needs market_data", path,
+                    field.tag));
+            if (path == "header" &&
+                field.source != FieldTemplate::Source::Constant)
+                errors.push_back(std::format(
+                    "{}.{}: the header only takes constants", path,
+                    field.tag));
+        }
+    }
+    for (size_t i = 0; i < m_conditions.size(); ++i) {
+        const auto &[header, body] = m_conditions[i];
+        for (const auto &[name, conds] :
+             {std::pair{"check_condition_header", &header},
+              std::pair{"check_condition_body", &body}}) {
+            for (const auto &cond : *conds) {
+                if (auto error = cond.check(*m_schema); !error.empty())
+                    errors.push_back(std::format("custom_reply[{}].{}.{}: {}",
+                                                 i, name, cond.tag, error));
             }
         }
-        m_interface_mapping[interface_name] = json;
-    };
-    parse_interface("NewOrderSingle");
-    parse_interface("OrderCancelReplaceRequest");
-    parse_interface("OrderCancelRequest");
-    parse_interface("ExecutionReport");
-    parse_interface("OrderCancelReject");
-    parse_interface("BusinessMessageReject");
-    parse_interface("TradingSessionStatus");
+    }
+    return errors;
+}
+
+void Application::compileScenario(const std::string &csv,
+                                  const std::string &output,
+                                  const std::string &create_time_func) {
+    StressScenario scenario(FIX::MsgType_ExecutionReport, m_header_fields,
+                            transactTimeFunc(create_time_func));
+    scenario.feedFile(csv);
+    scenario.finish();
+    scenario.compile(output, magic_enum::enum_name(m_cfg.fix_version));
+    SPDLOG_INFO("compiled {} rows into {}", scenario.rows(), output);
+}
+
+void Application::setAcceptor(AsioAcceptor *acceptor) {
+    m_acceptor = acceptor;
+    // The acceptor has created every session by now; m_sessions is filled
+    // once here and only read afterwards, from any thread.
+    for (const auto &id : acceptor->getSessions())
+        m_sessions.emplace(id.toString(), acceptor->getSession(id));
+    if (m_market_data)
+        m_market_data->setAcceptor(acceptor);
+    buildDropCopies();
+    buildThrottles();
+    if (m_cfg.metrics) {
+        std::vector<std::string> names;
+        for (const auto &[name, slot] : acceptor->slots()) {
+            names.push_back(name);
+            m_metric_slots.push_back(slot.get());
+        }
+        const auto name = m_cfg.metrics->name.value_or("fixsim");
+        try {
+            m_metrics = std::make_unique<ShmMetricsWriter>(name, names);
+            asio::co_spawn(*m_io_ctx, publishMetrics(), asio::detached);
+            SPDLOG_INFO("metrics: /dev/shm/{}", name);
+        } catch (const std::exception &e) {
+            SPDLOG_ERROR("{}", e.what());
+        }
+    }
+}
+
+void Application::buildDropCopies() {
+    if (!m_cfg.drop_copy || m_cfg.drop_copy->sessions.empty())
+        return;
+    m_drop_copies = findSessions(std::vector<std::string_view>(
+        m_cfg.drop_copy->sessions.begin(), m_cfg.drop_copy->sessions.end()));
+    if (m_drop_copies.empty())
+        SPDLOG_ERROR("no drop-copy session found");
+    for (const auto &[name, session] : m_sessions) {
+        if (!session || std::ranges::find(m_drop_copies, session) !=
+                            m_drop_copies.end())
+            continue;
+        const auto &id = session->getSessionID();
+        auto header = m_header_fields;
+        FixEncoder::appendField(header, FIX::FIELD::OnBehalfOfCompID,
+                                id.getTargetCompID().getString());
+        m_drop_copy_headers.emplace(id, std::move(header));
+    }
 }
 
 void Application::startHttpServer() {
-    auto http_server = std::make_shared<httplib::Server>();
-    auto route = [&](const std::string &path) {
-        auto handler = [this, path](const httplib::Request &req_path,
-                                    httplib::Response &res) {
-            if (req_path.path.ends_with("Yaml")) {
-                std::stringstream ss_y;
-                std::stringstream ss_n;
-                for (auto &[key, value] :
-                     m_interface_mapping[path]["Field"].items()) {
-                    if (value["required"].get<std::string>() == "Y") {
-                        ss_y << std::format(
-                            "{}: {} # {}, required({}), type({})\n",
-                            value["tag"].get<int>(), R"("")", key,
-                            value["required"].get<std::string>(),
-                            value["type"].get<std::string>());
-                    } else {
-                        ss_n << std::format(
-                            "{}: {} # {}, required({}), type({})\n",
-                            value["tag"].get<int>(), R"("")", key,
-                            value["required"].get<std::string>(),
-                            value["type"].get<std::string>());
-                    }
-                }
-                res.set_content(ss_y.str() + ss_n.str(), "text/plain");
-            } else {
-                res.set_content(m_interface_mapping[path].dump(),
-                                "application/json");
-            }
-        };
-        http_server->Get(std::format("/{}", path), handler);
-        http_server->Get(std::format("/{}Yaml", path), handler);
-    };
-    route("NewOrderSingle");
-    route("OrderCancelReplaceRequest");
-    route("OrderCancelRequest");
-    route("ExecutionReport");
-    route("OrderCancelReject");
-    route("BusinessMessageReject");
-    route("TradingSessionStatus");
-    http_server->Get("/tag_list",
-                     [this](const httplib::Request &, httplib::Response &res) {
-                         res.set_content(m_tag_list.dump(), "application/json");
-                     });
+    m_http = std::make_unique<HttpServer>(
+        "http", m_cfg.topology ? m_cfg.topology->http : std::nullopt);
+    auto &http = *m_http;
     // curl -X POST http://127.0.0.1:2025/pause -d '{"flag": true }'
-    http_server->Post(
-        "/pause", [this](const httplib::Request &req, httplib::Response &res) {
-            try {
-                auto j = nlohmann::json::parse(req.body);
-                m_pause.store(j.at("flag").get<bool>());
-                SPDLOG_INFO("pause: {}", m_pause ? "true" : "false");
-            } catch (const std::exception &e) {
-                SPDLOG_ERROR("{}", e.what());
-                res.status = 400;
-                res.set_content("invalid request", "text/plain");
-                return;
-            }
-            res.set_content("success!\n", "text/plain");
-        });
-    http_server->Post(
-        "/stress", [this](const httplib::Request &req, httplib::Response &res) {
+    http.post("/pause", [this](HttpExchange &ex) -> asio::awaitable<void> {
+        try {
+            auto j = nlohmann::json::parse(ex.body());
+            m_pause.store(j.at("flag").get<bool>());
+            SPDLOG_INFO("pause: {}", m_pause ? "true" : "false");
+        } catch (const std::exception &e) {
+            SPDLOG_ERROR("{}", e.what());
+            ex.reply(400, "invalid request");
+            co_return;
+        }
+        ex.reply(200, "success!\n");
+    });
+    // The body is parsed while it is received and sending starts with the
+    // first complete chunk. With a "file" header the csv is read from the
+    // server's own disk instead of the request body, and with a "scenario"
+    // header a file built by `fixsim compile-scenario` is mapped as is.
+    // "sessions" limits the run to some sessions and "rate" caps what each
+    // of them is sent per second; runs for different sessions go on side
+    // by side. Parsing runs on the worker threads, so the upload holds up
+    // no other request.
+    http.post(
+        "/stress",
+        [this](HttpExchange &ex) -> asio::awaitable<void> {
+            std::shared_ptr<StressScenario> scenario;
             try {
-                auto stress_data = spilt(req.body, '\n');
-                if (!stress_data.empty() && stress_data.back().empty()) {
-                    stress_data.pop_back();
-                }
-                SPDLOG_INFO("csv size: {}", stress_data.size());
-                if (stress_data.empty())
-                    return;
-                if (req.has_header("auto_exit") &&
-                    req.get_header_value("auto_exit") == "true") {
-                    m_close_stress.store(true);
-                } else {
-                    m_close_stress.store(false);
-                }
-                std::string create_time_func = "getTzDateTime";
-                if (req.has_header("create_time_func")) {
-                    create_time_func = req.get_header_value("create_time_func");
+                if (ex.header("content-type").starts_with("multipart/"))
+                    throw std::invalid_argument("multipart is not supported");
+                scenario = std::make_shared<StressScenario>(
+                    FIX::MsgType_ExecutionReport, m_header_fields,
+                    transactTimeFunc(
+                        std::string(ex.header("create_time_func"))));
+                if (ex.hasHeader("scenario"))
+                    scenario->load(std::string(ex.header("scenario")),
+                                   magic_enum::enum_name(m_cfg.fix_version));
+                auto targets = findSessions(splitList(ex.header("sessions")));
+                if (targets.empty())
+                    throw std::invalid_argument(
+                        "no such session: " +
+                        std::string(ex.header("sessions")));
+                const uint32_t rate =
+                    ex.hasHeader("rate")
+                        ? std::stoul(std::string(ex.header("rate")))
+                        : 0;
+                startStress(scenario, targets,
+                            ex.header("auto_exit") == "true", rate);
+                if (ex.hasHeader("file")) {
+                    co_await runOn(m_pool.context(), [&] {
+                        scenario->feedFile(std::string(ex.header("file")));
+                    });
+                } else if (!ex.hasHeader("scenario")) {
+                    for (;;) {
+                        auto chunk = co_await ex.read();
+                        // Closed while still uploading.
+                        if (chunk.empty() || scenario->cancelled())
+                            break;
+                        co_await runOn(m_pool.context(),
+                                       [&] { scenario->feed(chunk); });
+                    }
                 }
-                asio::co_spawn(
-                    *m_io_ctx,
-                    startStress(std::move(stress_data), create_time_func),
-                    asio::detached);
+                scenario->finish();
+                SPDLOG_INFO("csv size: {}", scenario->rows());
             } catch (const std::exception &e) {
                 SPDLOG_ERROR("{}", e.what());
-                res.status = 400;
-                res.set_content("invalid request", "text/plain");
-                return;
+                if (scenario)
+                    scenario->cancel();
+                ex.reply(400, "invalid request");
+                co_return;
             }
-            res.set_content("success!\n", "text/plain");
-        });
-    http_server->Get("/close/stress", [this](const httplib::Request &,
-                                             httplib::Response &res) {
-        m_close_stress.store(true);
-        SPDLOG_INFO("close stress: {}", m_close_stress ? "true" : "false");
-        res.set_content("success!\n", "text/plain");
+            ex.reply(200, "success!\n");
+        },
+        true);
+    // curl http://127.0.0.1:2025/sessions
+    http.get("/sessions", [this](HttpExchange &ex) -> asio::awaitable<void> {
+        const auto &limits = m_acceptor->limits();
+        nlohmann::json json;
+        json["policy"] = magic_enum::enum_name(limits.policy);
+        json["high_watermark"] = limits.high_watermark;
+        json["low_watermark"] = limits.low_watermark;
+        json["logon_latency_us"] = latencyJson(m_acceptor->logonLatency());
+        json["sessions"] = nlohmann::json::array();
+        for (const auto &[name, slot] : m_acceptor->slots()) {
+            json["sessions"].push_back({
+                {"session", name},
+                {"logged_on", slot->session->isLoggedOn()},
+                {"sent", slot->sent.load()},
+                {"queued_bytes", slot->queued_bytes.load()},
+                {"congested", slot->congested.load()},
+                {"congestion_events", slot->congestion_events.load()},
+                {"dropped", slot->dropped.load()},
+                {"resent", slot->resent.load()},
+                {"logons", slot->logons.load()},
+                {"logon_latency_us",
+                 static_cast<double>(slot->logon_latency.load()) / 1e3},
+            });
+        }
+        ex.reply(200, json.dump(), "application/json");
+        co_return;
+    });
+    // curl -X POST http://127.0.0.1:2025/fault -d '{"session": "CLIENT1",
+    //     "action": "skip", "count": 100000}'
+    // Breaks a session's outbound sequence on purpose: skip or drop count
+    // seqnums, resend [begin, end] with PossDupFlag, or request a resend
+    // from the client. Without "session" it applies to every session.
+    http.post("/fault", [this](HttpExchange &ex) -> asio::awaitable<void> {
+        try {
+            auto j = nlohmann::json::parse(ex.body());
+            const auto action = j.at("action").get<std::string>();
+            if (action != "skip" && action != "drop" && action != "resend" &&
+                action != "resend_request")
+                throw std::invalid_argument("unknown action: " + action);
+            const auto names = j.value("session", std::string());
+            auto targets = findSessions(splitList(names));
+            if (targets.empty())
+                throw std::invalid_argument("no such session: " + names);
+            const uint32_t count = j.value("count", 0u);
+            const uint32_t begin = j.value("begin", 1u);
+            const uint32_t end = j.value("end", 0u);
+            std::string failed;
+            // A large resend is encoded under the session lock; the http
+            // threads stay free.
+            co_await runOn(m_pool.context(), [&] {
+                for (auto *session : targets) {
+                    const auto &id = session->getSessionID();
+                    bool ok = false;
+                    if (action == "skip")
+                        ok = m_acceptor->skip(id, count);
+                    else if (action == "drop")
+                        ok = m_acceptor->drop(id, count);
+                    else if (action == "resend")
+                        ok = m_acceptor->resend(id, begin, end);
+                    else
+                        ok = m_acceptor->requestResend(id, begin, end);
+                    if (!ok)
+                        failed += " " + id.toString();
+                }
+            });
+            SPDLOG_INFO("fault: {}", j.dump());
+            if (!failed.empty())
+                throw std::runtime_error(
+                    action + " failed, not logged on or nothing to resend:" +
+                    failed);
+        } catch (const std::exception &e) {
+            SPDLOG_ERROR("{}", e.what());
+            ex.reply(400, "invalid request");
+            co_return;
+        }
+        ex.reply(200, "success!\n");
+    });
+    // curl http://127.0.0.1:2025/stats
+    // curl -N http://127.0.0.1:2025/stats/stream
+    // The counters sampled every second, once or as server-sent events.
+    http.get("/stats", [this](HttpExchange &ex) -> asio::awaitable<void> {
+        ex.reply(200, stats(), "application/json");
+        co_return;
+    });
+    http.get("/stats/stream",
+             [this](HttpExchange &ex) -> asio::awaitable<void> {
+                 co_await ex.begin("text/event-stream");
+                 asio::steady_timer timer(co_await asio::this_coro::executor);
+                 for (;;) {
+                     co_await ex.write(std::format("data: {}\n\n", stats()));
+                     timer.expires_after(std::chrono::seconds(1));
+                     co_await timer.async_wait(asio::use_awaitable);
+                 }
+             });
+    // curl -X POST http://127.0.0.1:2025/trace -d '{"enabled": true}'
+    // curl http://127.0.0.1:2025/trace > trace.json
+    // The dump opens in chrome://tracing or ui.perfetto.dev.
+    http.post("/trace", [this](HttpExchange &ex) -> asio::awaitable<void> {
+        try {
+            auto j = nlohmann::json::parse(ex.body());
+            if (j.at("enabled").get<bool>())
+                g_trace.start(m_cfg.trace && m_cfg.trace->capacity
+                                  ? m_cfg.trace->capacity.value()
+                                  : TraceRing::kDefaultCapacity);
+            else
+                g_trace.stop();
+            SPDLOG_INFO("trace: {}", g_trace.enabled());
+        } catch (const std::exception &e) {
+            SPDLOG_ERROR("{}", e.what());
+            ex.reply(400, "invalid request");
+            co_return;
+        }
+        ex.reply(200, "success!\n");
+    });
+    http.get("/trace", [this](HttpExchange &ex) -> asio::awaitable<void> {
+        // Copying out a full ring takes a while; the http threads stay free.
+        std::string json;
+        co_await runOn(m_pool.context(), [&] { json = g_trace.chromeJson(); });
+        ex.reply(200, std::move(json), "application/json");
+    });
+    // curl http://127.0.0.1:2025/close/stress -H "sessions: CLIENT1"
+    // Without "sessions" every run stops.
+    http.get("/close/stress", [this](HttpExchange &ex) -> asio::awaitable<void> {
+        closeStress(splitList(ex.header("sessions")));
+        SPDLOG_INFO("close stress: [{}]", ex.header("sessions"));
+        ex.reply(200, "success!\n");
+        co_return;
     });
-    m_thread = std::thread([http_server, this] {
-        SPDLOG_INFO("start http server at {}:{}", m_cfg.http_server_host,
-                    m_cfg.http_server_port);
-        http_server->listen(m_cfg.http_server_host, m_cfg.http_server_port);
+    // curl http://127.0.0.1:2025/NewOrderSingle
+    // Every document of the schema: a message as json or, with "Yaml"
+    // appended, as a reply skeleton, plus /tag_list and /messages. Exact
+    // routes win over this one.
+    http.get("/*", [this](HttpExchange &ex) -> asio::awaitable<void> {
+        auto doc = m_schema ? m_schema->get(ex.wildcard()) : nullptr;
+        if (!doc) {
+            ex.reply(404, "not found\n");
+            co_return;
+        }
+        ex.setHeader("ETag", doc->etag);
+        const auto if_none_match = ex.header("If-None-Match");
+        if (if_none_match == "*" ||
+            if_none_match.find(doc->etag) != std::string_view::npos) {
+            ex.reply(304, "");
+            co_return;
+        }
+        // Sent from the shared buffer instead of copied into the reply.
+        ex.reply(200, std::shared_ptr<const std::string>(doc, &doc->body),
+                 doc->content_type);
     });
-    m_stop = [http_server] { http_server->stop(); };
+    http.listen(m_cfg.http_server_host, m_cfg.http_server_port);
 }
 
 void Application::stopHttpServer() {
-    m_stop();
-    if (m_thread.joinable())
-        m_thread.join();
+    if (m_http)
+        m_http->stop();
     m_pool.stop();
     m_pool.join();
 }
 
-asio::awaitable<void> Application::startStress(std::vector<std::string> csv,
-                                               std::string create_time_func) {
-    if (csv.empty())
-        co_return;
-    asio::steady_timer timer(m_pool);
-    uint64_t count = 0;
-    std::vector<std::unordered_map<int32_t, std::string>> vec_fix_fields;
-    for (const auto &line : csv) {
-        std::unordered_map<int32_t, std::string> fix_fields;
-        auto vec = spilt(line, ',');
-        for (const auto &str : vec) {
-            auto pair = spilt(str, '=');
-            if (pair.size() != 2) {
-                continue;
-            }
-            fix_fields.emplace(std::stoi(pair.at(0)), pair.at(1));
+std::vector<FIX::Session *> Application::findSessions(
+    const std::vector<std::string_view> &names) const {
+    std::vector<FIX::Session *> targets;
+    for (const auto &[name, session] : m_sessions) {
+        if (!session)
+            continue;
+        const auto &target =
+            session->getSessionID().getTargetCompID().getString();
+        // A drop-copy session only gets mirrors unless it is named.
+        if (names.empty() ? std::ranges::find(m_drop_copies, session) ==
+                                m_drop_copies.end()
+                          : std::ranges::any_of(names, [&](auto n) {
+                                return n == name || n == target;
+                            }))
+            targets.push_back(session);
+    }
+    return targets;
+}
+
+void Application::buildThrottles() {
+    auto targets = [&](const ThrottleConfig &cfg) {
+        auto sessions =
+            findSessions(cfg.sessions ? std::vector<std::string_view>(
+                                            cfg.sessions->begin(),
+                                            cfg.sessions->end())
+                                      : std::vector<std::string_view>{});
+        if (sessions.empty())
+            SPDLOG_ERROR("no throttled session found");
+        return sessions;
+    };
+    auto throttles = [&](FIX::Session *session) -> SessionThrottles & {
+        if (m_throttles.empty())
+            m_throttles.resize(m_acceptor->slots().size());
+        return m_throttles[m_acceptor->slot(session->getSessionID())->index];
+    };
+    if (m_cfg.throttle) {
+        for (const auto &cfg : m_cfg.throttle.value()) {
+            for (auto *session : targets(cfg))
+                throttles(session).session.push_back(
+                    std::make_unique<Throttle>(cfg));
         }
-        vec_fix_fields.emplace_back(std::move(fix_fields));
     }
-    std::vector<std::shared_ptr<FIX::Message>> report;
-    bool flag = ("getTzDateTime" == create_time_func ? true : false);
-    for (const auto &fix_fields : vec_fix_fields) {
-        auto exec_report = createExecutionReport();
-        if (flag) {
-            exec_report->setField(FIX::FIELD::TransactTime, getTzDateTime());
-        } else {
-            exec_report->setField(FIX::FIELD::TransactTime,
-                                  getTzDateTimeNoMs());
-        }
-        for (auto &[tag, value] : fix_fields) {
-            if (tag == FIX::FIELD::ExecID) {
-                exec_report->setField(tag,
-                                      std::format("fixsim.execid.{}", count++));
-            } else {
-                exec_report->setField(tag, value);
-            }
+    for (size_t i = 0; i < m_cfg.custom_reply.size(); ++i) {
+        const auto &cfg = m_cfg.custom_reply[i].throttle;
+        if (!cfg)
+            continue;
+        for (auto *session : targets(cfg.value())) {
+            auto &rules = throttles(session).rules;
+            rules.resize(m_cfg.custom_reply.size());
+            rules[i] = std::make_unique<Throttle>(cfg.value());
         }
-        report.emplace_back(std::move(exec_report));
     }
-    if (!std::ranges::all_of(m_sessions, [](const auto &data) {
-            auto &[id, session] = data;
-            return session && session->isLoggedOn();
-        })) {
-        SPDLOG_ERROR("no logged in session");
+}
+
+bool Application::Throttle::counts(std::string_view msg_type) const {
+    return !cfg->msg_types ||
+           std::ranges::find(cfg->msg_types.value(), msg_type) !=
+               cfg->msg_types->end();
+}
+
+bool Application::admit(const FIX::SessionID &id, SessionThrottles &throttles,
+                        Throttle *rule, const FIX::Message &msg) {
+    const auto now =
+        std::chrono::steady_clock::now().time_since_epoch().count();
+    const std::string_view msg_type =
+        msg.getHeader().getField(FIX::FIELD::MsgType);
+    // Nothing else takes from a session's buckets while its message is
+    // handled, so a bucket found available still is below.
+    auto check = [&](const Throttle &throttle) {
+        if (!throttle.counts(msg_type) || throttle.bucket.available(now))
+            return true;
+        reject(id, *throttle.cfg, msg);
+        return false;
+    };
+    for (const auto &throttle : throttles.session) {
+        if (!check(*throttle))
+            return false;
+    }
+    if (rule && !check(*rule))
+        return false;
+    for (auto &throttle : throttles.session) {
+        if (throttle->counts(msg_type))
+            throttle->bucket.tryAcquire(now);
+    }
+    if (rule && rule->counts(msg_type))
+        rule->bucket.tryAcquire(now);
+    return true;
+}
+
+void Application::reject(const FIX::SessionID &id, const ThrottleConfig &cfg,
+                         const FIX::Message &msg) {
+    m_throttled.add();
+    // The reply templates may call into state of the app thread.
+    auto msg_ptr = std::make_shared<FIX::Message>(msg);
+    asio::post(*m_io_ctx, [this, id, &cfg, msg_ptr = std::move(msg_ptr)] {
+        send(id, cfg.reply, m_no_fields, *msg_ptr, cfg.msg_type);
+    });
+}
+
+void Application::startStress(const std::shared_ptr<StressScenario> &scenario,
+                              const std::vector<FIX::Session *> &targets,
+                              bool auto_exit, uint32_t rate) {
+    if (!std::ranges::all_of(
+            targets, [](auto *session) { return session->isLoggedOn(); })) {
+        SPDLOG_ERROR("not every stress session is logged on");
+    }
+    // One sender per session, so a slow session only holds up itself and
+    // the sessions spread over the worker threads.
+    for (auto *session : targets) {
+        auto stop = std::make_shared<std::atomic_bool>(false);
+        {
+            std::lock_guard lk(m_stress_mutex);
+            m_stress_runs.push_back({session, scenario, stop});
+        }
+        asio::co_spawn(m_pool.context(),
+                       streamStress(scenario, session, std::move(stop),
+                                    auto_exit, rate),
+                       asio::detached);
     }
+}
+
+void Application::closeStress(const std::vector<std::string_view> &sessions) {
+    const auto targets = findSessions(sessions);
+    std::lock_guard lk(m_stress_mutex);
+    std::erase_if(m_stress_runs, [&](const StressRun &run) {
+        if (!sessions.empty() &&
+            std::ranges::find(targets, run.session) == targets.end())
+            return false;
+        run.stop->store(true);
+        if (auto scenario = run.scenario.lock(); scenario && sessions.empty())
+            scenario->cancel();
+        return true;
+    });
+}
+
+asio::awaitable<void> Application::streamStress(
+    std::shared_ptr<StressScenario> scenario, FIX::Session *session,
+    std::shared_ptr<std::atomic_bool> stop, bool auto_exit, uint32_t rate) {
+    asio::steady_timer timer(co_await asio::this_coro::executor);
+    const auto id = session->getSessionID();
+    const bool pause =
+        m_acceptor->limits().policy == BackpressurePolicy::Pause;
+    // The session walks the chunks at its own pace: when congested it stops
+    // where it is and resumes on a later tick, so the rate follows what the
+    // client actually drains. While the csv is still arriving it only gets
+    // the chunks published so far.
+    size_t next = 0;
+    size_t offset = 0;
+    // With a rate, what may be sent, refilled by elapsed time and capped at
+    // one second's worth.
+    double budget = 0;
+    auto last = std::chrono::steady_clock::now();
     for (;;) {
         timer.expires_after(m_cfg.stress_interval);
         auto [ec] =
             co_await timer.async_wait(asio::as_tuple(asio::use_awaitable));
-        if (ec)
+        if (ec || scenario->cancelled() || stop->load())
             break;
-        for (auto &exec_report : report) {
-            try {
-                for (auto &[id, session] : m_sessions) {
-                    if (session && session->isLoggedOn()) {
-                        session->send(*exec_report);
-                    }
-                }
-            } catch (const std::exception &e) {
-                SPDLOG_ERROR("{}", e.what());
-                break;
+        if (!session->isLoggedOn())
+            continue;
+        // Read before the chunks, so a finished scenario is seen whole.
+        const bool finished = scenario->finished();
+        auto chunks = scenario->chunks();
+        if (finished && chunks.empty())
+            break;
+        size_t allowed = std::numeric_limits<size_t>::max();
+        if (rate > 0) {
+            const auto now = std::chrono::steady_clock::now();
+            budget = std::min<double>(
+                budget + rate * std::chrono::duration<double>(now - last)
+                                    .count(),
+                rate);
+            last = now;
+            allowed = static_cast<size_t>(budget);
+        }
+        while (allowed > 0 && next < chunks.size() &&
+               !(pause && m_acceptor->congested(id))) {
+            const std::span<const std::string_view> bodies =
+                chunks[next]->bodies;
+            const auto count = std::min(allowed, bodies.size() - offset);
+            dispatch(id, *scenario, bodies.subspan(offset, count));
+            m_stress_sent.add(count);
+            offset += count;
+            allowed -= count;
+            if (rate > 0)
+                budget -= static_cast<double>(count);
+            if (offset == bodies.size()) {
+                ++next;
+                offset = 0;
             }
         }
-        if (m_close_stress.load(std::memory_order::relaxed)) {
-            break;
+        if (finished && next == chunks.size()) {
+            if (auto_exit)
+                break;
+            next = 0;
         }
     }
-    co_return;
+    std::lock_guard lk(m_stress_mutex);
+    std::erase_if(m_stress_runs,
+                  [&](const StressRun &run) { return run.stop == stop; });
 }
 
 std::string Application::createUniqueOrderID(const FIX::Message &msg) {
@@ -0,0 +1,762 @@
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <quickfix/Exceptions.h>
+#include <quickfix/FieldConvertors.h>
+#include <quickfix/FieldNumbers.h>
+#include <quickfix/FieldTypes.h>
+#include <quickfix/SessionState.h>
+
+#include <spdlog/spdlog.h>
+#include <asio/as_tuple.hpp>
+
+#include "asio_acceptor.h"
+#include "fix_encoder.h"
+
+namespace {
+
+constexpr int kMaxIov = 1024;
+// Frames per write while resending, so the socket starts on a large resend
+// before all of it is encoded.
+constexpr size_t kResendChunk = 4096;
+
+thread_local SessionSlot *t_current = nullptr;
+
+struct CurrentSlot {
+    explicit CurrentSlot(SessionSlot *slot) { t_current = slot; }
+    ~CurrentSlot() { t_current = nullptr; }
+};
+
+bool isAdmin(std::string_view msg_type) {
+    return msg_type.size() == 1 &&
+           std::string_view("0123456A").find(msg_type[0]) !=
+               std::string_view::npos;
+}
+
+// Value of the first field starting with tag ("\x0134=" and the like) in
+// an encoded message, empty if there is none.
+std::string_view fieldOf(std::string_view msg, std::string_view tag) {
+    const auto pos = msg.find(tag);
+    if (pos == std::string_view::npos)
+        return {};
+    const auto value = pos + tag.size();
+    const auto end = msg.find(FixEncoder::SOH, value);
+    return msg.substr(value, end == std::string_view::npos ? end : end - value);
+}
+
+// SequenceReset-GapFill sent as seq, moving the client on to new_seq.
+void gapFill(std::string &out, const SessionSlot &s, FIX::SEQNUM seq,
+             FIX::SEQNUM new_seq, std::string_view sending_time) {
+    std::string header;
+    FixEncoder::appendField(header, FIX::FIELD::MsgType,
+                            FIX::MsgType_SequenceReset);
+    FixEncoder::appendField(header, FIX::FIELD::MsgSeqNum, seq);
+    header += s.comp_ids;
+    FixEncoder::appendField(header, FIX::FIELD::PossDupFlag, "Y");
+    FixEncoder::appendField(header, FIX::FIELD::SendingTime, sending_time);
+    FixEncoder::appendField(header, FIX::FIELD::OrigSendingTime, sending_time);
+    std::string body;
+    FixEncoder::appendField(body, FIX::FIELD::GapFillFlag, "Y");
+    FixEncoder::appendField(body, FIX::FIELD::NewSeqNo, new_seq);
+    FixEncoder::frame(out, s.begin_string, header, body);
+}
+
+}  // namespace
+
+AsioConnection::AsioConnection(asio::ip::tcp::socket socket,
+                               AsioAcceptor &acceptor)
+    : m_socket(std::move(socket)), m_acceptor(acceptor) {}
+
+void AsioConnection::start() {
+    asio::dispatch(m_socket.get_executor(), [self = shared_from_this()] {
+        std::error_code ec;
+        self->m_socket.non_blocking(true, ec);
+        if (ec) {
+            SPDLOG_ERROR("non_blocking: {}", ec.message());
+            self->close();
+            return;
+        }
+        self->doRead();
+    });
+}
+
+void AsioConnection::doRead() {
+    m_socket.async_read_some(
+        asio::buffer(m_read_buf),
+        [self = shared_from_this()](std::error_code ec, size_t n) {
+            if (ec) {
+                self->close();
+                return;
+            }
+            self->m_parser.addToStream(self->m_read_buf.data(), n);
+            std::string msg;
+            try {
+                while (self->m_parser.readFixMessage(msg)) {
+                    self->onMessage(msg);
+                    if (self->m_closed)
+                        return;
+                }
+            } catch (const FIX::MessageParseError &e) {
+                SPDLOG_ERROR("{}", e.what());
+                self->close();
+                return;
+            }
+            self->doRead();
+        });
+}
+
+bool AsioConnection::bindSession(const std::string &msg) {
+    auto *session = FIX::Session::lookupSession(msg, true);
+    if (session == nullptr) {
+        SPDLOG_ERROR("unknown session: [{}]", msg);
+        return false;
+    }
+    const auto id = session->getSessionID();
+    auto *slot = m_acceptor.slot(id);
+    if (slot == nullptr || FIX::Session::isSessionRegistered(id)) {
+        SPDLOG_ERROR("session already connected: [{}]", id.toString());
+        return false;
+    }
+    std::lock_guard lk(slot->mutex);
+    session = FIX::Session::registerSession(id);
+    if (session == nullptr)
+        return false;
+    session->setResponder(this);
+    slot->connection = weak_from_this();
+    m_slot = slot;
+    return true;
+}
+
+void AsioConnection::onMessage(const std::string &msg) {
+    if (m_slot == nullptr && !bindSession(msg)) {
+        close();
+        return;
+    }
+    std::lock_guard lk(m_slot->mutex);
+    m_slot->received.store(
+        m_slot->received.load(std::memory_order::relaxed) + 1,
+        std::memory_order::relaxed);
+    const bool logged_on = m_slot->session->isLoggedOn();
+    CurrentSlot current(m_slot);
+    try {
+        if (!m_acceptor.serveResend(*m_slot, *this, msg))
+            m_slot->session->next(msg, FIX::UtcTimeStamp::now());
+        if (!logged_on && m_slot->session->isLoggedOn()) {
+            m_slot->logons.fetch_add(1, std::memory_order::relaxed);
+            m_slot->logon_at =
+                std::chrono::steady_clock::now().time_since_epoch().count();
+        }
+    } catch (const FIX::InvalidMessage &e) {
+        SPDLOG_ERROR("{}", e.what());
+        if (!m_slot->session->isLoggedOn())
+            close();
+    }
+}
+
+void AsioConnection::write(std::vector<std::string> frames) {
+    size_t bytes = 0;
+    for (const auto &frame : frames)
+        bytes += frame.size();
+    {
+        std::lock_guard lk(m_write_mutex);
+        queued(bytes);
+        if (m_queue.empty()) {
+            m_queue = std::move(frames);
+        } else {
+            std::ranges::move(frames, std::back_inserter(m_queue));
+        }
+        if (m_write_pending)
+            return;
+        m_write_pending = true;
+    }
+    asio::post(m_socket.get_executor(),
+               [self = shared_from_this()] { self->doWrite(); });
+}
+
+bool AsioConnection::send(const std::string &msg) {
+    if (m_slot != nullptr)
+        m_acceptor.recordSent(*m_slot, msg);
+    {
+        std::lock_guard lk(m_write_mutex);
+        queued(msg.size());
+        m_queue.emplace_back(msg);
+        if (m_write_pending)
+            return true;
+        m_write_pending = true;
+    }
+    asio::post(m_socket.get_executor(),
+               [self = shared_from_this()] { self->doWrite(); });
+    return true;
+}
+
+void AsioConnection::disconnect() {
+    asio::post(m_socket.get_executor(),
+               [self = shared_from_this()] { self->close(); });
+}
+
+void AsioConnection::doWrite() {
+    for (;;) {
+        if (m_closed) {
+            // The unwritten part of the current frame and everything after.
+            size_t dropped = 0;
+            for (size_t i = m_write_index; i < m_writing.size(); ++i)
+                dropped += m_writing[i].size();
+            if (m_write_index < m_writing.size())
+                dropped -= m_write_offset;
+            m_writing.clear();
+            m_write_index = 0;
+            m_write_offset = 0;
+            std::lock_guard lk(m_write_mutex);
+            for (const auto &frame : m_queue)
+                dropped += frame.size();
+            written(dropped);
+            m_queue.clear();
+            m_write_pending = false;
+            return;
+        }
+        if (m_write_index == m_writing.size()) {
+            m_writing.clear();
+            m_write_index = 0;
+            m_write_offset = 0;
+            std::lock_guard lk(m_write_mutex);
+            if (m_queue.empty()) {
+                m_write_pending = false;
+                return;
+            }
+            std::swap(m_writing, m_queue);
+        }
+
+        std::array<iovec, kMaxIov> iov;
+        int count = 0;
+        for (size_t i = m_write_index;
+             i < m_writing.size() && count < kMaxIov; ++i, ++count) {
+            const size_t offset = i == m_write_index ? m_write_offset : 0;
+            iov[count].iov_base = m_writing[i].data() + offset;
+            iov[count].iov_len = m_writing[i].size() - offset;
+        }
+        ssize_t n = ::writev(m_socket.native_handle(), iov.data(), count);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                m_socket.async_wait(
+                    asio::ip::tcp::socket::wait_write,
+                    [self = shared_from_this()](std::error_code ec) {
+                        if (ec)
+                            self->close();
+                        self->doWrite();
+                    });
+                return;
+            }
+            SPDLOG_ERROR("writev: {}", std::strerror(errno));
+            close();
+            continue;
+        }
+        auto bytes = static_cast<size_t>(n);
+        written(bytes);
+        while (bytes > 0) {
+            const size_t left =
+                m_writing[m_write_index].size() - m_write_offset;
+            if (bytes < left) {
+                m_write_offset += bytes;
+                break;
+            }
+            bytes -= left;
+            ++m_write_index;
+            m_write_offset = 0;
+        }
+    }
+}
+
+void AsioConnection::queued(size_t bytes) {
+    if (m_slot == nullptr)
+        return;
+    const auto total =
+        m_slot->queued_bytes.fetch_add(bytes, std::memory_order::relaxed) +
+        bytes;
+    if (total >= m_acceptor.limits().high_watermark &&
+        !m_slot->congested.exchange(true, std::memory_order::relaxed)) {
+        m_slot->congestion_events.fetch_add(1, std::memory_order::relaxed);
+        SPDLOG_WARN("[{}] outbound queue at {} bytes",
+                    m_slot->session->getSessionID().toString(), total);
+    }
+}
+
+void AsioConnection::written(size_t bytes) {
+    if (m_slot == nullptr)
+        return;
+    const auto total =
+        m_slot->queued_bytes.fetch_sub(bytes, std::memory_order::relaxed) -
+        bytes;
+    if (total <= m_acceptor.limits().low_watermark &&
+        m_slot->congested.load(std::memory_order::relaxed)) {
+        m_slot->congested.store(false, std::memory_order::relaxed);
+        SPDLOG_INFO("[{}] outbound queue drained",
+                    m_slot->session->getSessionID().toString());
+    }
+}
+
+void AsioConnection::close() {
+    if (m_closed)
+        return;
+    m_closed = true;
+    if (m_slot != nullptr) {
+        std::lock_guard lk(m_slot->mutex);
+        auto *session = m_slot->session;
+        session->disconnect();
+        FIX::Session::unregisterSession(session->getSessionID());
+        m_slot->connection.reset();
+    }
+    std::error_code ec;
+    m_socket.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+    m_socket.close(ec);
+}
+
+AsioAcceptor::AsioAcceptor(FIX::Application &application,
+                           FIX::MessageStoreFactory &store_factory,
+                           const FIX::SessionSettings &settings,
+                           FIX::LogFactory &log_factory,
+                           const std::optional<ThreadConfig> &threads)
+    : FIX::Acceptor(application, store_factory, settings, log_factory),
+      m_pool("fix", threads) {}
+
+AsioAcceptor::~AsioAcceptor() {
+    m_pool.stop();
+}
+
+SessionSlot *AsioAcceptor::slot(const FIX::SessionID &id) {
+    auto it = m_slots.find(id.toString());
+    return it == m_slots.end() ? nullptr : it->second.get();
+}
+
+SessionSlot *AsioAcceptor::current() {
+    return t_current;
+}
+
+size_t AsioAcceptor::queuedBytes(const FIX::SessionID &id) {
+    auto *s = slot(id);
+    return s == nullptr ? 0
+                        : s->queued_bytes.load(std::memory_order::relaxed);
+}
+
+bool AsioAcceptor::congested(const FIX::SessionID &id) {
+    auto *s = slot(id);
+    return s != nullptr && s->congested.load(std::memory_order::relaxed);
+}
+
+Histogram AsioAcceptor::logonLatency() const {
+    std::lock_guard lk(m_logon_mutex);
+    return m_logon_latency;
+}
+
+void AsioAcceptor::onConfigure(const FIX::SessionSettings &settings) {
+    for (const auto &id : getSessions()) {
+        const auto &dict = settings.get(id);
+        auto port = static_cast<uint16_t>(dict.getInt(FIX::SOCKET_ACCEPT_PORT));
+        if (std::ranges::find(m_ports, port) == m_ports.end())
+            m_ports.push_back(port);
+        if (dict.has(FIX::SOCKET_REUSE_ADDRESS))
+            m_reuse_address = dict.getBool(FIX::SOCKET_REUSE_ADDRESS);
+        if (dict.has(FIX::SOCKET_NODELAY))
+            m_no_delay = dict.getBool(FIX::SOCKET_NODELAY);
+
+        auto slot = std::make_unique<SessionSlot>();
+        slot->session = getSession(id);
+        slot->index = static_cast<uint32_t>(m_slots.size());
+        slot->begin_string = id.getBeginString().getString();
+        FixEncoder::appendField(slot->comp_ids, FIX::FIELD::SenderCompID,
+                                id.getSenderCompID().getString());
+        FixEncoder::appendField(slot->comp_ids, FIX::FIELD::TargetCompID,
+                                id.getTargetCompID().getString());
+        // Read as QuickFIX's SessionFactory does, so SendingTime matches what
+        // the session writes itself. Fractions are only valid from FIX.4.2 on.
+        if (dict.has(FIX::MILLISECONDS_IN_TIMESTAMP))
+            slot->timestamp_precision =
+                dict.getBool(FIX::MILLISECONDS_IN_TIMESTAMP) ? 3 : 0;
+        if (dict.has(FIX::TIMESTAMP_PRECISION))
+            slot->timestamp_precision = dict.getInt(FIX::TIMESTAMP_PRECISION);
+        if (slot->begin_string == "FIX.4.0" || slot->begin_string == "FIX.4.1")
+            slot->timestamp_precision = 0;
+        m_slots.emplace(id.toString(), std::move(slot));
+    }
+}
+
+void AsioAcceptor::onInitialize(const FIX::SessionSettings &) {
+    try {
+        for (auto port : m_ports) {
+            auto acceptor = std::make_unique<asio::ip::tcp::acceptor>(
+                m_pool.context());
+            asio::ip::tcp::endpoint endpoint(asio::ip::tcp::v4(), port);
+            acceptor->open(endpoint.protocol());
+            acceptor->set_option(
+                asio::ip::tcp::acceptor::reuse_address(m_reuse_address));
+            acceptor->bind(endpoint);
+            acceptor->listen();
+            SPDLOG_INFO("fix acceptor listen at {}", port);
+            doAccept(*acceptor);
+            m_acceptors.emplace_back(std::move(acceptor));
+        }
+    } catch (const std::exception &e) {
+        throw FIX::RuntimeError(e.what());
+    }
+    asio::co_spawn(m_pool.context(), heartbeat(), asio::detached);
+}
+
+void AsioAcceptor::onStart() {
+    m_pool.run();
+}
+
+bool AsioAcceptor::onPoll() {
+    if (isStopped())
+        return false;
+    m_pool.context().poll();
+    return true;
+}
+
+void AsioAcceptor::onStop() {
+    for (auto &[name, slot] : m_slots) {
+        std::lock_guard lk(slot->mutex);
+        if (!slot->connection.expired())
+            slot->session->disconnect();
+    }
+    m_pool.stop();
+}
+
+void AsioAcceptor::doAccept(asio::ip::tcp::acceptor &acceptor) {
+    acceptor.async_accept(
+        asio::make_strand(m_pool.context()),
+        [this, &acceptor](std::error_code ec, asio::ip::tcp::socket socket) {
+            if (ec) {
+                if (ec == asio::error::operation_aborted)
+                    return;
+                SPDLOG_ERROR("accept: {}", ec.message());
+            } else {
+                socket.set_option(asio::ip::tcp::no_delay(m_no_delay), ec);
+                std::make_shared<AsioConnection>(std::move(socket), *this)
+                    ->start();
+            }
+            doAccept(acceptor);
+        });
+}
+
+// QuickFIX sessions need a periodic next() to send heartbeats, test
+// requests and detect timeouts; SocketAcceptor does the same once a second.
+asio::awaitable<void> AsioAcceptor::heartbeat() {
+    asio::steady_timer timer(m_pool.context());
+    for (;;) {
+        timer.expires_after(std::chrono::seconds(1));
+        auto [ec] =
+            co_await timer.async_wait(asio::as_tuple(asio::use_awaitable));
+        if (ec)
+            break;
+        for (auto &[name, slot] : m_slots) {
+            std::lock_guard lk(slot->mutex);
+            if (slot->connection.expired())
+                continue;
+            try {
+                slot->session->next(FIX::UtcTimeStamp::now());
+            } catch (const std::exception &e) {
+                SPDLOG_ERROR("{}", e.what());
+            }
+        }
+    }
+}
+
+template <typename Get>
+SendResult AsioAcceptor::sendBatch(const FIX::SessionID &id, size_t count,
+                                   Get &&get) {
+    auto *s = slot(id);
+    if (s == nullptr || count == 0)
+        return SendResult::Dropped;
+    std::vector<std::string> frames;
+    frames.reserve(count);
+    std::string header;
+
+    std::lock_guard lk(s->mutex);
+    auto *session = s->session;
+    // getStore() hands out the session's own SessionState, which forwards to
+    // the real store under its lock; only the accessor is const.
+    auto *store = const_cast<FIX::MessageStore *>(session->getStore());
+    auto *log = session->getLog();
+    auto *ring = resendRing(*s, *store);
+    auto connection = s->connection.lock();
+    bool online = connection && session->isLoggedOn();
+    if (online && s->congested.load(std::memory_order::relaxed)) {
+        if (m_limits.policy == BackpressurePolicy::Drop) {
+            s->dropped.fetch_add(count, std::memory_order::relaxed);
+            return SendResult::Dropped;
+        }
+        if (m_limits.policy == BackpressurePolicy::Disconnect) {
+            SPDLOG_WARN("[{}] slow consumer, disconnecting", id.toString());
+            connection->disconnect();
+            online = false;
+        }
+    }
+    const auto sending_time = FIX::UtcTimeStampConvertor::convert(
+        FIX::UtcTimeStamp::now(), s->timestamp_precision);
+    for (size_t i = 0; i < count; ++i) {
+        const auto [msg_type, extra_header, body] = get(i);
+        const auto seq = store->getNextSenderMsgSeqNum();
+        header.clear();
+        FixEncoder::appendField(header, FIX::FIELD::MsgType, msg_type);
+        FixEncoder::appendField(header, FIX::FIELD::MsgSeqNum, seq);
+        header += s->comp_ids;
+        FixEncoder::appendField(header, FIX::FIELD::SendingTime, sending_time);
+        header += extra_header;
+        auto &frame = frames.emplace_back();
+        FixEncoder::frame(frame, s->begin_string, header, body);
+        store->set(seq, frame);
+        store->incrNextSenderMsgSeqNum();
+        log->onOutgoing(frame);
+        const bool admin = isAdmin(msg_type);
+        if (ring != nullptr && admin)
+            ring->pushAdmin(seq);
+        else if (ring != nullptr)
+            ring->push(seq, frame);
+        if (online && s->drop_next > 0 && !admin) {
+            --s->drop_next;
+            frames.pop_back();
+        }
+    }
+    if (online && s->logon_at != 0) {
+        const auto latency =
+            std::chrono::steady_clock::now().time_since_epoch().count() -
+            s->logon_at;
+        s->logon_at = 0;
+        s->logon_latency.store(latency, std::memory_order::relaxed);
+        std::lock_guard logon_lk(m_logon_mutex);
+        m_logon_latency.record(latency);
+    }
+    if (online && !frames.empty()) {
+        s->sent.store(s->sent.load(std::memory_order::relaxed) + frames.size(),
+                      std::memory_order::relaxed);
+        connection->write(std::move(frames));
+    }
+    return online ? SendResult::Sent : SendResult::Stored;
+}
+
+ResendRing *AsioAcceptor::resendRing(SessionSlot &s,
+                                     const FIX::MessageStore &store) {
+    if (m_resend_capacity == 0)
+        return nullptr;
+    if (!s.resend_ring)
+        s.resend_ring = std::make_unique<ResendRing>(m_resend_capacity);
+    const auto created = store.getCreationTime();
+    if (created != s.resend_created) {
+        s.resend_ring->clear();
+        s.resend_created = created;
+    }
+    return s.resend_ring.get();
+}
+
+void AsioAcceptor::recordSent(SessionSlot &s, std::string_view msg) {
+    // QuickFIX's own resends and gap fills keep their old seqnums.
+    if (fieldOf(msg, "\x01" "43=") == "Y")
+        return;
+    const auto seq_field = fieldOf(msg, "\x01" "34=");
+    uint64_t seq = 0;
+    if (std::from_chars(seq_field.data(), seq_field.data() + seq_field.size(),
+                        seq)
+            .ec != std::errc{})
+        return;
+    std::lock_guard lk(s.mutex);
+    auto *ring = resendRing(s, *s.session->getStore());
+    if (ring == nullptr)
+        return;
+    if (isAdmin(fieldOf(msg, "\x01" "35=")))
+        ring->pushAdmin(static_cast<FIX::SEQNUM>(seq));
+    else
+        ring->push(static_cast<FIX::SEQNUM>(seq), msg);
+}
+
+bool AsioAcceptor::serveResend(SessionSlot &s, AsioConnection &connection,
+                               const std::string &msg) {
+    if (msg.find("\x01" "35=2\x01") == std::string::npos)
+        return false;
+    auto *session = s.session;
+    auto *state = dynamic_cast<FIX::SessionState *>(
+        const_cast<FIX::MessageStore *>(session->getStore()));
+    auto *ring = state != nullptr ? resendRing(s, *state) : nullptr;
+    if (ring == nullptr || ring->empty() || !session->isLoggedOn() ||
+        state->resendRequested())
+        return false;
+    const auto &id = session->getSessionID();
+    const auto now = FIX::UtcTimeStamp::now();
+    FIX::MsgSeqNum seq;
+    FIX::BeginSeqNo begin;
+    FIX::EndSeqNo end;
+    try {
+        // Anything unusual is left to QuickFIX, which rejects it properly.
+        FIX::Message request(msg, false);
+        const auto &header = request.getHeader();
+        if (header.getField(FIX::FIELD::MsgType) !=
+                FIX::MsgType_ResendRequest ||
+            header.isSetField(FIX::FIELD::PossDupFlag))
+            return false;
+        // What Session::verify() checks before it acts on a message.
+        if (header.getField(FIX::FIELD::BeginString) != s.begin_string ||
+            header.getField(FIX::FIELD::SenderCompID) !=
+                id.getTargetCompID().getString() ||
+            header.getField(FIX::FIELD::TargetCompID) !=
+                id.getSenderCompID().getString())
+            return false;
+        FIX::SendingTime sending_time;
+        header.getField(sending_time);
+        if (session->getCheckLatency() &&
+            std::labs(now - sending_time.getValue()) >
+                session->getMaxLatency())
+            return false;
+        header.getField(seq);
+        request.getField(begin);
+        request.getField(end);
+    } catch (const FIX::Exception &) {
+        return false;
+    }
+    if (seq.getValue() != state->getNextTargetMsgSeqNum())
+        return false;
+    const auto next = state->getNextSenderMsgSeqNum();
+    FIX::SEQNUM last = end.getValue();
+    if (last == 0 || last == 999999 || last >= next)
+        last = next - 1;
+    // A seqnum the ring does not hold may be an application message the
+    // store has and this process never wrote.
+    if (!ring->covers(begin.getValue(), last))
+        return false;
+
+    state->onIncoming(msg);
+    state->lastReceivedTime(now);
+    state->testRequest(0);
+    state->incrNextTargetMsgSeqNum();
+    state->onEvent("Received ResendRequest FROM: " +
+                   std::to_string(begin.getValue()) +
+                   " TO: " + std::to_string(end.getValue()));
+    resendFrom(s, connection, *ring, begin.getValue(), last);
+    return true;
+}
+
+size_t AsioAcceptor::resendFrom(SessionSlot &s, AsioConnection &connection,
+                                const ResendRing &ring, FIX::SEQNUM begin,
+                                FIX::SEQNUM end) {
+    auto *log = s.session->getLog();
+    const auto sending_time = FIX::UtcTimeStampConvertor::convert(
+        FIX::UtcTimeStamp::now(), s.timestamp_precision);
+    FixEncoder encoder;
+    std::vector<std::string> frames;
+    frames.reserve(kResendChunk);
+    auto flush = [&] {
+        for (const auto &frame : frames)
+            log->onOutgoing(frame);
+        connection.write(std::move(frames));
+        frames = {};
+        frames.reserve(kResendChunk);
+    };
+    size_t resent = 0;
+    // Admin messages, and anything the ring does not hold, are folded
+    // into the gap fill before the next application message.
+    FIX::SEQNUM next = begin;
+    ring.forEach(begin, end, [&](FIX::SEQNUM seq, std::string_view sent) {
+        if (sent.empty())
+            return;
+        if (seq > next)
+            gapFill(frames.emplace_back(), s, next, seq, sending_time);
+        auto &frame = frames.emplace_back();
+        if (encoder.possDup(frame, sent, sending_time))
+            ++resent;
+        else
+            gapFill(frame, s, seq, seq + 1, sending_time);
+        next = seq + 1;
+        if (frames.size() >= kResendChunk)
+            flush();
+    });
+    if (next <= end)
+        gapFill(frames.emplace_back(), s, next, end + 1, sending_time);
+    if (!frames.empty())
+        flush();
+    s.resent.store(s.resent.load(std::memory_order::relaxed) + resent,
+                   std::memory_order::relaxed);
+    return resent;
+}
+
+bool AsioAcceptor::skip(const FIX::SessionID &id, uint32_t count) {
+    auto *s = slot(id);
+    if (s == nullptr)
+        return false;
+    std::lock_guard lk(s->mutex);
+    auto *store = const_cast<FIX::MessageStore *>(s->session->getStore());
+    store->setNextSenderMsgSeqNum(store->getNextSenderMsgSeqNum() + count);
+    return true;
+}
+
+bool AsioAcceptor::drop(const FIX::SessionID &id, uint32_t count) {
+    auto *s = slot(id);
+    if (s == nullptr)
+        return false;
+    std::lock_guard lk(s->mutex);
+    s->drop_next += count;
+    return true;
+}
+
+bool AsioAcceptor::resend(const FIX::SessionID &id, FIX::SEQNUM begin,
+                          FIX::SEQNUM end) {
+    auto *s = slot(id);
+    if (s == nullptr)
+        return false;
+    std::lock_guard lk(s->mutex);
+    const auto *store = s->session->getStore();
+    auto *ring = resendRing(*s, *store);
+    auto connection = s->connection.lock();
+    if (ring == nullptr || ring->empty() || !connection ||
+        !s->session->isLoggedOn())
+        return false;
+    const auto last = store->getNextSenderMsgSeqNum() - 1;
+    begin = std::max(begin, ring->from());
+    if (end == 0 || end > last)
+        end = last;
+    if (begin > end)
+        return false;
+    resendFrom(*s, *connection, *ring, begin, end);
+    return true;
+}
+
+bool AsioAcceptor::requestResend(const FIX::SessionID &id, FIX::SEQNUM begin,
+                                 FIX::SEQNUM end) {
+    std::string body;
+    FixEncoder::appendField(body, FIX::FIELD::BeginSeqNo,
+                            static_cast<uint64_t>(begin));
+    FixEncoder::appendField(body, FIX::FIELD::EndSeqNo,
+                            static_cast<uint64_t>(end));
+    const std::string_view bodies[] = {body};
+    return send(id, FIX::MsgType_ResendRequest, {}, bodies) ==
+           SendResult::Sent;
+}
+
+SendResult AsioAcceptor::send(const FIX::SessionID &id,
+                              std::span<const OutboundMessage> msgs) {
+    return sendBatch(id, msgs.size(), [&](size_t i) {
+        const auto &msg = msgs[i];
+        return std::tuple<std::string_view, std::string_view, std::string_view>(
+            msg.msg_type, msg.header, msg.body);
+    });
+}
+
+SendResult AsioAcceptor::send(const FIX::SessionID &id,
+                              std::string_view msg_type,
+                              std::string_view header,
+                              std::span<const std::string_view> bodies) {
+    return sendBatch(id, bodies.size(), [&](size_t i) {
+        return std::make_tuple(msg_type, header, bodies[i]);
+    });
+}
@@ -0,0 +1,48 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <random>
+
+#include <uuid/uuid.h>
+
+#include "builtin.h"
+
+std::string getTzDateTime(std::string_view fmt) {
+    using namespace std::chrono;
+    auto now = system_clock::now();
+    auto now_ms = time_point_cast<milliseconds>(now);
+    auto tz = locate_zone("UTC");
+    zoned_time zt{tz, now_ms};
+    return std::vformat(fmt, std::make_format_args(zt));
+}
+
+std::string getTzDateTimeNoMs(std::string_view fmt) {
+    using namespace std::chrono;
+    auto now = system_clock::now();
+    auto now_ms = time_point_cast<seconds>(now);
+    auto tz = locate_zone("UTC");
+    zoned_time zt{tz, now_ms};
+    return std::vformat(fmt, std::make_format_args(zt));
+}
+
+std::string uuid() {
+    uuid_t uuid;
+    char uuid_str[37]{};
+    uuid_generate_random(uuid);
+    uuid_unparse(uuid, uuid_str);
+    std::string value(uuid_str);
+    std::ranges::replace(value, '-', '.');
+    return value;
+}
+
+std::string randomNumber(int min, int max) {
+    thread_local std::mt19937 gen(std::random_device{}());
+    std::uniform_int_distribution<> dist(min, max);
+    return std::to_string(dist(gen));
+}
+
+std::string increment() {
+    static std::atomic_uint64_t init_value = 1;
+    return std::to_string(init_value.fetch_add(1, std::memory_order::relaxed));
+}
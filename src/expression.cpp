@@ -0,0 +1,432 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <stdexcept>
+
+#include "expression.h"
+
+namespace {
+
+// Deep enough for any expression that fits on a config line.
+constexpr size_t kMaxStack = 16;
+
+constexpr int64_t kPow10[] = {1,         10,         100,        1000,
+                              10000,     100000,     1000000,    10000000,
+                              100000000};
+
+// a / b rounded half away from zero.
+__int128 divRound(__int128 a, __int128 b) {
+    auto q = a / b;
+    auto r = a % b;
+    if (r < 0)
+        r = -r;
+    if (2 * r >= (b < 0 ? -b : b))
+        q += (a < 0) == (b < 0) ? 1 : -1;
+    return q;
+}
+
+Decimal checked(__int128 raw) {
+    if (raw > std::numeric_limits<int64_t>::max() ||
+        raw < std::numeric_limits<int64_t>::min())
+        throw std::invalid_argument("expression overflow");
+    return Decimal{static_cast<int64_t>(raw)};
+}
+
+// A value on the evaluation stack: a number, or text that is read as a
+// number only if an operator needs one.
+struct Slot {
+    bool is_text;
+    Decimal number;
+    std::string_view text;
+
+    Decimal get() const { return is_text ? Decimal::parse(text) : number; }
+};
+
+}  // namespace
+
+Decimal Decimal::parse(std::string_view text) {
+    const char *p = text.data();
+    const char *end = p + text.size();
+    const bool negative = p != end && *p == '-';
+    if (negative)
+        ++p;
+    if (p != end && (*p == '-' || *p == '+'))
+        throw std::invalid_argument(
+            std::format("'{}' is not a number", text));
+    int64_t whole = 0;
+    auto [next, ec] = std::from_chars(p, end, whole);
+    if (ec == std::errc::result_out_of_range ||
+        whole > std::numeric_limits<int64_t>::max() / kScale)
+        throw std::invalid_argument(std::format("'{}' is too large", text));
+    const bool has_whole = ec == std::errc{};
+    if (!has_whole)
+        next = p;
+    int64_t fraction = 0;
+    int places = 0;
+    if (next != end && *next == '.') {
+        for (++next; next != end && std::isdigit(*next); ++next) {
+            if (places < kPlaces) {
+                fraction = fraction * 10 + (*next - '0');
+                ++places;
+            }
+        }
+    }
+    if (next != end || (!has_whole && places == 0))
+        throw std::invalid_argument(
+            std::format("'{}' is not a number", text));
+    const __int128 raw = static_cast<__int128>(whole) * kScale +
+                         fraction * kPow10[kPlaces - places];
+    return checked(negative ? -raw : raw);
+}
+
+char *Decimal::format(char *buf) const {
+    char *out = buf;
+    uint64_t magnitude = raw < 0 ? 0 - static_cast<uint64_t>(raw) : raw;
+    if (raw < 0)
+        *out++ = '-';
+    out = std::to_chars(out, buf + 32, magnitude / kScale).ptr;
+    uint64_t fraction = magnitude % kScale;
+    if (fraction == 0)
+        return out;
+    *out++ = '.';
+    for (int i = kPlaces - 1; i >= 0 && fraction != 0; --i) {
+        *out++ = static_cast<char>('0' + fraction / kPow10[i]);
+        fraction %= kPow10[i];
+    }
+    return out;
+}
+
+// Recursive descent straight to postfix. Each parse function returns
+// whether the value it pushed can only be text.
+class ExpressionParser {
+public:
+    ExpressionParser(std::string_view text, Expression &expr)
+        : m_text(text), m_expr(expr) {}
+
+    void parse() {
+        skip();
+        if (peekWord() == "concat") {
+            m_pos += 6;
+            parseConcat();
+            m_expr.m_text = true;
+        } else {
+            if (parseSum())
+                m_expr.m_text = true;
+        }
+        skip();
+        if (m_pos != m_text.size())
+            fail("unexpected input");
+    }
+
+private:
+    using Op = Expression::Op;
+
+    [[noreturn]] void fail(std::string_view what) const {
+        throw std::invalid_argument(std::format(
+            "expr '{}': {} at {}", m_text, what, m_pos));
+    }
+
+    void skip() {
+        while (m_pos < m_text.size() && std::isspace(m_text[m_pos]))
+            ++m_pos;
+    }
+
+    bool accept(char c) {
+        skip();
+        if (m_pos < m_text.size() && m_text[m_pos] == c) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!accept(c))
+            fail(std::format("expected '{}'", c));
+    }
+
+    std::string_view peekWord() const {
+        auto end = m_pos;
+        while (end < m_text.size() &&
+               (std::isalnum(m_text[end]) || m_text[end] == '_'))
+            ++end;
+        return m_text.substr(m_pos, end - m_pos);
+    }
+
+    // Pushes and pops are counted so the evaluation stack can be fixed.
+    void emit(Expression::Instr instr, int delta) {
+        m_expr.m_program.push_back(instr);
+        m_depth += delta;
+        if (m_depth > static_cast<int>(kMaxStack))
+            fail("expression too deep");
+    }
+
+    void number(bool is_text) {
+        if (is_text)
+            fail("text where a number is expected");
+    }
+
+    void parseConcat() {
+        expect('(');
+        int count = 0;
+        do {
+            parseSum();
+            if (++count > std::numeric_limits<uint8_t>::max())
+                fail("too many operands");
+        } while (accept(','));
+        expect(')');
+        emit({.op = Op::Concat, .count = static_cast<uint8_t>(count)},
+             1 - count);
+    }
+
+    bool parseSum() {
+        bool is_text = parseProduct();
+        for (;;) {
+            Op op;
+            if (accept('+'))
+                op = Op::Add;
+            else if (accept('-'))
+                op = Op::Sub;
+            else
+                return is_text;
+            number(is_text);
+            number(parseProduct());
+            emit({.op = op}, -1);
+        }
+    }
+
+    bool parseProduct() {
+        bool is_text = parseUnary();
+        for (;;) {
+            Op op;
+            if (accept('*'))
+                op = Op::Mul;
+            else if (accept('/'))
+                op = Op::Div;
+            else
+                return is_text;
+            number(is_text);
+            number(parseUnary());
+            emit({.op = op}, -1);
+        }
+    }
+
+    bool parseUnary() {
+        if (accept('-')) {
+            number(parseUnary());
+            emit({.op = Op::Neg}, 0);
+            return false;
+        }
+        return parsePrimary();
+    }
+
+    bool parsePrimary() {
+        skip();
+        if (m_pos == m_text.size())
+            fail("unexpected end");
+        const char c = m_text[m_pos];
+        if (accept('(')) {
+            bool is_text = parseSum();
+            expect(')');
+            return is_text;
+        }
+        if (c == '"' || c == '\'') {
+            auto end = m_text.find(c, m_pos + 1);
+            if (end == std::string_view::npos)
+                fail("unterminated string");
+            auto literal = m_text.substr(m_pos + 1, end - m_pos - 1);
+            emit({.op = Op::Text,
+                  .arg = static_cast<int32_t>(m_expr.m_literals.size()),
+                  .value = static_cast<int64_t>(literal.size())},
+                 1);
+            m_expr.m_literals += literal;
+            m_pos = end + 1;
+            return true;
+        }
+        if (std::isdigit(c) || c == '.') {
+            auto end = m_pos;
+            while (end < m_text.size() &&
+                   (std::isdigit(m_text[end]) || m_text[end] == '.'))
+                ++end;
+            Decimal value;
+            try {
+                value = Decimal::parse(m_text.substr(m_pos, end - m_pos));
+            } catch (const std::invalid_argument &) {
+                fail("bad number");
+            }
+            m_pos = end;
+            emit({.op = Op::Number, .value = value.raw}, 1);
+            return false;
+        }
+        const auto word = peekWord();
+        if (word.empty())
+            fail("unexpected character");
+        m_pos += word.size();
+        if (word == "input" || word == "input_header") {
+            expect('.');
+            int tag = 0;
+            auto [ptr, ec] = std::from_chars(m_text.data() + m_pos,
+                                             m_text.data() + m_text.size(),
+                                             tag);
+            if (ec != std::errc{} || tag <= 0)
+                fail("expected a tag");
+            m_pos = ptr - m_text.data();
+            emit({.op = word == "input" ? Op::Input : Op::InputHeader,
+                  .arg = tag},
+                 1);
+            return false;
+        }
+        if (word == "min" || word == "max") {
+            const auto op = word == "min" ? Op::Min : Op::Max;
+            expect('(');
+            number(parseSum());
+            expect(',');
+            do {
+                number(parseSum());
+                emit({.op = op}, -1);
+            } while (accept(','));
+            expect(')');
+            return false;
+        }
+        if (word == "abs") {
+            expect('(');
+            number(parseSum());
+            expect(')');
+            emit({.op = Op::Abs}, 0);
+            return false;
+        }
+        if (word == "round") {
+            expect('(');
+            number(parseSum());
+            expect(',');
+            skip();
+            int places = -1;
+            auto [ptr, ec] = std::from_chars(m_text.data() + m_pos,
+                                             m_text.data() + m_text.size(),
+                                             places);
+            if (ec != std::errc{} || places < 0 || places > Decimal::kPlaces)
+                fail(std::format("expected 0 to {} places", Decimal::kPlaces));
+            m_pos = ptr - m_text.data();
+            expect(')');
+            emit({.op = Op::Round, .arg = places}, 0);
+            return false;
+        }
+        if (word == "concat")
+            fail("concat is only allowed as the whole expression");
+        fail(std::format("unknown name '{}'", word));
+    }
+
+    std::string_view m_text;
+    Expression &m_expr;
+    size_t m_pos{0};
+    int m_depth{0};
+};
+
+Expression::Expression(std::string_view text) {
+    ExpressionParser(text, *this).parse();
+}
+
+void Expression::evaluate(const FIX::Message &msg, std::string &out) const {
+    std::array<Slot, kMaxStack> stack;
+    size_t top = 0;
+    char buf[32];
+    for (const auto &instr : m_program) {
+        switch (instr.op) {
+            case Op::Number:
+                stack[top++] = {.is_text = false,
+                                .number = {instr.value},
+                                .text = {}};
+                break;
+            case Op::Text:
+                stack[top++] = {
+                    .is_text = true,
+                    .number = {},
+                    .text = std::string_view(m_literals)
+                                .substr(instr.arg, instr.value)};
+                break;
+            case Op::Input:
+                stack[top++] = {.is_text = true,
+                                .number = {},
+                                .text = msg.getField(instr.arg)};
+                break;
+            case Op::InputHeader:
+                stack[top++] = {.is_text = true,
+                                .number = {},
+                                .text = msg.getHeader().getField(instr.arg)};
+                break;
+            case Op::Neg:
+            case Op::Abs:
+            case Op::Round: {
+                auto &slot = stack[top - 1];
+                auto value = slot.get().raw;
+                if (instr.op == Op::Neg || (instr.op == Op::Abs && value < 0))
+                    value = checked(-static_cast<__int128>(value)).raw;
+                if (instr.op == Op::Round) {
+                    const auto factor = kPow10[Decimal::kPlaces - instr.arg];
+                    value = checked(divRound(value, factor) * factor).raw;
+                }
+                slot = {.is_text = false, .number = {value}, .text = {}};
+                break;
+            }
+            case Op::Concat: {
+                out.clear();
+                for (size_t i = top - instr.count; i < top; ++i) {
+                    if (stack[i].is_text)
+                        out += stack[i].text;
+                    else
+                        out.append(buf, stack[i].number.format(buf));
+                }
+                return;
+            }
+            default: {
+                const __int128 b = stack[--top].get().raw;
+                const __int128 a = stack[top - 1].get().raw;
+                __int128 result = 0;
+                switch (instr.op) {
+                    case Op::Add:
+                        result = a + b;
+                        break;
+                    case Op::Sub:
+                        result = a - b;
+                        break;
+                    case Op::Mul:
+                        result = divRound(a * b, Decimal::kScale);
+                        break;
+                    case Op::Div:
+                        if (b == 0)
+                            throw std::invalid_argument(
+                                "expression divides by zero");
+                        result = divRound(a * Decimal::kScale, b);
+                        break;
+                    case Op::Min:
+                        result = std::min(a, b);
+                        break;
+                    default:
+                        result = std::max(a, b);
+                        break;
+                }
+                stack[top - 1] = {
+                    .is_text = false, .number = checked(result), .text = {}};
+                break;
+            }
+        }
+    }
+    const auto &result = stack[0];
+    if (result.is_text)
+        out.assign(result.text);
+    else
+        out.assign(buf, result.number.format(buf));
+}
+
+std::vector<int> Expression::inputs() const {
+    std::vector<int> tags;
+    for (const auto &instr : m_program) {
+        if (instr.op == Op::Input || instr.op == Op::InputHeader)
+            tags.push_back(instr.arg);
+    }
+    return tags;
+}
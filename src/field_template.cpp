@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <format>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+
+#include "field_template.h"
+#include "fix_encoder.h"
+
+namespace {
+
+constexpr std::pair<std::string_view, Builtin> kBuiltins[] = {
+    {"uuid", Builtin::Uuid},
+    {"getTzDateTime", Builtin::GetTzDateTime},
+    {"getTzDateTimeNoMs", Builtin::GetTzDateTimeNoMs},
+    {"randomNumber", Builtin::RandomNumber},
+    {"increment", Builtin::Increment},
+    {"createUniqueOrderID", Builtin::CreateUniqueOrderID},
+    {"marketPrice", Builtin::MarketPrice},
+};
+
+constexpr std::pair<std::string_view, FieldTemplate::Source> kSources[] = {
+    {"input.", FieldTemplate::Source::Input},
+    {"if_input.", FieldTemplate::Source::IfInput},
+    {"input_header.", FieldTemplate::Source::InputHeader},
+    {"input_group.", FieldTemplate::Source::InputGroup},
+    {"if_input_header.", FieldTemplate::Source::IfInputHeader},
+    {"call.", FieldTemplate::Source::Call},
+};
+
+template <typename T>
+bool parseNumber(std::string_view value, T &out) {
+    auto [ptr, ec] =
+        std::from_chars(value.data(), value.data() + value.size(), out);
+    return !value.empty() && ec == std::errc{} &&
+           ptr == value.data() + value.size();
+}
+
+bool digits(std::string_view value) {
+    return std::ranges::all_of(
+        value, [](unsigned char c) { return std::isdigit(c) != 0; });
+}
+
+// YYYYMMDD-HH:MM:SS[.s{1,9}]
+bool isTimestamp(std::string_view value) {
+    if (value.size() < 17 || value[8] != '-' || value[11] != ':' ||
+        value[14] != ':')
+        return false;
+    if (!digits(value.substr(0, 8)) || !digits(value.substr(9, 2)) ||
+        !digits(value.substr(12, 2)) || !digits(value.substr(15, 2)))
+        return false;
+    if (value.size() == 17)
+        return true;
+    return value[17] == '.' && value.size() > 18 && value.size() <= 27 &&
+           digits(value.substr(18));
+}
+
+constexpr std::string_view kOptional = "optional(none)";
+
+// "448=BRK 447=D 452=1"
+FieldList parseFieldList(std::string_view text) {
+    FieldList fields;
+    for (auto item : text | std::views::split(' ')) {
+        std::string_view view(item.begin(), item.end());
+        if (view.empty())
+            continue;
+        auto eq = view.find('=');
+        int tag = 0;
+        if (eq == std::string_view::npos || eq + 1 == view.size() ||
+            !parseNumber(view.substr(0, eq), tag) || tag <= 0)
+            throw std::invalid_argument(
+                std::format("'{}' is not tag=value", view));
+        fields.emplace_back(tag, view.substr(eq + 1));
+    }
+    if (fields.empty())
+        throw std::invalid_argument(std::format("no fields in '{}'", text));
+    return fields;
+}
+
+std::string checkFields(const Schema &schema, const FieldList &fields) {
+    for (const auto &[tag, value] : fields) {
+        const auto *field = schema.field(tag);
+        if (field == nullptr) {
+            if (tag < kFirstUserDefinedTag)
+                return std::format("unknown tag {}", tag);
+            continue;
+        }
+        if (auto error = checkValue(*field, value); !error.empty())
+            return error;
+    }
+    return {};
+}
+
+std::string checkGroup(const Schema &schema, int tag) {
+    const auto *field = schema.field(tag);
+    if (field == nullptr)
+        return std::format("unknown tag {}", tag);
+    if (field->type != "NUMINGROUP")
+        return std::format("{} is not a repeating group", field->name);
+    return {};
+}
+
+// What each call.<name> returns.
+FieldType callType(Builtin call) {
+    switch (call) {
+        case Builtin::GetTzDateTime:
+        case Builtin::GetTzDateTimeNoMs:
+            return FieldType::UtcTimestamp;
+        case Builtin::RandomNumber:
+        case Builtin::Increment:
+            return FieldType::Int;
+        case Builtin::MarketPrice:
+            return FieldType::Price;
+        case Builtin::Uuid:
+        case Builtin::CreateUniqueOrderID:
+            break;
+    }
+    return FieldType::String;
+}
+
+}  // namespace
+
+FieldType fieldType(std::string_view type) {
+    if (type == "CHAR")
+        return FieldType::Char;
+    if (type == "BOOLEAN")
+        return FieldType::Boolean;
+    if (type == "INT" || type == "LENGTH" || type == "SEQNUM" ||
+        type == "NUMINGROUP" || type == "TAGNUM" || type == "DAYOFMONTH")
+        return FieldType::Int;
+    if (type == "QTY")
+        return FieldType::Qty;
+    if (type == "PRICE" || type == "PRICEOFFSET" || type == "AMT" ||
+        type == "FLOAT" || type == "PERCENTAGE")
+        return FieldType::Price;
+    if (type == "UTCTIMESTAMP")
+        return FieldType::UtcTimestamp;
+    if (type == "MULTIPLEVALUESTRING" || type == "MULTIPLECHARVALUE" ||
+        type == "MULTIPLESTRINGVALUE")
+        return FieldType::MultipleValue;
+    return FieldType::String;
+}
+
+std::string checkValue(const Schema::Field &field, std::string_view value) {
+    const auto type = fieldType(field.type);
+    if (!field.values.empty()) {
+        auto valid = [&](std::string_view item) {
+            return std::ranges::find(field.values, item) != field.values.end();
+        };
+        if (type == FieldType::MultipleValue) {
+            for (auto item : value | std::views::split(' ')) {
+                std::string_view view(item.begin(), item.end());
+                if (!valid(view))
+                    return std::format("'{}' is not a value of {}", view,
+                                       field.name);
+            }
+            return {};
+        }
+        if (!valid(value))
+            return std::format("'{}' is not a value of {}", value,
+                               field.name);
+        return {};
+    }
+    bool ok = true;
+    switch (type) {
+        case FieldType::Char:
+            ok = value.size() == 1;
+            break;
+        case FieldType::Boolean:
+            ok = value == "Y" || value == "N";
+            break;
+        case FieldType::Int: {
+            int64_t number;
+            ok = parseNumber(value, number);
+            break;
+        }
+        case FieldType::Qty:
+        case FieldType::Price: {
+            double number;
+            ok = parseNumber(value, number);
+            break;
+        }
+        case FieldType::UtcTimestamp:
+            ok = isTimestamp(value);
+            break;
+        case FieldType::String:
+        case FieldType::MultipleValue:
+            break;
+    }
+    if (!ok)
+        return std::format("'{}' is not a valid {} for {}", value, field.type,
+                           field.name);
+    return {};
+}
+
+FieldTemplate FieldTemplate::parse(int tag, const std::string &value) {
+    FieldTemplate field{.tag = tag,
+                        .source = Source::Constant,
+                        .value = value,
+                        .text = value};
+    for (const auto &[prefix, source] : kSources) {
+        if (!value.starts_with(prefix))
+            continue;
+        const auto arg = std::string_view(value).substr(prefix.size());
+        field.source = source;
+        field.value.clear();
+        if (source == Source::Call) {
+            auto it = std::ranges::find(kBuiltins, arg,
+                                        &std::pair<std::string_view,
+                                                   Builtin>::first);
+            if (it == std::end(kBuiltins))
+                throw std::invalid_argument(
+                    std::format("{}: unknown function '{}'", tag, arg));
+            field.call = it->second;
+        } else if (!parseNumber(arg, field.input_tag) ||
+                   field.input_tag <= 0) {
+            throw std::invalid_argument(
+                std::format("{}: '{}' is not a tag", tag, value));
+        }
+        return field;
+    }
+    if (value.starts_with("expr:")) {
+        field.source = Source::Expr;
+        field.value.clear();
+        try {
+            field.expr = Expression(std::string_view(value).substr(5));
+        } catch (const std::invalid_argument &e) {
+            throw std::invalid_argument(std::format("{}: {}", tag, e.what()));
+        }
+        return field;
+    }
+    if (value.starts_with("group:")) {
+        field.source = Source::Group;
+        try {
+            for (auto item : std::string_view(value).substr(6) |
+                                 std::views::split('|'))
+                field.instances.push_back(parseFieldList(
+                    std::string_view(item.begin(), item.end())));
+        } catch (const std::invalid_argument &e) {
+            throw std::invalid_argument(std::format("{}: {}", tag, e.what()));
+        }
+        field.value.clear();
+        FixEncoder::appendField(field.value, tag,
+                                uint64_t(field.instances.size()));
+        for (const auto &instance : field.instances) {
+            for (const auto &[member, member_value] : instance)
+                FixEncoder::appendField(field.value, member, member_value);
+        }
+        return field;
+    }
+    if (value.starts_with("bool:")) {
+        if (value != "bool:true" && value != "bool:false")
+            throw std::invalid_argument(
+                std::format("{}: '{}' is neither bool:true nor bool:false",
+                            tag, value));
+        field.type = FieldType::Boolean;
+        field.value = value == "bool:true" ? "Y" : "N";
+    }
+    return field;
+}
+
+std::string FieldTemplate::check(const Schema &schema) {
+    const auto *field = schema.field(tag);
+    if (field == nullptr)
+        return tag >= kFirstUserDefinedTag ? std::string{}
+                                   : std::format("unknown tag {}", tag);
+    const auto resolved = fieldType(field->type);
+    if (type == FieldType::Boolean && resolved != FieldType::Boolean)
+        return std::format("'{}' on {}, which is {}", text, field->name,
+                           field->type);
+    type = resolved;
+    switch (source) {
+        case Source::Constant:
+            return checkValue(*field, value);
+        case Source::Call: {
+            const auto returns = callType(call);
+            if (type == FieldType::String || type == returns ||
+                (returns == FieldType::Int &&
+                 (type == FieldType::Qty || type == FieldType::Price)))
+                return {};
+            return std::format("'{}' on {}, which is {}", text, field->name,
+                               field->type);
+        }
+        case Source::Group: {
+            if (auto error = checkGroup(schema, tag); !error.empty())
+                return error;
+            for (const auto &instance : instances) {
+                if (instance.front().first !=
+                    instances.front().front().first)
+                    return std::format(
+                        "'{}': every instance starts with the same tag",
+                        text);
+                if (auto error = checkFields(schema, instance);
+                    !error.empty())
+                    return std::format("'{}': {}", text, error);
+            }
+            return {};
+        }
+        case Source::InputGroup:
+            if (auto error = checkGroup(schema, tag); !error.empty())
+                return error;
+            return checkGroup(schema, input_tag);
+        case Source::Expr:
+            for (auto input : expr.inputs()) {
+                if (input < kFirstUserDefinedTag &&
+                    schema.field(input) == nullptr)
+                    return std::format("'{}': unknown tag {}", text, input);
+            }
+            if (expr.text() && type != FieldType::String &&
+                type != FieldType::MultipleValue)
+                return std::format("'{}' gives text but {} is {}", text,
+                                   field->name, field->type);
+            return {};
+        default:
+            if (input_tag < kFirstUserDefinedTag &&
+                schema.field(input_tag) == nullptr)
+                return std::format("'{}': unknown tag {}", text, input_tag);
+            return {};
+    }
+}
+
+void FieldTemplate::appendGroup(std::string &body,
+                                const FIX::Message &in) const {
+    if (source == Source::Group) {
+        body += value;
+        return;
+    }
+    const auto count = in.groupCount(input_tag);
+    if (count == 0)
+        return;
+    FixEncoder::appendField(body, tag, uint64_t(count));
+    for (size_t i = 1; i <= count; ++i)
+        FixEncoder::appendFields(body, in.getGroupRef(i, input_tag));
+}
+
+Condition Condition::parse(int tag, const std::string &value) {
+    Condition cond{.tag = tag, .kind = Kind::Equal, .value = value,
+                   .fields = {}};
+    if (value == kOptional) {
+        cond.kind = Kind::Present;
+    } else if (value.starts_with("any(") && value.ends_with(')')) {
+        cond.kind = Kind::Any;
+        try {
+            cond.fields = parseFieldList(
+                std::string_view(value).substr(4, value.size() - 5));
+        } catch (const std::invalid_argument &e) {
+            throw std::invalid_argument(std::format("{}: {}", tag, e.what()));
+        }
+    }
+    return cond;
+}
+
+bool Condition::matches(const FIX::FieldMap &map) const {
+    switch (kind) {
+        case Kind::Equal:
+            return map.getField(tag) == value;
+        case Kind::Present:
+            map.getField(tag);
+            return true;
+        case Kind::Any:
+            break;
+    }
+    const auto count = map.groupCount(tag);
+    for (size_t i = 1; i <= count; ++i) {
+        const auto &group = map.getGroupRef(i, tag);
+        if (std::ranges::all_of(fields, [&](const auto &field) {
+                return group.isSetField(field.first) &&
+                       group.getField(field.first) == field.second;
+            }))
+            return true;
+    }
+    return false;
+}
+
+std::string Condition::check(const Schema &schema) const {
+    if (kind == Kind::Any) {
+        if (auto error = checkGroup(schema, tag); !error.empty())
+            return error;
+        return checkFields(schema, fields);
+    }
+    const auto *field = schema.field(tag);
+    if (field == nullptr)
+        return tag >= kFirstUserDefinedTag
+                   ? std::string{}
+                   : std::format("unknown tag {}", tag);
+    return kind == Kind::Equal ? checkValue(*field, value) : std::string{};
+}
+
+std::vector<Condition> parseConditions(const FixFieldMap &map) {
+    std::vector<Condition> conditions;
+    conditions.reserve(map.size());
+    for (const auto &[tag, value] : map)
+        conditions.push_back(Condition::parse(tag, value));
+    return conditions;
+}
@@ -0,0 +1,206 @@
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define FIXSIM_X86 1
+#endif
+
+#include <quickfix/FieldNumbers.h>
+
+#include "fix_encoder.h"
+
+namespace {
+
+using ChecksumFunc = uint8_t (*)(std::string_view);
+
+#ifdef FIXSIM_X86
+__attribute__((target("sse2"))) uint8_t checksumSse2(std::string_view data) {
+    const auto *p = reinterpret_cast<const uint8_t *>(data.data());
+    const auto *end = p + data.size();
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = _mm_setzero_si128();
+    // psadbw against zero sums 8 bytes into each 64-bit lane, so the
+    // accumulator cannot overflow for any realistic message size.
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+    }
+    uint64_t sum = static_cast<uint64_t>(_mm_cvtsi128_si64(acc)) +
+                   static_cast<uint64_t>(
+                       _mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc)));
+    for (; p != end; ++p)
+        sum += *p;
+    return static_cast<uint8_t>(sum);
+}
+
+__attribute__((target("avx2"))) uint8_t checksumAvx2(std::string_view data) {
+    const auto *p = reinterpret_cast<const uint8_t *>(data.data());
+    const auto *end = p + data.size();
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    for (; end - p >= 64; p += 64) {
+        __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i v1 =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32));
+        acc0 = _mm256_add_epi64(acc0, _mm256_sad_epu8(v0, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_sad_epu8(v1, zero));
+    }
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        acc0 = _mm256_add_epi64(acc0, _mm256_sad_epu8(v, zero));
+    }
+    acc0 = _mm256_add_epi64(acc0, acc1);
+    __m128i acc = _mm_add_epi64(_mm256_castsi256_si128(acc0),
+                                _mm256_extracti128_si256(acc0, 1));
+    uint64_t sum = static_cast<uint64_t>(_mm_cvtsi128_si64(acc)) +
+                   static_cast<uint64_t>(
+                       _mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc)));
+    for (; p != end; ++p)
+        sum += *p;
+    return static_cast<uint8_t>(sum);
+}
+#endif
+
+struct ChecksumDispatch {
+    ChecksumFunc func;
+    std::string_view name;
+};
+
+const ChecksumDispatch &dispatch() {
+    static const ChecksumDispatch impl = []() -> ChecksumDispatch {
+#ifdef FIXSIM_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return {checksumAvx2, "avx2"};
+        if (__builtin_cpu_supports("sse2"))
+            return {checksumSse2, "sse2"};
+#endif
+        return {FixEncoder::checksumScalar, "scalar"};
+    }();
+    return impl;
+}
+
+bool isFramingTag(int tag) {
+    return tag == FIX::FIELD::BeginString || tag == FIX::FIELD::BodyLength ||
+           tag == FIX::FIELD::CheckSum;
+}
+
+}  // namespace
+
+uint8_t FixEncoder::checksumScalar(std::string_view data) {
+    uint32_t sum = 0;
+    for (unsigned char c : data)
+        sum += c;
+    return static_cast<uint8_t>(sum);
+}
+
+uint8_t FixEncoder::checksum(std::string_view data) {
+    return dispatch().func(data);
+}
+
+std::string_view FixEncoder::checksumImpl() {
+    return dispatch().name;
+}
+
+void FixEncoder::appendField(std::string &out, int tag,
+                             std::string_view value) {
+    char buf[16];
+    char *ptr = std::to_chars(buf, buf + sizeof(buf) - 1, tag).ptr;
+    *ptr++ = '=';
+    out.append(buf, ptr);
+    out.append(value);
+    out.push_back(SOH);
+}
+
+void FixEncoder::appendField(std::string &out, int tag, int64_t value) {
+    char buf[40];
+    char *ptr = std::to_chars(buf, buf + 16, tag).ptr;
+    *ptr++ = '=';
+    ptr = std::to_chars(ptr, buf + sizeof(buf) - 1, value).ptr;
+    *ptr++ = SOH;
+    out.append(buf, ptr);
+}
+
+void FixEncoder::appendField(std::string &out, int tag, uint64_t value) {
+    char buf[40];
+    char *ptr = std::to_chars(buf, buf + 16, tag).ptr;
+    *ptr++ = '=';
+    ptr = std::to_chars(ptr, buf + sizeof(buf) - 1, value).ptr;
+    *ptr++ = SOH;
+    out.append(buf, ptr);
+}
+
+void FixEncoder::appendFields(std::string &out, const FIX::FieldMap &map) {
+    const bool has_groups = map.g_begin() != map.g_end();
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        const int tag = it->getTag();
+        if (isFramingTag(tag))
+            continue;
+        appendField(out, tag, it->getString());
+        if (!has_groups || !map.hasGroup(tag))
+            continue;
+        const auto count = map.groupCount(tag);
+        for (size_t i = 1; i <= count; ++i)
+            appendFields(out, map.getGroupRef(i, tag));
+    }
+}
+
+void FixEncoder::frame(std::string &out, std::string_view begin_string,
+                       std::string_view header, std::string_view body) {
+    out.clear();
+    out.reserve(begin_string.size() + header.size() + body.size() + 32);
+    appendField(out, FIX::FIELD::BeginString, begin_string);
+    appendField(out, FIX::FIELD::BodyLength,
+                static_cast<uint64_t>(header.size() + body.size()));
+    out.append(header);
+    out.append(body);
+    const uint8_t sum = checksum(out);
+    const char trailer[] = {'1',
+                            '0',
+                            '=',
+                            static_cast<char>('0' + sum / 100),
+                            static_cast<char>('0' + sum / 10 % 10),
+                            static_cast<char>('0' + sum % 10),
+                            SOH};
+    out.append(trailer, sizeof(trailer));
+}
+
+const std::string &FixEncoder::encode(const FIX::Message &msg) {
+    m_header.clear();
+    m_body.clear();
+    const auto &hdr = msg.getHeader();
+    appendFields(m_header, hdr);
+    appendFields(m_body, msg);
+    appendFields(m_body, msg.getTrailer());
+    frame(m_out, hdr.getField(FIX::FIELD::BeginString), m_header, m_body);
+    return m_out;
+}
+
+bool FixEncoder::possDup(std::string &out, std::string_view original,
+                         std::string_view sending_time) {
+    // 8=..|9=..| then the fields, then 10=nnn|.
+    constexpr size_t kTrailer = 7;
+    const auto begin_end = original.find(SOH);
+    const auto fields = original.find(SOH, begin_end + 1) + 1;
+    if (begin_end == std::string_view::npos || fields == 0 ||
+        original.size() < fields + kTrailer || !original.starts_with("8="))
+        return false;
+    const auto end = original.size() - kTrailer;
+    const auto tag = original.substr(0, end).find("\x01" "52=", fields - 1);
+    if (tag == std::string_view::npos)
+        return false;
+    const auto value = tag + 4;
+    const auto value_end = original.find(SOH, value);
+    m_header.assign(original.substr(fields, tag + 1 - fields));
+    appendField(m_header, FIX::FIELD::PossDupFlag, "Y");
+    appendField(m_header, FIX::FIELD::SendingTime, sending_time);
+    appendField(m_header, FIX::FIELD::OrigSendingTime,
+                original.substr(value, value_end - value));
+    frame(out, original.substr(2, begin_end - 2), m_header,
+          original.substr(value_end + 1, end - value_end - 1));
+    return true;
+}
@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <format>
+#include <system_error>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+#include <asio/as_tuple.hpp>
+
+#include "http_server.h"
+
+namespace {
+
+constexpr size_t kChunk = 64 << 10;
+
+bool iequals(std::string_view a, std::string_view b) {
+    return std::ranges::equal(a, b, [](char x, char y) {
+        return std::tolower(static_cast<unsigned char>(x)) ==
+               std::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+        s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+        s.remove_suffix(1);
+    return s;
+}
+
+std::string_view reason(int status) {
+    switch (status) {
+        case 200:
+            return "OK";
+        case 304:
+            return "Not Modified";
+        case 400:
+            return "Bad Request";
+        case 404:
+            return "Not Found";
+        case 413:
+            return "Payload Too Large";
+        case 500:
+            return "Internal Server Error";
+        case 501:
+            return "Not Implemented";
+        default:
+            return "Unknown";
+    }
+}
+
+}  // namespace
+
+HttpExchange::HttpExchange(asio::ip::tcp::socket &socket, std::string &buffer)
+    : m_socket(socket), m_buffer(buffer) {}
+
+bool HttpExchange::parse(std::string_view head) {
+    auto line_end = head.find("\r\n");
+    auto line = head.substr(0, line_end);
+    auto sp1 = line.find(' ');
+    auto sp2 = line.rfind(' ');
+    if (sp1 == std::string_view::npos || sp1 == sp2)
+        return false;
+    m_method = line.substr(0, sp1);
+    auto target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    m_path = target.substr(0, target.find('?'));
+    m_version = line.substr(sp2 + 1);
+    if (m_path.empty() || m_path.front() != '/' ||
+        !m_version.starts_with("HTTP/1."))
+        return false;
+    while (line_end != std::string_view::npos) {
+        head.remove_prefix(line_end + 2);
+        line_end = head.find("\r\n");
+        line = head.substr(0, line_end);
+        if (line.empty())
+            continue;
+        auto colon = line.find(':');
+        if (colon == std::string_view::npos)
+            return false;
+        std::string name(trim(line.substr(0, colon)));
+        std::ranges::transform(name, name.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        m_headers.emplace_back(std::move(name),
+                               std::string(trim(line.substr(colon + 1))));
+    }
+    return true;
+}
+
+std::string_view HttpExchange::header(std::string_view name) const {
+    for (const auto &[key, value] : m_headers) {
+        if (iequals(key, name))
+            return value;
+    }
+    return {};
+}
+
+bool HttpExchange::hasHeader(std::string_view name) const {
+    return std::ranges::any_of(
+        m_headers, [&](const auto &h) { return iequals(h.first, name); });
+}
+
+asio::awaitable<std::string_view> HttpExchange::read() {
+    if (m_body_left == 0)
+        co_return std::string_view{};
+    // What came in with the headers is used up first.
+    if (!m_buffer.empty()) {
+        const auto n = std::min(m_buffer.size(), m_body_left);
+        m_chunk.assign(m_buffer, 0, n);
+        m_buffer.erase(0, n);
+    } else {
+        m_chunk.resize(std::min(m_body_left, kChunk));
+        const auto n = co_await m_socket.async_read_some(
+            asio::buffer(m_chunk), asio::use_awaitable);
+        m_chunk.resize(n);
+    }
+    m_body_left -= m_chunk.size();
+    co_return std::string_view(m_chunk);
+}
+
+asio::awaitable<void> HttpExchange::readBody() {
+    m_body.reserve(m_body_left);
+    for (;;) {
+        auto chunk = co_await read();
+        if (chunk.empty())
+            break;
+        m_body += chunk;
+    }
+}
+
+void HttpExchange::reply(int status, std::string body,
+                         std::string_view content_type) {
+    m_status = status;
+    m_reply = std::move(body);
+    m_shared_reply.reset();
+    m_content_type = content_type;
+}
+
+void HttpExchange::reply(int status, std::shared_ptr<const std::string> body,
+                         std::string_view content_type) {
+    m_status = status;
+    m_reply.clear();
+    m_shared_reply = std::move(body);
+    m_content_type = content_type;
+}
+
+void HttpExchange::setHeader(std::string name, std::string value) {
+    m_reply_headers.emplace_back(std::move(name), std::move(value));
+}
+
+asio::awaitable<void> HttpExchange::respond(bool keep_alive) {
+    const auto &body = m_shared_reply ? *m_shared_reply : m_reply;
+    auto head = std::format("HTTP/1.1 {} {}\r\nContent-Length: {}\r\n",
+                            m_status, reason(m_status), body.size());
+    if (!m_content_type.empty() && !body.empty())
+        head += std::format("Content-Type: {}\r\n", m_content_type);
+    head += keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    for (const auto &[name, value] : m_reply_headers)
+        head += std::format("{}: {}\r\n", name, value);
+    head += "\r\n";
+    std::array<asio::const_buffer, 2> buffers{asio::buffer(head),
+                                              asio::buffer(body)};
+    co_await asio::async_write(m_socket, buffers, asio::use_awaitable);
+}
+
+asio::awaitable<void> HttpExchange::begin(std::string_view content_type) {
+    m_streaming = true;
+    auto head = std::format(
+        "HTTP/1.1 200 OK\r\nContent-Type: {}\r\nCache-Control: no-cache\r\n"
+        "Connection: close\r\n",
+        content_type);
+    for (const auto &[name, value] : m_reply_headers)
+        head += std::format("{}: {}\r\n", name, value);
+    head += "\r\n";
+    co_await write(head);
+}
+
+asio::awaitable<void> HttpExchange::write(std::string_view data) {
+    co_await asio::async_write(m_socket, asio::buffer(data),
+                               asio::use_awaitable);
+}
+
+HttpServer::HttpServer(std::string name, const std::optional<ThreadConfig> &cfg)
+    : m_pool(std::move(name), cfg) {}
+
+HttpServer::~HttpServer() {
+    stop();
+}
+
+void HttpServer::route(std::string method, std::string path, Handler handler,
+                       bool stream_body) {
+    Route route{std::move(handler), stream_body};
+    if (path.ends_with('*')) {
+        path.pop_back();
+        m_prefixes.emplace_back(method + " " + path, std::move(route));
+        // Longest prefix first.
+        std::ranges::stable_sort(m_prefixes, [](auto &a, auto &b) {
+            return a.first.size() > b.first.size();
+        });
+    } else {
+        m_routes.insert_or_assign(method + " " + path, std::move(route));
+    }
+}
+
+const HttpServer::Route *HttpServer::find(const std::string &method,
+                                          const std::string &path,
+                                          std::string_view &wildcard) const {
+    auto key = method + " " + path;
+    if (auto it = m_routes.find(key); it != m_routes.end())
+        return &it->second;
+    for (const auto &[prefix, route] : m_prefixes) {
+        if (key.starts_with(prefix)) {
+            wildcard = std::string_view(path).substr(prefix.size() -
+                                                     method.size() - 1);
+            return &route;
+        }
+    }
+    return nullptr;
+}
+
+void HttpServer::listen(const std::string &host, uint16_t port) {
+    asio::ip::tcp::endpoint endpoint(asio::ip::make_address(host), port);
+    m_acceptor.emplace(m_pool.context());
+    m_acceptor->open(endpoint.protocol());
+    m_acceptor->set_option(asio::ip::tcp::acceptor::reuse_address(true));
+    m_acceptor->bind(endpoint);
+    m_acceptor->listen();
+    asio::co_spawn(m_pool.context(), accept(), asio::detached);
+    m_pool.start();
+    SPDLOG_INFO("start http server at {}:{}", host, port);
+}
+
+void HttpServer::stop() {
+    m_pool.stop();
+    m_pool.join();
+    m_acceptor.reset();
+}
+
+asio::awaitable<void> HttpServer::accept() {
+    for (;;) {
+        auto [ec, socket] =
+            co_await m_acceptor->async_accept(asio::as_tuple(asio::use_awaitable));
+        if (ec == asio::error::operation_aborted)
+            break;
+        if (ec) {
+            SPDLOG_ERROR("http accept: {}", ec.message());
+            continue;
+        }
+        asio::co_spawn(m_pool.context(), serve(std::move(socket)),
+                       asio::detached);
+    }
+}
+
+asio::awaitable<void> HttpServer::serve(asio::ip::tcp::socket socket) {
+    std::string buffer;
+    try {
+        for (;;) {
+            const auto end = co_await asio::async_read_until(
+                socket, asio::dynamic_buffer(buffer, kMaxHeader), "\r\n\r\n",
+                asio::use_awaitable);
+            HttpExchange ex(socket, buffer);
+            const bool ok = ex.parse(std::string_view(buffer).substr(0, end));
+            buffer.erase(0, end);
+            if (!ok) {
+                ex.reply(400, "bad request\n");
+                co_await ex.respond(false);
+                break;
+            }
+            bool keep_alive = ex.m_version == "HTTP/1.1" &&
+                              !iequals(ex.header("connection"), "close");
+            if (ex.hasHeader("transfer-encoding")) {
+                ex.reply(501, "chunked bodies are not supported\n");
+                co_await ex.respond(false);
+                break;
+            }
+            if (auto length = ex.header("content-length"); !length.empty()) {
+                auto [ptr, ec] = std::from_chars(
+                    length.data(), length.data() + length.size(),
+                    ex.m_body_left);
+                if (ec != std::errc{} || ptr != length.data() + length.size()) {
+                    ex.reply(400, "bad content-length\n");
+                    co_await ex.respond(false);
+                    break;
+                }
+            }
+            const auto *route = find(ex.m_method, ex.m_path, ex.m_wildcard);
+            if (route == nullptr) {
+                ex.reply(404, "not found\n");
+            } else if (!route->stream_body && ex.m_body_left > kMaxBody) {
+                ex.reply(413, "body too large\n");
+            } else {
+                if (!route->stream_body)
+                    co_await ex.readBody();
+                try {
+                    co_await route->handler(ex);
+                } catch (const std::system_error &) {
+                    throw;
+                } catch (const std::exception &e) {
+                    SPDLOG_ERROR("{} {}: {}", ex.m_method, ex.m_path,
+                                 e.what());
+                    if (ex.m_streaming)
+                        break;
+                    ex.reply(500, "internal error\n");
+                }
+            }
+            // A streamed response ends with the connection.
+            if (ex.m_streaming)
+                break;
+            // What the handler left of the body is not worth skipping.
+            if (ex.m_body_left > 0)
+                keep_alive = false;
+            co_await ex.respond(keep_alive);
+            if (!keep_alive)
+                break;
+        }
+    } catch (const std::system_error &e) {
+        // The client went away or sent an oversized header.
+        SPDLOG_DEBUG("http connection: {}", e.what());
+    }
+    asio::error_code ec;
+    socket.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+    socket.close(ec);
+}
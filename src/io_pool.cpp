@@ -0,0 +1,98 @@
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+#include "io_pool.h"
+
+IoPool::IoPool(std::string name, const std::optional<ThreadConfig> &cfg,
+               std::shared_ptr<asio::io_context> ctx)
+    : m_name(std::move(name)),
+      m_ctx(std::move(ctx)),
+      m_threads_count(1),
+      m_busy_poll(false) {
+    if (cfg) {
+        m_threads_count = std::max<size_t>(cfg->threads.value_or(1), 1);
+        m_cpus = cfg->cpus.value_or(std::vector<int32_t>{});
+        m_busy_poll = cfg->busy_poll.value_or(false);
+    }
+}
+
+IoPool::~IoPool() {
+    stop();
+    join();
+}
+
+void IoPool::start() {
+    m_guard.emplace(m_ctx->get_executor());
+    spawn(0);
+}
+
+void IoPool::run() {
+    m_guard.emplace(m_ctx->get_executor());
+    spawn(1);
+    runThread(0);
+    join();
+}
+
+void IoPool::stop() {
+    m_guard.reset();
+    m_ctx->stop();
+}
+
+void IoPool::join() {
+    for (auto &thread : m_threads) {
+        if (thread.joinable() && thread.get_id() != std::this_thread::get_id())
+            thread.join();
+    }
+    m_threads.clear();
+}
+
+void IoPool::setup(const std::string &name, size_t index,
+                   const std::vector<int32_t> &cpus) {
+    // Linux caps thread names at 15 characters.
+    auto thread_name = std::format("{}-{}", name, index).substr(0, 15);
+    pthread_setname_np(pthread_self(), thread_name.c_str());
+    if (cpus.empty())
+        return;
+    const int cpu = cpus[index % cpus.size()];
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        rc != 0) {
+        SPDLOG_ERROR("pin {} to cpu {}: {}", thread_name, cpu,
+                     std::strerror(rc));
+        return;
+    }
+    SPDLOG_INFO("{} pinned to cpu {}", thread_name, cpu);
+}
+
+void IoPool::spawn(size_t from) {
+    for (size_t i = from; i < m_threads_count; ++i)
+        m_threads.emplace_back([this, i] { runThread(i); });
+}
+
+void IoPool::runThread(size_t index) {
+    setup(m_name, index, m_cpus);
+    // A handler that throws leaves the context as it was, so the thread
+    // goes back to it instead of taking the pool down with it.
+    for (;;) {
+        try {
+            if (m_busy_poll) {
+                while (!m_ctx->stopped())
+                    m_ctx->poll();
+            } else {
+                m_ctx->run();
+            }
+            return;
+        } catch (const std::exception &e) {
+            SPDLOG_ERROR("{}-{}: {}", m_name, index, e.what());
+        }
+    }
+}
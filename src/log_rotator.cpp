@@ -0,0 +1,132 @@
+#include <zlib.h>
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "log_rotator.h"
+
+namespace {
+
+constexpr size_t kChunk = 64 << 10;
+
+// n of "<kind>.backup.<n>.log" with an optional ".gz", or nullopt.
+std::optional<uint64_t> backupIndex(std::string_view name) {
+    for (std::string_view kind : {"messages.backup.", "event.backup."}) {
+        if (!name.starts_with(kind))
+            continue;
+        name.remove_prefix(kind.size());
+        uint64_t index = 0;
+        auto [ptr, ec] =
+            std::from_chars(name.data(), name.data() + name.size(), index);
+        std::string_view rest(ptr, name.data() + name.size() - ptr);
+        if (ec != std::errc{} || (rest != ".log" && rest != ".log.gz"))
+            return std::nullopt;
+        return index;
+    }
+    return std::nullopt;
+}
+
+}  // namespace
+
+LogRotator::LogRotator(const MessageLogConfig &cfg)
+    : m_cfg(cfg), m_pool("log", std::nullopt) {
+    m_pool.start();
+}
+
+LogRotator::~LogRotator() {
+    m_stopping.store(true);
+    m_pool.stop();
+    m_pool.join();
+}
+
+uint64_t LogRotator::nextIndex(const std::string &prefix) {
+    std::lock_guard lk(m_mutex);
+    if (auto it = m_next.find(prefix); it != m_next.end())
+        return it->second++;
+    const std::filesystem::path path(prefix);
+    const auto base = path.filename().string();
+    auto dir = path.parent_path();
+    if (dir.empty())
+        dir = ".";
+    uint64_t last = 0;
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(dir, ec)) {
+        const auto name = entry.path().filename().string();
+        if (!name.starts_with(base))
+            continue;
+        const auto rest = std::string_view(name).substr(base.size());
+        if (rest.ends_with(".gz.tmp")) {
+            // Cut short by the last shutdown.
+            std::filesystem::remove(entry.path(), ec);
+            continue;
+        }
+        const auto index = backupIndex(rest);
+        if (!index)
+            continue;
+        last = std::max(last, index.value());
+        if (rest.ends_with(".log"))
+            compress(entry.path().string());
+    }
+    if (ec)
+        SPDLOG_ERROR("list {}: {}", dir.string(), ec.message());
+    m_next.emplace(prefix, last + 2);
+    return last + 1;
+}
+
+void LogRotator::compress(std::string path) {
+    if (!m_cfg.compress.value_or(true))
+        return;
+    std::error_code ec;
+    const uint64_t size = std::filesystem::file_size(path, ec);
+    if (ec)
+        return;
+    m_backlog.fetch_add(size, std::memory_order::relaxed);
+    asio::post(m_pool.context(), [this, path = std::move(path), size] {
+        gzip(path);
+        m_backlog.fetch_sub(size, std::memory_order::relaxed);
+    });
+}
+
+void LogRotator::gzip(const std::string &path) {
+    const auto tmp = path + ".gz.tmp";
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        SPDLOG_ERROR("open {}", path);
+        return;
+    }
+    gzFile out = gzopen(tmp.c_str(), "wb");
+    if (out == nullptr) {
+        SPDLOG_ERROR("open {}", tmp);
+        return;
+    }
+    std::vector<char> buffer(kChunk);
+    bool ok = true;
+    while (ok && in) {
+        in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        const auto n = static_cast<int>(in.gcount());
+        ok = n == 0 || gzwrite(out, buffer.data(), n) == n;
+        ok = ok && !m_stopping.load(std::memory_order::relaxed);
+    }
+    ok = gzclose(out) == Z_OK && ok && !in.bad();
+    std::error_code ec;
+    if (!ok) {
+        if (!m_stopping)
+            SPDLOG_ERROR("compress {}", path);
+        std::filesystem::remove(tmp, ec);
+        return;
+    }
+    std::filesystem::rename(tmp, path + ".gz", ec);
+    if (!ec)
+        std::filesystem::remove(path, ec);
+    if (ec)
+        SPDLOG_ERROR("compress {}: {}", path, ec.message());
+}
@@ -1,34 +1,48 @@
 #include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include <quickfix/Exceptions.h>
 #include <quickfix/FileLog.h>
 #include <quickfix/FileStore.h>
 #include <quickfix/Log.h>
+#include <quickfix/MessageStore.h>
 #include <quickfix/SessionSettings.h>
-#include <quickfix/SocketAcceptor.h>
 
 #include <spdlog/spdlog.h>
 #include <asio.hpp>
 
 #include <application.h>
+#include <asio_acceptor.h>
+#include <fix_encoder.h>
+#include <io_pool.h>
+#include <log_rotator.h>
+#include <message_store.h>
 
 class SimFileLogFactory : public FIX::LogFactory {
 public:
-    SimFileLogFactory(FIX::SessionSettings settings)
+    SimFileLogFactory(FIX::SessionSettings settings, LogRotator &rotator)
         : m_settings(std::move(settings)),
+          m_rotator(rotator),
           m_globalLog(nullptr),
           m_globalLogCount(0) {};
-    SimFileLogFactory(const std::string &path)
+    SimFileLogFactory(const std::string &path, LogRotator &rotator)
         : m_path(path),
           m_backupPath(path),
+          m_rotator(rotator),
           m_globalLog(nullptr),
           m_globalLogCount(0) {};
-    SimFileLogFactory(std::string path, std::string backupPath)
+    SimFileLogFactory(std::string path, std::string backupPath,
+                      LogRotator &rotator)
         : m_path(std::move(path)),
           m_backupPath(std::move(backupPath)),
+          m_rotator(rotator),
           m_globalLog(nullptr),
           m_globalLogCount(0) {};
 
@@ -41,24 +55,35 @@ private:
     std::string m_path;
     std::string m_backupPath;
     FIX::SessionSettings m_settings;
+    LogRotator &m_rotator;
     FIX::Log *m_globalLog;
     int m_globalLogCount;
 };
 
+// Backups are numbered by the LogRotator and compressed on its thread, so
+// rotating costs a session two renames and two opens.
 class SimFileLog : public FIX::Log {
 public:
-    SimFileLog(const std::string &path) { init(path, path, "GLOBAL"); }
+    SimFileLog(const std::string &path, LogRotator &rotator)
+        : m_rotator(rotator) {
+        init(path, path, "GLOBAL");
+    }
 
-    SimFileLog(const std::string &path, const std::string &backupPath) {
+    SimFileLog(const std::string &path, const std::string &backupPath,
+               LogRotator &rotator)
+        : m_rotator(rotator) {
         init(path, backupPath, "GLOBAL");
     }
 
-    SimFileLog(const std::string &path, const FIX::SessionID &s) {
+    SimFileLog(const std::string &path, const FIX::SessionID &s,
+               LogRotator &rotator)
+        : m_rotator(rotator) {
         init(path, path, generatePrefix(s));
     }
 
     SimFileLog(const std::string &path, const std::string &backupPath,
-               const FIX::SessionID &s) {
+               const FIX::SessionID &s, LogRotator &rotator)
+        : m_rotator(rotator) {
         init(path, backupPath, generatePrefix(s));
     }
 
@@ -74,56 +99,38 @@ public:
         m_messages.open(m_messagesFileName.c_str(),
                         std::ios::out | std::ios::trunc);
         m_event.open(m_eventFileName.c_str(), std::ios::out | std::ios::trunc);
+        restart(0);
     }
 
     void backup() override {
+        const auto i = m_rotator.nextIndex(m_fullBackupPrefix);
+        auto messagesFileName =
+            std::format("{}messages.backup.{}.log", m_fullBackupPrefix, i);
+        auto eventFileName =
+            std::format("{}event.backup.{}.log", m_fullBackupPrefix, i);
         m_messages.close();
         m_event.close();
-
-        int i = 0;
-        while (true) {
-            std::stringstream messagesFileName;
-            std::stringstream eventFileName;
-
-            messagesFileName << m_fullBackupPrefix << "messages.backup." << ++i
-                             << ".log";
-            eventFileName << m_fullBackupPrefix << "event.backup." << i
-                          << ".log";
-            FILE *messagesLogFile =
-                FIX::file_fopen(messagesFileName.str().c_str(), "r");
-            FILE *eventLogFile =
-                FIX::file_fopen(eventFileName.str().c_str(), "r");
-
-            if (messagesLogFile == nullptr && eventLogFile == nullptr) {
-                FIX::file_rename(m_messagesFileName.c_str(),
-                                 messagesFileName.str().c_str());
-                FIX::file_rename(m_eventFileName.c_str(),
-                                 eventFileName.str().c_str());
-                m_messages.open(m_messagesFileName.c_str(),
-                                std::ios::out | std::ios::trunc);
-                m_event.open(m_eventFileName.c_str(),
-                             std::ios::out | std::ios::trunc);
-                return;
-            }
-
-            if (messagesLogFile != nullptr) {
-                FIX::file_fclose(messagesLogFile);
-            }
-            if (eventLogFile != nullptr) {
-                FIX::file_fclose(eventLogFile);
-            }
-        }
+        FIX::file_rename(m_messagesFileName.c_str(), messagesFileName.c_str());
+        FIX::file_rename(m_eventFileName.c_str(), eventFileName.c_str());
+        m_messages.open(m_messagesFileName.c_str(),
+                        std::ios::out | std::ios::trunc);
+        m_event.open(m_eventFileName.c_str(), std::ios::out | std::ios::trunc);
+        restart(0);
+        m_rotator.compress(std::move(messagesFileName));
+        m_rotator.compress(std::move(eventFileName));
     }
 
     void onIncoming(const std::string &value) override {
         m_messages << FIX::UtcTimeStampConvertor::convert(
                           FIX::UtcTimeStamp::now(), 9)
                    << " I: " << value << std::endl;
+        written(value.size());
     }
     void onOutgoing(const std::string &value) override {
         m_messages << FIX::UtcTimeStampConvertor::convert(
                           FIX::UtcTimeStamp::now(), 9)
                    << " O: " << value << std::endl;
+        written(value.size());
     }
     void onEvent(const std::string &value) override {
         m_event << FIX::UtcTimeStampConvertor::convert(FIX::UtcTimeStamp::now(),
@@ -132,6 +139,24 @@ public:
     }
 
 private:
+    // The timestamp and direction in front of each message.
+    static constexpr size_t kLineOverhead = 34;
+
+    void restart(uint64_t size) {
+        m_size = size;
+        if (auto age = m_rotator.config().max_age)
+            m_rotate_at = std::chrono::steady_clock::now() +
+                          std::chrono::minutes(age.value());
+    }
+
+    void written(size_t size) {
+        m_size += size + kLineOverhead;
+        const auto &cfg = m_rotator.config();
+        if ((cfg.max_size && m_size >= uint64_t{cfg.max_size.value()} << 20) ||
+            (cfg.max_age && std::chrono::steady_clock::now() >= m_rotate_at))
+            backup();
+    }
+
     std::string generatePrefix(const FIX::SessionID &s) {
         const std::string &begin = s.getBeginString().getString();
         const std::string &sender = s.getSenderCompID().getString();
@@ -175,6 +200,9 @@ private:
             throw FIX::ConfigError("Could not open event file: " +
                                    m_eventFileName);
         }
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(m_messagesFileName, ec);
+        restart(ec ? 0 : size);
     }
     std::ofstream m_messages;
     std::ofstream m_event;
@@ -182,6 +210,10 @@ private:
     std::string m_eventFileName;
     std::string m_fullPrefix;
     std::string m_fullBackupPrefix;
+    LogRotator &m_rotator;
+    // Bytes in the messages file, and when it is rotated by age.
+    uint64_t m_size{0};
+    std::chrono::steady_clock::time_point m_rotate_at;
 };
 
 FIX::Log *SimFileLogFactory::create() {
@@ -190,7 +222,7 @@ FIX::Log *SimFileLogFactory::create() {
     }
 
     if (m_path.size()) {
-        return new SimFileLog(m_path);
+        return new SimFileLog(m_path, m_rotator);
     }
 
     try {
@@ -202,7 +234,7 @@ FIX::Log *SimFileLogFactory::create() {
             backupPath = settings.getString(FIX::FILE_LOG_BACKUP_PATH);
         }
 
-        return m_globalLog = new SimFileLog(path, backupPath);
+        return m_globalLog = new SimFileLog(path, backupPath, m_rotator);
     } catch (FIX::ConfigError &) {
         m_globalLogCount--;
         throw;
@@ -211,10 +243,10 @@ FIX::Log *SimFileLogFactory::create() {
 
 FIX::Log *SimFileLogFactory::create(const FIX::SessionID &s) {
     if (m_path.size() && m_backupPath.size()) {
-        return new SimFileLog(m_path, m_backupPath, s);
+        return new SimFileLog(m_path, m_backupPath, s, m_rotator);
     }
     if (m_path.size()) {
-        return new SimFileLog(m_path, s);
+        return new SimFileLog(m_path, s, m_rotator);
     }
 
     std::string path;
@@ -226,7 +258,7 @@ FIX::Log *SimFileLogFactory::create(const FIX::SessionID &s) {
         backupPath = settings.getString(FIX::FILE_LOG_BACKUP_PATH);
     }
 
-    return new SimFileLog(path, backupPath, s);
+    return new SimFileLog(path, backupPath, s, m_rotator);
 }
 
 void SimFileLogFactory::destroy(FIX::Log *pLog) {
@@ -235,20 +267,52 @@ void SimFileLogFactory::destroy(FIX::Log *pLog) {
     }
 }
 
+std::unique_ptr<FIX::MessageStoreFactory> createStoreFactory(
+    const std::optional<MessageStoreConfig> &cfg,
+    const FIX::SessionSettings &settings) {
+    if (!cfg || cfg->type == StoreType::File) {
+        return std::make_unique<FIX::FileStoreFactory>(settings);
+    }
+    if (cfg->type == StoreType::Memory) {
+        return std::make_unique<FIX::MemoryStoreFactory>();
+    }
+    auto path = cfg->path.value_or(
+        settings.get().getString(FIX::FILE_STORE_PATH));
+    size_t capacity = size_t(cfg->capacity.value_or(64)) << 20;
+    std::chrono::milliseconds sync_interval(cfg->sync_interval.value_or(100));
+    if (cfg->type == StoreType::Mmap) {
+        return std::make_unique<MmapStoreFactory>(std::move(path), capacity,
+                                                  sync_interval);
+    }
+    return std::make_unique<AsyncStoreFactory>(path, capacity, sync_interval);
+}
+
 int main(int argc, char **argv) {
     try {
         spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e][thread %t][%s:%#][%l] %v");
-        auto [cfg, error] = yaml_cpp_struct::from_yaml<Config>(argv[1]);
+        // fixsim compile-scenario <cfg.yaml> <data.csv> <output>
+        //     [create_time_func]
+        const bool compile =
+            argc > 1 && std::string_view(argv[1]) == "compile-scenario";
+        if (compile && argc < 5) {
+            SPDLOG_ERROR("usage: {} compile-scenario <cfg.yaml> <data.csv> "
+                         "<output> [create_time_func]",
+                         argv[0]);
+            return 1;
+        }
+        // fixsim --check <cfg.yaml>
+        const bool check_only =
+            argc > 1 && std::string_view(argv[1]) == "--check";
+        if (argc < (check_only ? 3 : 2)) {
+            SPDLOG_ERROR("usage: {} [--check] <cfg.yaml>", argv[0]);
+            return 1;
+        }
+        auto [cfg, error] = yaml_cpp_struct::from_yaml<Config>(
+            argv[compile || check_only ? 2 : 1]);
         if (!cfg) {
             SPDLOG_ERROR("{}", error);
             return 1;
         }
-        std::ranges::sort(cfg.value().custom_reply, [](auto &p1, auto &p2) {
-            return (p1.check_condition_header.size() +
-                    p1.check_condition_body.size()) >
-                   (p2.check_condition_header.size() +
-                    p2.check_condition_body.size());
-        });
         auto [str, e] = yaml_cpp_struct::to_yaml(cfg.value());
 
         auto io_context = std::make_shared<asio::io_context>();
@@ -260,13 +324,46 @@ int main(int argc, char **argv) {
         SPDLOG_INFO("dictionary_file: {}", dict_file);
 
         Application application(io_context, cfg.value());
+        if (compile) {
+            application.compileScenario(argv[3], argv[4],
+                                        argc > 5 ? argv[5] : "getTzDateTime");
+            return 0;
+        }
         application.parseXml(dict_file);
+        // The templates are checked against the dictionary before any
+        // session can log on.
+        auto problems = application.check();
+        for (const auto &problem : problems)
+            SPDLOG_ERROR("{}", problem);
+        if (check_only) {
+            if (problems.empty())
+                SPDLOG_INFO("{}: ok", argv[2]);
+            return problems.empty() ? 0 : 1;
+        }
+        if (!problems.empty())
+            return 1;
 
-        FIX::FileStoreFactory store_factory(settings);
-        SimFileLogFactory log_factory(settings);
-
-        auto acceptor = std::make_unique<FIX::SocketAcceptor>(
-            application, store_factory, settings, log_factory);
+        auto store_factory =
+            createStoreFactory(cfg.value().message_store, settings);
+        LogRotator log_rotator(
+            cfg.value().message_log.value_or(MessageLogConfig{}));
+        SimFileLogFactory log_factory(settings, log_rotator);
+        application.setLogRotator(&log_rotator);
+
+        const auto &topology = cfg.value().topology;
+        auto acceptor = std::make_unique<AsioAcceptor>(
+            application, *store_factory, settings, log_factory,
+            topology ? topology->fix : std::nullopt);
+        if (auto &bp = cfg.value().backpressure) {
+            acceptor->setLimits({.high_watermark = bp->high_watermark,
+                                 .low_watermark = bp->low_watermark,
+                                 .policy = bp->policy});
+        }
+        const auto &store_cfg = cfg.value().message_store;
+        acceptor->setResendCapacity(
+            size_t(store_cfg ? store_cfg->resend_ring.value_or(64) : 64) << 20);
+        application.setAcceptor(acceptor.get());
+        SPDLOG_INFO("fix checksum: {}", FixEncoder::checksumImpl());
         acceptor->start();
 
         application.startHttpServer();
@@ -277,7 +374,15 @@ int main(int argc, char **argv) {
             acceptor->stop();
             io_context->stop();
         });
-        io_context->run();
+        std::optional<ThreadConfig> app_cfg;
+        if (topology && topology->app) {
+            app_cfg = topology->app;
+            if (app_cfg->threads.value_or(1) != 1)
+                SPDLOG_WARN("topology.app always runs on one thread");
+            app_cfg->threads = 1;
+        }
+        IoPool app_pool("app", app_cfg, io_context);
+        app_pool.run();
         return 0;
     } catch (const std::exception &e) {
         SPDLOG_ERROR("{}", e.what());
@@ -0,0 +1,333 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <quickfix/FixFieldNumbers.h>
+#include <quickfix/Values.h>
+
+#include <spdlog/spdlog.h>
+#include <asio/as_tuple.hpp>
+
+#include "fix_encoder.h"
+#include "market_data.h"
+
+namespace {
+
+constexpr int64_t kPow10[] = {1,         10,         100,      1000,
+                              10000,     100000,     1000000,  10000000,
+                              100000000, 1000000000};
+
+// Smallest number of decimals that represents the tick exactly.
+int precisionOf(double tick) {
+    for (int p = 0; p < 9; ++p) {
+        double scaled = tick * static_cast<double>(kPow10[p]);
+        if (std::abs(scaled - std::round(scaled)) < 1e-6)
+            return p;
+    }
+    return 9;
+}
+
+int64_t toUnits(double price, int precision) {
+    return std::llround(price * static_cast<double>(kPow10[precision]));
+}
+
+std::string_view formatPrice(char (&buf)[32], int64_t units, int precision) {
+    char *ptr = buf;
+    if (units < 0) {
+        *ptr++ = '-';
+        units = -units;
+    }
+    ptr = std::to_chars(ptr, buf + 20, units / kPow10[precision]).ptr;
+    if (precision > 0) {
+        *ptr++ = '.';
+        const auto frac = units % kPow10[precision];
+        for (auto scale = kPow10[precision] / 10; scale > frac && scale > 1;
+             scale /= 10)
+            *ptr++ = '0';
+        ptr = std::to_chars(ptr, buf + sizeof(buf), frac).ptr;
+    }
+    return {buf, static_cast<size_t>(ptr - buf)};
+}
+
+void appendPrice(std::string &out, int tag, int64_t units, int precision) {
+    char buf[32];
+    FixEncoder::appendField(out, tag, formatPrice(buf, units, precision));
+}
+
+double parseNumber(std::string_view value, const std::string &file) {
+    double result = 0;
+    auto [ptr, ec] =
+        std::from_chars(value.data(), value.data() + value.size(), result);
+    if (ec != std::errc{})
+        throw std::runtime_error(file + ": invalid number: " +
+                                 std::string(value));
+    return result;
+}
+
+}  // namespace
+
+MarketDataPublisher::MarketDataPublisher(const MarketDataConfig &cfg,
+                                         std::string header_fields)
+    : m_cfg(cfg),
+      m_header_fields(std::move(header_fields)),
+      m_max_entries(std::max<size_t>(cfg.max_entries.value_or(100), 2)),
+      m_conflate_bytes(cfg.conflate_bytes.value_or(1 << 20)) {
+    m_books.reserve(m_cfg.symbols.size());
+    for (const auto &symbol : m_cfg.symbols) {
+        auto &book = m_books.emplace_back();
+        book.symbol = symbol.symbol;
+        book.precision = precisionOf(symbol.tick);
+        book.tick = std::max<int64_t>(toUnits(symbol.tick, book.precision), 1);
+        book.spread = book.tick * symbol.spread.value_or(1);
+        book.max_step = symbol.max_step.value_or(1);
+        const auto size = symbol.size.value_or(1000000);
+        const auto bid = toUnits(symbol.price, book.precision);
+        book.level = {bid, bid + book.spread, size, size};
+        if (symbol.file) {
+            std::ifstream in(symbol.file.value());
+            if (!in)
+                throw std::runtime_error("open: " + symbol.file.value());
+            std::string line;
+            while (std::getline(in, line)) {
+                std::vector<std::string_view> cols;
+                for (auto col : line | std::views::split(','))
+                    cols.emplace_back(col.begin(), col.end());
+                if (cols.size() < 2)
+                    continue;
+                Level level = book.level;
+                level.bid = toUnits(parseNumber(cols[0], *symbol.file),
+                                    book.precision);
+                level.offer = toUnits(parseNumber(cols[1], *symbol.file),
+                                      book.precision);
+                if (cols.size() >= 4) {
+                    level.bid_size = static_cast<int64_t>(
+                        parseNumber(cols[2], *symbol.file));
+                    level.offer_size = static_cast<int64_t>(
+                        parseNumber(cols[3], *symbol.file));
+                }
+                book.path.push_back(level);
+            }
+            if (!book.path.empty())
+                book.level = book.path.front();
+        }
+        m_symbols.emplace(book.symbol,
+                          static_cast<uint32_t>(m_books.size() - 1));
+    }
+}
+
+void MarketDataPublisher::setAcceptor(AsioAcceptor *acceptor) {
+    m_acceptor = acceptor;
+}
+
+void MarketDataPublisher::onRequest(const FIX::Message &msg,
+                                    const FIX::SessionID &id) {
+    std::string req_id = msg.getField(FIX::FIELD::MDReqID);
+    const auto &type = msg.getField(FIX::FIELD::SubscriptionRequestType);
+    if (type == "2") {
+        std::lock_guard lk(m_mutex);
+        if (auto it = m_subscriptions.find(id); it != m_subscriptions.end())
+            std::erase_if(it->second, [&](const auto &item) {
+                return item.req_id == req_id;
+            });
+        return;
+    }
+    Subscription sub{.req_id = req_id, .updates = type == "1"};
+    const auto count = msg.groupCount(FIX::FIELD::NoRelatedSym);
+    for (size_t i = 1; i <= count; ++i) {
+        const auto &symbol = msg.getGroupRef(i, FIX::FIELD::NoRelatedSym)
+                                 .getField(FIX::FIELD::Symbol);
+        auto it = m_symbols.find(symbol);
+        if (it == m_symbols.end()) {
+            reject(id, req_id, "unknown symbol: " + symbol);
+            return;
+        }
+        sub.books.push_back(it->second);
+    }
+    sub.sent.assign(sub.books.size(), 0);
+
+    std::lock_guard lk(m_mutex);
+    auto &subs = m_subscriptions[id];
+    std::erase_if(subs,
+                  [&](const auto &item) { return item.req_id == req_id; });
+    subs.emplace_back(std::move(sub));
+}
+
+void MarketDataPublisher::onLogout(const FIX::SessionID &id) {
+    std::lock_guard lk(m_mutex);
+    m_subscriptions.erase(id);
+}
+
+std::optional<std::string> MarketDataPublisher::quote(
+    const std::string &symbol, char side) {
+    auto it = m_symbols.find(symbol);
+    if (it == m_symbols.end())
+        return std::nullopt;
+    char buf[32];
+    std::lock_guard lk(m_mutex);
+    const auto &book = m_books[it->second];
+    const auto px = side == FIX::Side_BUY ? book.level.offer : book.level.bid;
+    return std::string(formatPrice(buf, px, book.precision));
+}
+
+asio::awaitable<void> MarketDataPublisher::run() {
+    asio::steady_timer timer(co_await asio::this_coro::executor);
+    for (;;) {
+        timer.expires_after(m_cfg.interval);
+        auto [ec] =
+            co_await timer.async_wait(asio::as_tuple(asio::use_awaitable));
+        if (ec)
+            break;
+        publish();
+    }
+    co_return;
+}
+
+void MarketDataPublisher::step(Book &book) {
+    Level next = book.level;
+    if (!book.path.empty()) {
+        next = book.path[book.cursor];
+        book.cursor = (book.cursor + 1) % book.path.size();
+    } else {
+        if (book.max_step <= 0)
+            return;
+        std::uniform_int_distribution<int32_t> dist(-book.max_step,
+                                                    book.max_step);
+        next.bid = std::max(book.tick, next.bid + dist(m_gen) * book.tick);
+        next.offer = next.bid + book.spread;
+    }
+    if (next == book.level)
+        return;
+    book.level = next;
+    ++book.version;
+}
+
+void MarketDataPublisher::publish() {
+    if (m_acceptor == nullptr)
+        return;
+    size_t used = 0;
+    {
+        std::lock_guard lk(m_mutex);
+        for (auto &book : m_books)
+            step(book);
+        for (auto &[id, subs] : m_subscriptions) {
+            if (used == m_batches.size())
+                m_batches.emplace_back();
+            auto &batch = m_batches[used];
+            batch.id = id;
+            batch.count = 0;
+            const bool congested =
+                m_acceptor->queuedBytes(id) > m_conflate_bytes ||
+                m_acceptor->congested(id);
+            for (auto &sub : subs) {
+                size_t entries = 0;
+                m_entries.clear();
+                auto flush = [&] {
+                    if (entries == 0)
+                        return;
+                    auto &msg = next(
+                        batch, FIX::MsgType_MarketDataIncrementalRefresh);
+                    FixEncoder::appendField(msg.body, FIX::FIELD::MDReqID,
+                                            sub.req_id);
+                    FixEncoder::appendField(msg.body, FIX::FIELD::NoMDEntries,
+                                            uint64_t{entries});
+                    msg.body += m_entries;
+                    m_entries.clear();
+                    entries = 0;
+                };
+                for (size_t i = 0; i < sub.books.size(); ++i) {
+                    const auto &book = m_books[sub.books[i]];
+                    if (sub.sent[i] == 0) {
+                        auto &msg = next(
+                            batch, FIX::MsgType_MarketDataSnapshotFullRefresh);
+                        FixEncoder::appendField(msg.body, FIX::FIELD::MDReqID,
+                                                sub.req_id);
+                        FixEncoder::appendField(msg.body, FIX::FIELD::Symbol,
+                                                book.symbol);
+                        FixEncoder::appendField(
+                            msg.body, FIX::FIELD::NoMDEntries, uint64_t{2});
+                        appendEntries(msg.body, book, false);
+                        sub.sent[i] = book.version;
+                        continue;
+                    }
+                    if (!sub.updates || congested ||
+                        sub.sent[i] == book.version)
+                        continue;
+                    if (entries + 2 > m_max_entries)
+                        flush();
+                    appendEntries(m_entries, book, true);
+                    entries += 2;
+                    sub.sent[i] = book.version;
+                }
+                flush();
+            }
+            // Snapshot-only requests are done once their W went out.
+            std::erase_if(subs, [](const auto &sub) { return !sub.updates; });
+            if (batch.count > 0)
+                ++used;
+        }
+        std::erase_if(m_subscriptions,
+                      [](const auto &item) { return item.second.empty(); });
+    }
+    for (size_t i = 0; i < used; ++i) {
+        auto &batch = m_batches[i];
+        try {
+            m_acceptor->send(batch.id, {batch.msgs.data(), batch.count});
+        } catch (const std::exception &e) {
+            SPDLOG_ERROR("{}", e.what());
+        }
+    }
+}
+
+OutboundMessage &MarketDataPublisher::next(Batch &batch,
+                                           const char *msg_type) {
+    if (batch.count == batch.msgs.size())
+        batch.msgs.emplace_back();
+    auto &msg = batch.msgs[batch.count++];
+    msg.msg_type = msg_type;
+    msg.header = m_header_fields;
+    msg.body.clear();
+    return msg;
+}
+
+void MarketDataPublisher::appendEntries(std::string &out, const Book &book,
+                                        bool incremental) {
+    const auto &level = book.level;
+    for (const auto type : {FIX::MDEntryType_BID, FIX::MDEntryType_OFFER}) {
+        const bool bid = type == FIX::MDEntryType_BID;
+        if (incremental)
+            FixEncoder::appendField(out, FIX::FIELD::MDUpdateAction,
+                                    std::string_view("1"));
+        FixEncoder::appendField(out, FIX::FIELD::MDEntryType,
+                                std::string_view(&type, 1));
+        if (incremental)
+            FixEncoder::appendField(out, FIX::FIELD::Symbol, book.symbol);
+        appendPrice(out, FIX::FIELD::MDEntryPx, bid ? level.bid : level.offer,
+                    book.precision);
+        FixEncoder::appendField(out, FIX::FIELD::MDEntrySize,
+                                bid ? level.bid_size : level.offer_size);
+    }
+}
+
+void MarketDataPublisher::reject(const FIX::SessionID &id,
+                                 const std::string &req_id,
+                                 const std::string &text) {
+    OutboundMessage out{FIX::MsgType_MarketDataRequestReject, m_header_fields,
+                        {}};
+    FixEncoder::appendField(out.body, FIX::FIELD::MDReqID, req_id);
+    FixEncoder::appendField(out.body, FIX::FIELD::MDReqRejReason,
+                            std::string_view("0"));
+    FixEncoder::appendField(out.body, FIX::FIELD::Text, text);
+    try {
+        m_acceptor->send(id, {&out, 1});
+    } catch (const std::exception &e) {
+        SPDLOG_ERROR("{}", e.what());
+    }
+}
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <type_traits>
+
+#include <quickfix/fix40/ExecutionReport.h>
+#include <quickfix/fix41/ExecutionReport.h>
+#include <quickfix/fix42/ExecutionReport.h>
+#include <quickfix/fix43/ExecutionReport.h>
+#include <quickfix/fix44/ExecutionReport.h>
+#include <quickfix/fix50/ExecutionReport.h>
+
+#include <quickfix/fix40/OrderCancelReject.h>
+#include <quickfix/fix41/OrderCancelReject.h>
+#include <quickfix/fix42/OrderCancelReject.h>
+#include <quickfix/fix43/OrderCancelReject.h>
+#include <quickfix/fix44/OrderCancelReject.h>
+#include <quickfix/fix50/OrderCancelReject.h>
+
+#include <quickfix/fix42/BusinessMessageReject.h>
+#include <quickfix/fix43/BusinessMessageReject.h>
+#include <quickfix/fix44/BusinessMessageReject.h>
+#include <quickfix/fix50/BusinessMessageReject.h>
+
+#include <quickfix/fix42/TradingSessionStatus.h>
+#include <quickfix/fix43/TradingSessionStatus.h>
+#include <quickfix/fix44/TradingSessionStatus.h>
+#include <quickfix/fix50/TradingSessionStatus.h>
+
+#include "message_factory.h"
+
+namespace {
+
+template <typename T>
+std::shared_ptr<FIX::Message> create() {
+    return std::make_shared<T>();
+}
+
+template <typename ExecutionReport, typename OrderCancelReject,
+          typename TradingSessionStatus = void,
+          typename BusinessMessageReject = void>
+constexpr MessageFactory makeFactory(std::string_view begin_string) {
+    MessageFactory factory{.begin_string = begin_string,
+                           .execution_report = &create<ExecutionReport>,
+                           .order_cancel_reject = &create<OrderCancelReject>,
+                           .trading_session_status = nullptr,
+                           .business_message_reject = nullptr};
+    if constexpr (!std::is_void_v<TradingSessionStatus>)
+        factory.trading_session_status = &create<TradingSessionStatus>;
+    if constexpr (!std::is_void_v<BusinessMessageReject>)
+        factory.business_message_reject = &create<BusinessMessageReject>;
+    return factory;
+}
+
+constexpr MessageFactory kFactories[] = {
+    makeFactory<FIX40::ExecutionReport, FIX40::OrderCancelReject>("FIX.4.0"),
+    makeFactory<FIX41::ExecutionReport, FIX41::OrderCancelReject>("FIX.4.1"),
+    makeFactory<FIX42::ExecutionReport, FIX42::OrderCancelReject,
+                FIX42::TradingSessionStatus, FIX42::BusinessMessageReject>(
+        "FIX.4.2"),
+    makeFactory<FIX43::ExecutionReport, FIX43::OrderCancelReject,
+                FIX43::TradingSessionStatus, FIX43::BusinessMessageReject>(
+        "FIX.4.3"),
+    makeFactory<FIX44::ExecutionReport, FIX44::OrderCancelReject,
+                FIX44::TradingSessionStatus, FIX44::BusinessMessageReject>(
+        "FIX.4.4"),
+    makeFactory<FIX50::ExecutionReport, FIX50::OrderCancelReject,
+                FIX50::TradingSessionStatus, FIX50::BusinessMessageReject>(
+        "FIXT.1.1"),
+};
+
+}  // namespace
+
+const MessageFactory *MessageFactory::find(std::string_view begin_string) {
+    auto it = std::ranges::find(kFactories, begin_string,
+                                &MessageFactory::begin_string);
+    return it == std::end(kFactories) ? nullptr : &*it;
+}
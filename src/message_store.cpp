@@ -0,0 +1,499 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <quickfix/Exceptions.h>
+#include <quickfix/FieldConvertors.h>
+#include <quickfix/Utility.h>
+
+#include <spdlog/spdlog.h>
+
+#include "message_store.h"
+
+namespace {
+
+constexpr uint64_t kMagic = 0x474e495253584946;  // "FIXSRING"
+constexpr size_t kHeaderSize = 4096;
+// Operations queued and not yet applied, across every session, before the
+// sessions have to wait for the writer.
+constexpr uint64_t kMaxQueuedOps = 1 << 16;
+
+struct Record {
+    uint64_t seq;
+    uint32_t size;
+    uint32_t reserved;
+};
+
+uint64_t recordSize(uint64_t size) {
+    return sizeof(Record) + ((size + 7) & ~uint64_t{7});
+}
+
+std::string sessionPrefix(const FIX::SessionID &s) {
+    std::string prefix = s.getBeginString().getString() + "-" +
+                         s.getSenderCompID().getString() + "-" +
+                         s.getTargetCompID().getString();
+    if (!s.getSessionQualifier().empty())
+        prefix += "-" + s.getSessionQualifier();
+    return prefix;
+}
+
+std::string errnoString(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+}  // namespace
+
+struct MmapStore::Header {
+    uint64_t magic;
+    uint64_t capacity;
+    uint64_t next_sender;
+    uint64_t next_target;
+    uint64_t head;
+    uint64_t tail;
+    char creation_time[32];
+};
+
+MmapStore::MmapStore(const FIX::UtcTimeStamp &now, const std::string &path,
+                     const FIX::SessionID &id, size_t capacity,
+                     std::chrono::milliseconds sync_interval)
+    : m_capacity(capacity), m_sync_interval(sync_interval) {
+    FIX::file_mkdir(path.c_str());
+    m_file_name =
+        FIX::file_appendpath(path.empty() ? "." : path,
+                             sessionPrefix(id) + ".ring");
+    open(now);
+}
+
+MmapStore::~MmapStore() {
+    if (m_base != nullptr) {
+        ::msync(m_base, m_mapped, MS_SYNC);
+        ::munmap(m_base, m_mapped);
+    }
+    if (m_fd >= 0)
+        ::close(m_fd);
+}
+
+void MmapStore::open(const FIX::UtcTimeStamp &now) {
+    m_fd = ::open(m_file_name.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0)
+        throw FIX::ConfigError(errnoString("Could not open " + m_file_name));
+    m_mapped = kHeaderSize + m_capacity;
+
+    struct stat st {};
+    if (::fstat(m_fd, &st) != 0)
+        throw FIX::ConfigError(errnoString("fstat " + m_file_name));
+    bool fresh = static_cast<size_t>(st.st_size) != m_mapped;
+    if (fresh && st.st_size != 0) {
+        SPDLOG_WARN("{} has a different capacity, starting a new ring",
+                    m_file_name);
+    }
+    if (fresh && ::ftruncate(m_fd, static_cast<off_t>(m_mapped)) != 0)
+        throw FIX::ConfigError(errnoString("ftruncate " + m_file_name));
+
+    void *base =
+        ::mmap(nullptr, m_mapped, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (base == MAP_FAILED)
+        throw FIX::ConfigError(errnoString("mmap " + m_file_name));
+    m_base = static_cast<char *>(base);
+    m_header = reinterpret_cast<Header *>(m_base);
+    m_last_sync = std::chrono::steady_clock::now();
+
+    if (fresh || m_header->magic != kMagic ||
+        m_header->capacity != m_capacity) {
+        reset(now);
+    } else {
+        m_creation_time = FIX::UtcTimeStampConvertor::convert(
+            std::string(m_header->creation_time));
+        rebuildIndex();
+    }
+}
+
+void MmapStore::rebuildIndex() {
+    m_index.clear();
+    const char *data = m_base + kHeaderSize;
+    uint64_t pos = m_header->head;
+    // Every record takes at least sizeof(Record) bytes, which bounds the walk
+    // even if the file was truncated or corrupted.
+    size_t guard = m_capacity / sizeof(Record) + 2;
+    while (pos != m_header->tail && guard-- > 0) {
+        if (m_capacity - pos < sizeof(Record)) {
+            pos = 0;
+            continue;
+        }
+        Record rec;
+        std::memcpy(&rec, data + pos, sizeof(rec));
+        if (rec.seq == 0) {
+            pos = 0;
+            continue;
+        }
+        if (pos + recordSize(rec.size) > m_capacity) {
+            SPDLOG_ERROR("{} is corrupted at offset {}", m_file_name, pos);
+            break;
+        }
+        m_index.push_back({rec.seq, pos, rec.size});
+        pos += recordSize(rec.size);
+    }
+}
+
+void MmapStore::evict(uint64_t from, uint64_t to) {
+    // Inclusive upper bound: a full ring must never end with tail == head,
+    // which rebuildIndex() would read as empty.
+    while (!m_index.empty() && m_index.front().offset >= from &&
+           m_index.front().offset <= to) {
+        m_index.pop_front();
+    }
+}
+
+void MmapStore::maybeSync() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - m_last_sync < m_sync_interval)
+        return;
+    m_last_sync = now;
+    ::msync(m_base, m_mapped, MS_ASYNC);
+}
+
+bool MmapStore::set(FIX::SEQNUM seq, const std::string &msg) {
+    const uint64_t size = recordSize(msg.size());
+    if (size >= m_capacity)
+        throw FIX::IOException("message larger than mmap store capacity");
+
+    // A resent or reset sequence overwrites everything from seq on.
+    while (!m_index.empty() && m_index.back().seq >= seq)
+        m_index.pop_back();
+    if (!m_index.empty()) {
+        const auto &last = m_index.back();
+        m_header->tail = last.offset + recordSize(last.size);
+    }
+
+    char *data = m_base + kHeaderSize;
+    uint64_t tail = m_header->tail;
+    if (tail + size > m_capacity) {
+        evict(tail, m_capacity);
+        if (m_capacity - tail >= sizeof(Record)) {
+            Record marker{};
+            std::memcpy(data + tail, &marker, sizeof(marker));
+        }
+        tail = 0;
+    }
+    evict(tail, tail + size);
+
+    Record rec{.seq = static_cast<uint64_t>(seq),
+               .size = static_cast<uint32_t>(msg.size()),
+               .reserved = 0};
+    std::memcpy(data + tail, &rec, sizeof(rec));
+    std::memcpy(data + tail + sizeof(rec), msg.data(), msg.size());
+    m_index.push_back({seq, tail, rec.size});
+    m_header->head = m_index.front().offset;
+    m_header->tail = tail + size;
+    maybeSync();
+    return true;
+}
+
+void MmapStore::get(FIX::SEQNUM begin, FIX::SEQNUM end,
+                    std::vector<std::string> &result) const {
+    result.clear();
+    const char *data = m_base + kHeaderSize;
+    auto it = std::ranges::lower_bound(m_index, begin, {}, &Entry::seq);
+    for (; it != m_index.end() && it->seq <= end; ++it)
+        result.emplace_back(data + it->offset + sizeof(Record), it->size);
+}
+
+FIX::SEQNUM MmapStore::getNextSenderMsgSeqNum() const {
+    return static_cast<FIX::SEQNUM>(m_header->next_sender);
+}
+
+FIX::SEQNUM MmapStore::getNextTargetMsgSeqNum() const {
+    return static_cast<FIX::SEQNUM>(m_header->next_target);
+}
+
+void MmapStore::setNextSenderMsgSeqNum(FIX::SEQNUM value) {
+    m_header->next_sender = value;
+}
+
+void MmapStore::setNextTargetMsgSeqNum(FIX::SEQNUM value) {
+    m_header->next_target = value;
+}
+
+void MmapStore::incrNextSenderMsgSeqNum() {
+    ++m_header->next_sender;
+}
+
+void MmapStore::incrNextTargetMsgSeqNum() {
+    ++m_header->next_target;
+}
+
+FIX::UtcTimeStamp MmapStore::getCreationTime() const {
+    return m_creation_time;
+}
+
+void MmapStore::reset(const FIX::UtcTimeStamp &now) {
+    m_index.clear();
+    std::memset(m_header, 0, sizeof(Header));
+    m_header->magic = kMagic;
+    m_header->capacity = m_capacity;
+    m_header->next_sender = 1;
+    m_header->next_target = 1;
+    auto time = FIX::UtcTimeStampConvertor::convert(now, 9);
+    time.copy(m_header->creation_time, sizeof(m_header->creation_time) - 1);
+    m_creation_time = FIX::UtcTimeStampConvertor::convert(time);
+    ::msync(m_base, kHeaderSize, MS_SYNC);
+}
+
+void MmapStore::refresh() {
+    rebuildIndex();
+}
+
+MmapStoreFactory::MmapStoreFactory(std::string path, size_t capacity,
+                                   std::chrono::milliseconds sync_interval)
+    : m_path(std::move(path)),
+      m_capacity(capacity),
+      m_sync_interval(sync_interval) {}
+
+FIX::MessageStore *MmapStoreFactory::create(const FIX::UtcTimeStamp &now,
+                                            const FIX::SessionID &id) {
+    return new MmapStore(now, m_path, id, m_capacity, m_sync_interval);
+}
+
+void MmapStoreFactory::destroy(FIX::MessageStore *store) {
+    delete store;
+}
+
+AsyncStore::AsyncStore(AsyncStoreFactory &factory, FIX::MessageStore *backend,
+                       size_t capacity)
+    : m_factory(factory),
+      m_backend(backend),
+      m_capacity(capacity),
+      m_next_sender(backend->getNextSenderMsgSeqNum()),
+      m_next_target(backend->getNextTargetMsgSeqNum()),
+      m_creation_time(backend->getCreationTime()) {}
+
+AsyncStore::~AsyncStore() = default;
+
+bool AsyncStore::set(FIX::SEQNUM seq, const std::string &msg) {
+    auto [it, inserted] = m_cache.try_emplace(seq);
+    m_cached_bytes = m_cached_bytes - it->second.size() + msg.size();
+    it->second = msg;
+    while (m_cached_bytes > m_capacity && m_cache.size() > 1) {
+        m_cached_bytes -= m_cache.begin()->second.size();
+        m_cache.erase(m_cache.begin());
+    }
+    m_factory.enqueue({.backend = m_backend,
+                       .type = AsyncStoreFactory::OpType::Set,
+                       .seq = seq,
+                       .msg = msg,
+                       .time = m_creation_time});
+    return true;
+}
+
+void AsyncStore::get(FIX::SEQNUM begin, FIX::SEQNUM end,
+                     std::vector<std::string> &result) const {
+    result.clear();
+    if (m_cache.empty() || begin < m_cache.begin()->first) {
+        m_factory.drain();
+        std::lock_guard lk(m_factory.m_backend_mutex);
+        m_backend->get(begin, end, result);
+        return;
+    }
+    auto last = m_cache.upper_bound(end);
+    for (auto it = m_cache.lower_bound(begin); it != last; ++it)
+        result.emplace_back(it->second);
+}
+
+FIX::SEQNUM AsyncStore::getNextSenderMsgSeqNum() const {
+    return m_next_sender;
+}
+
+FIX::SEQNUM AsyncStore::getNextTargetMsgSeqNum() const {
+    return m_next_target;
+}
+
+void AsyncStore::setNextSenderMsgSeqNum(FIX::SEQNUM value) {
+    m_next_sender = value;
+    m_factory.enqueue({.backend = m_backend,
+                       .type = AsyncStoreFactory::OpType::NextSender,
+                       .seq = value,
+                       .msg = {},
+                       .time = m_creation_time});
+}
+
+void AsyncStore::setNextTargetMsgSeqNum(FIX::SEQNUM value) {
+    m_next_target = value;
+    m_factory.enqueue({.backend = m_backend,
+                       .type = AsyncStoreFactory::OpType::NextTarget,
+                       .seq = value,
+                       .msg = {},
+                       .time = m_creation_time});
+}
+
+void AsyncStore::incrNextSenderMsgSeqNum() {
+    setNextSenderMsgSeqNum(m_next_sender + 1);
+}
+
+void AsyncStore::incrNextTargetMsgSeqNum() {
+    setNextTargetMsgSeqNum(m_next_target + 1);
+}
+
+FIX::UtcTimeStamp AsyncStore::getCreationTime() const {
+    return m_creation_time;
+}
+
+void AsyncStore::reset(const FIX::UtcTimeStamp &now) {
+    m_cache.clear();
+    m_cached_bytes = 0;
+    m_next_sender = 1;
+    m_next_target = 1;
+    m_creation_time = now;
+    m_factory.enqueue({.backend = m_backend,
+                       .type = AsyncStoreFactory::OpType::Reset,
+                       .seq = 0,
+                       .msg = {},
+                       .time = now});
+}
+
+void AsyncStore::refresh() {
+    m_factory.drain();
+    std::lock_guard lk(m_factory.m_backend_mutex);
+    m_backend->refresh();
+    m_next_sender = m_backend->getNextSenderMsgSeqNum();
+    m_next_target = m_backend->getNextTargetMsgSeqNum();
+    m_creation_time = m_backend->getCreationTime();
+}
+
+AsyncStoreFactory::AsyncStoreFactory(const std::string &path, size_t capacity,
+                                     std::chrono::milliseconds sync_interval)
+    : m_backend_factory(path),
+      m_capacity(capacity),
+      m_sync_interval(sync_interval) {
+    m_thread = std::thread([this] { run(); });
+}
+
+AsyncStoreFactory::~AsyncStoreFactory() {
+    {
+        std::lock_guard lk(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_one();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+FIX::MessageStore *AsyncStoreFactory::create(const FIX::UtcTimeStamp &now,
+                                             const FIX::SessionID &id) {
+    std::lock_guard lk(m_backend_mutex);
+    return new AsyncStore(*this, m_backend_factory.create(now, id),
+                          m_capacity);
+}
+
+void AsyncStoreFactory::destroy(FIX::MessageStore *store) {
+    auto *async_store = static_cast<AsyncStore *>(store);
+    drain();
+    {
+        std::lock_guard lk(m_backend_mutex);
+        m_backend_factory.destroy(async_store->m_backend);
+    }
+    delete async_store;
+}
+
+void AsyncStoreFactory::enqueue(Op op) {
+    // No notify: the writer wakes every sync_interval and takes the whole
+    // batch, which keeps the hot path to a lock and a push_back. A full
+    // queue wakes it and holds the session back until it has caught up.
+    std::unique_lock lk(m_mutex);
+    if (m_enqueued - m_applied >= kMaxQueuedOps) {
+        m_drain_to = std::max(m_drain_to, m_enqueued);
+        m_cv.notify_one();
+        m_drained.wait(
+            lk, [&] { return m_enqueued - m_applied < kMaxQueuedOps; });
+    }
+    m_ops.emplace_back(std::move(op));
+    ++m_enqueued;
+}
+
+void AsyncStoreFactory::drain() {
+    std::unique_lock lk(m_mutex);
+    const auto target = m_enqueued;
+    if (m_applied >= target)
+        return;
+    m_drain_to = std::max(m_drain_to, target);
+    m_cv.notify_one();
+    m_drained.wait(lk, [&] { return m_applied >= target; });
+}
+
+void AsyncStoreFactory::fold(std::vector<Op> &ops) {
+    // Only the last seqnum of each kind per store reaches the file; one
+    // before a Reset would be overwritten by it anyway.
+    std::unordered_map<FIX::MessageStore *, uint8_t> later;
+    for (auto it = ops.rbegin(); it != ops.rend(); ++it) {
+        if (it->type != OpType::NextSender && it->type != OpType::NextTarget)
+            continue;
+        const auto bit = uint8_t{1} << static_cast<int>(it->type);
+        auto &seen = later[it->backend];
+        if (seen & bit)
+            it->backend = nullptr;
+        seen |= bit;
+    }
+}
+
+void AsyncStoreFactory::run() {
+    std::vector<Op> ops;
+    for (;;) {
+        {
+            // Writes go out once per sync_interval, sooner only for a drain
+            // or the destructor.
+            const auto deadline =
+                std::chrono::steady_clock::now() + m_sync_interval;
+            std::unique_lock lk(m_mutex);
+            m_cv.wait_until(lk, deadline,
+                            [&] { return m_stop || m_applied < m_drain_to; });
+            if (m_ops.empty()) {
+                if (m_stop)
+                    return;
+                continue;
+            }
+            ops.swap(m_ops);
+        }
+        fold(ops);
+        {
+            std::lock_guard lk(m_backend_mutex);
+            for (auto &op : ops) {
+                if (op.backend == nullptr)
+                    continue;
+                try {
+                    switch (op.type) {
+                        case OpType::Set:
+                            op.backend->set(op.seq, op.msg);
+                            break;
+                        case OpType::NextSender:
+                            op.backend->setNextSenderMsgSeqNum(op.seq);
+                            break;
+                        case OpType::NextTarget:
+                            op.backend->setNextTargetMsgSeqNum(op.seq);
+                            break;
+                        case OpType::Reset:
+                            op.backend->reset(op.time);
+                            break;
+                    }
+                } catch (const std::exception &e) {
+                    SPDLOG_ERROR("async store: {}", e.what());
+                }
+            }
+        }
+        {
+            std::lock_guard lk(m_mutex);
+            m_applied += ops.size();
+        }
+        m_drained.notify_all();
+        ops.clear();
+    }
+}
@@ -0,0 +1,60 @@
+#include <cstring>
+#include <iterator>
+#include <memory>
+
+#include "resend_ring.h"
+
+void ResendRing::add(FIX::SEQNUM seq) {
+    if (!m_index.empty() && m_index.back().seq >= seq)
+        clear();
+}
+
+size_t ResendRing::tail() const {
+    return m_index.empty() ? 0 : m_index.back().offset + m_index.back().size;
+}
+
+void ResendRing::push(FIX::SEQNUM seq, std::string_view frame) {
+    add(seq);
+    if (frame.empty() || frame.size() > m_capacity) {
+        clear();
+        return;
+    }
+    if (!m_data)
+        m_data = std::make_unique_for_overwrite<char[]>(m_capacity);
+    size_t tail = this->tail();
+    if (tail + frame.size() > m_capacity) {
+        evict(tail, m_capacity);
+        tail = 0;
+    }
+    evict(tail, tail + frame.size());
+    std::memcpy(m_data.get() + tail, frame.data(), frame.size());
+    m_index.push_back({seq, tail, frame.size()});
+}
+
+void ResendRing::pushAdmin(FIX::SEQNUM seq) {
+    add(seq);
+    m_index.push_back({seq, tail(), 0});
+}
+
+bool ResendRing::covers(FIX::SEQNUM begin, FIX::SEQNUM end) const {
+    if (begin > end || begin < from() || end > last())
+        return false;
+    const auto first =
+        std::ranges::lower_bound(m_index, begin, {}, &Entry::seq);
+    const auto past = std::ranges::upper_bound(m_index, end, {}, &Entry::seq);
+    // Seqnums only go up, so a full count means no hole.
+    return static_cast<FIX::SEQNUM>(std::distance(first, past)) ==
+           end - begin + 1;
+}
+
+void ResendRing::evict(size_t from, size_t to) {
+    // The oldest frame is the next one after the tail, so only the first
+    // frame can be in the way; admin seqnums before it go with it.
+    for (;;) {
+        auto it = std::ranges::find_if(
+            m_index, [](const Entry &entry) { return entry.size != 0; });
+        if (it == m_index.end() || it->offset < from || it->offset >= to)
+            return;
+        m_index.erase(m_index.begin(), std::next(it));
+    }
+}
@@ -0,0 +1,186 @@
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "schema.h"
+
+namespace {
+
+// Components can nest; anything deeper than this is a cycle.
+constexpr int kMaxDepth = 32;
+
+std::string etag(std::string_view body) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const unsigned char c : body) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return std::format("\"{:016x}-{:x}\"", hash, body.size());
+}
+
+bool isRequired(pugi::xml_node node) {
+    return node.attribute("required").as_string()[0] == 'Y';
+}
+
+// Required fields first, each group followed by its own fields, commented
+// out and indented, since a reply map cannot hold them yet.
+void appendYaml(std::string &out, const nlohmann::json &fields, int depth) {
+    for (const auto *required : {"Y", "N"}) {
+        for (const auto &[name, value] : fields.items()) {
+            if (value.value("required", "N") != required)
+                continue;
+            if (depth > 0)
+                out += std::format("#{:{}}", "", depth * 2);
+            out += std::format("{}: {} # {}, required({}), type({})\n",
+                               value.value("tag", 0), R"("")", name, required,
+                               value.value("type", ""));
+            if (value.contains("Field"))
+                appendYaml(out, value["Field"], depth + 1);
+        }
+    }
+}
+
+}  // namespace
+
+Schema::Schema(const std::string &path) {
+    auto result = m_doc.load_file(path.c_str());
+    if (!result)
+        throw std::runtime_error(path + ": " + result.description());
+    auto fix = m_doc.child("fix");
+    for (auto node : fix.child("fields").children("field")) {
+        Field field{.tag = node.attribute("number").as_int(),
+                    .name = node.attribute("name").as_string(),
+                    .type = node.attribute("type").as_string(),
+                    .values = {}};
+        for (auto value : node.children("value"))
+            field.values.emplace_back(value.attribute("enum").as_string());
+        m_fields.emplace(field.name, node);
+        m_tags.emplace(field.tag, std::move(field));
+    }
+    for (auto component : fix.child("components").children("component"))
+        m_components.emplace(component.attribute("name").as_string(),
+                             component);
+    add("tag_list", Kind::TagList, {});
+    add("messages", Kind::Messages, {});
+    for (auto node : fix.child("messages").children("message")) {
+        std::string name = node.attribute("name").as_string();
+        add(name + "Yaml", Kind::Yaml, node);
+        add(std::move(name), Kind::Json, node);
+        ++m_messages;
+    }
+}
+
+std::shared_ptr<const Schema::Document> Schema::get(
+    std::string_view name) const {
+    auto it = m_entries.find(name);
+    if (it == m_entries.end())
+        return nullptr;
+    const auto &entry = it->second;
+    std::call_once(entry.once, [&] {
+        auto doc = std::make_shared<Document>();
+        doc->body = render(entry);
+        doc->etag = etag(doc->body);
+        doc->content_type =
+            entry.kind == Kind::Yaml ? "text/plain" : "application/json";
+        entry.doc = std::move(doc);
+    });
+    return entry.doc;
+}
+
+const Schema::Field *Schema::field(int tag) const {
+    auto it = m_tags.find(tag);
+    return it == m_tags.end() ? nullptr : &it->second;
+}
+
+void Schema::add(std::string name, Kind kind, pugi::xml_node node) {
+    auto [it, inserted] = m_entries.try_emplace(std::move(name));
+    it->second.kind = kind;
+    it->second.node = node;
+}
+
+std::string Schema::render(const Entry &entry) const {
+    switch (entry.kind) {
+        case Kind::Json:
+            return message(entry.node).dump();
+        case Kind::Yaml: {
+            std::string out;
+            appendYaml(out, message(entry.node)["Field"], 0);
+            return out;
+        }
+        case Kind::TagList: {
+            nlohmann::json json = nlohmann::json::object();
+            for (const auto &[name, node] : m_fields) {
+                auto &tag = json[node.attribute("number").as_string()];
+                tag["name"] = name;
+                tag["type"] = node.attribute("type").as_string();
+            }
+            return json.dump();
+        }
+        case Kind::Messages: {
+            nlohmann::json json = nlohmann::json::array();
+            for (auto node : m_doc.child("fix").child("messages").children(
+                     "message")) {
+                json.push_back({{"name", node.attribute("name").as_string()},
+                                {"msgtype", node.attribute("msgtype").as_string()},
+                                {"msgcat", node.attribute("msgcat").as_string()}});
+            }
+            return json.dump();
+        }
+    }
+    return {};
+}
+
+nlohmann::json Schema::message(pugi::xml_node node) const {
+    nlohmann::json json;
+    json["MsgType"] = node.attribute("msgtype").as_string();
+    json["Name"] = node.attribute("name").as_string();
+    json["Field"] = nlohmann::json::object();
+    addFields(json["Field"], node, true, {}, 0);
+    return json;
+}
+
+// A field inside a component is only required when the component is.
+void Schema::addFields(nlohmann::json &out, pugi::xml_node node,
+                       bool required, std::string_view component,
+                       int depth) const {
+    if (depth > kMaxDepth)
+        throw std::runtime_error(std::format(
+            "component nesting deeper than {} at {}", kMaxDepth, component));
+    for (auto child : node.children()) {
+        const std::string_view kind = child.name();
+        const std::string_view name = child.attribute("name").as_string();
+        const bool child_required = required && isRequired(child);
+        if (kind == "component") {
+            if (auto it = m_components.find(name); it != m_components.end())
+                addFields(out, it->second, child_required, name, depth + 1);
+            continue;
+        }
+        if (kind != "field" && kind != "group")
+            continue;
+        auto &entry = out[std::string(name)];
+        describe(entry, name);
+        entry["required"] = child_required ? "Y" : "N";
+        if (!component.empty())
+            entry["component"] = component;
+        if (kind == "group") {
+            entry["Field"] = nlohmann::json::object();
+            addFields(entry["Field"], child, true, {}, depth + 1);
+        }
+    }
+}
+
+void Schema::describe(nlohmann::json &entry, std::string_view name) const {
+    auto it = m_fields.find(name);
+    if (it == m_fields.end())
+        return;
+    const auto &field = it->second;
+    entry["tag"] = field.attribute("number").as_int();
+    entry["type"] = field.attribute("type").as_string();
+    for (auto value : field.children("value")) {
+        entry["enum"].push_back(
+            {{"value", value.attribute("enum").as_string()},
+             {"description", value.attribute("description").as_string()}});
+    }
+}
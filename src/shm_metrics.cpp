@@ -0,0 +1,134 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#include "shm_metrics.h"
+
+namespace {
+
+std::string errnoString(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+}  // namespace
+
+ShmMetricsWriter::ShmMetricsWriter(std::string name,
+                                   const std::vector<std::string> &sessions)
+    : m_name("/" + std::move(name)),
+      m_size(sizeof(ShmMetricsSegment) +
+             sessions.size() * sizeof(ShmSessionMetrics)) {
+    // A reader of the old segment keeps its mapping; new readers find the
+    // new one.
+    ::shm_unlink(m_name.c_str());
+    const int fd = ::shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd == -1)
+        throw std::runtime_error(errnoString("shm_open " + m_name));
+    if (::ftruncate(fd, static_cast<off_t>(m_size)) != 0) {
+        const auto error = errnoString("ftruncate " + m_name);
+        ::close(fd);
+        ::shm_unlink(m_name.c_str());
+        throw std::runtime_error(error);
+    }
+    void *base =
+        ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        ::shm_unlink(m_name.c_str());
+        throw std::runtime_error(errnoString("mmap " + m_name));
+    }
+    // ftruncate zero-filled the segment.
+    m_segment = new (base) ShmMetricsSegment();
+    m_sessions = reinterpret_cast<ShmSessionMetrics *>(m_segment + 1);
+    m_segment->version = kShmMetricsVersion;
+    m_segment->sample_size = sizeof(ShmMetricsSample);
+    m_segment->session_size = sizeof(ShmSessionMetrics);
+    m_segment->max_sessions = static_cast<uint32_t>(sessions.size());
+    m_segment->pid = ::getpid();
+    m_segment->started = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::system_clock::now().time_since_epoch())
+                             .count();
+    m_segment->sample.sessions = static_cast<uint32_t>(sessions.size());
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        auto &name = m_sessions[i].name;
+        const auto n = std::min(sessions[i].size(), sizeof(name) - 1);
+        std::memcpy(name, sessions[i].data(), n);
+    }
+    m_segment->magic.store(kShmMetricsMagic, std::memory_order::release);
+}
+
+ShmMetricsWriter::~ShmMetricsWriter() {
+    ::munmap(m_segment, m_size);
+    ::shm_unlink(m_name.c_str());
+}
+
+ShmMetricsReader::ShmMetricsReader(std::string name)
+    : m_name("/" + std::move(name)) {
+    const int fd = ::shm_open(m_name.c_str(), O_RDONLY, 0);
+    if (fd == -1)
+        throw std::runtime_error(errnoString("shm_open " + m_name));
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        const auto error = errnoString("fstat " + m_name);
+        ::close(fd);
+        throw std::runtime_error(error);
+    }
+    m_size = static_cast<size_t>(st.st_size);
+    if (m_size < sizeof(ShmMetricsSegment)) {
+        ::close(fd);
+        throw std::runtime_error(m_name + ": not a fixsim metrics segment");
+    }
+    void *base = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+        throw std::runtime_error(errnoString("mmap " + m_name));
+    m_segment = static_cast<const ShmMetricsSegment *>(base);
+    std::string error;
+    if (m_segment->magic.load(std::memory_order::acquire) != kShmMetricsMagic)
+        error = "not a fixsim metrics segment";
+    else if (m_segment->version != kShmMetricsVersion ||
+             m_segment->sample_size != sizeof(ShmMetricsSample) ||
+             m_segment->session_size != sizeof(ShmSessionMetrics))
+        error = "metrics version " + std::to_string(m_segment->version) +
+                ", expected " + std::to_string(kShmMetricsVersion);
+    else if (m_size < sizeof(ShmMetricsSegment) + m_segment->max_sessions *
+                                                      sizeof(ShmSessionMetrics))
+        error = "truncated segment";
+    if (!error.empty()) {
+        ::munmap(const_cast<ShmMetricsSegment *>(m_segment), m_size);
+        throw std::runtime_error(m_name + ": " + error);
+    }
+}
+
+ShmMetricsReader::~ShmMetricsReader() {
+    ::munmap(const_cast<ShmMetricsSegment *>(m_segment), m_size);
+}
+
+bool ShmMetricsReader::read(ShmMetricsSample &sample,
+                            std::vector<ShmSessionMetrics> &sessions) const {
+    const auto *source =
+        reinterpret_cast<const ShmSessionMetrics *>(m_segment + 1);
+    sessions.resize(m_segment->max_sessions);
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        const auto seq = m_segment->seq.load(std::memory_order::acquire);
+        if (seq & 1)
+            continue;
+        std::memcpy(&sample, &m_segment->sample, sizeof(sample));
+        std::memcpy(sessions.data(), source,
+                    sessions.size() * sizeof(ShmSessionMetrics));
+        std::atomic_thread_fence(std::memory_order::acquire);
+        if (m_segment->seq.load(std::memory_order::relaxed) == seq) {
+            sessions.resize(std::min<size_t>(sample.sessions, sessions.size()));
+            return true;
+        }
+    }
+    return false;
+}
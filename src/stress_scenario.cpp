@@ -0,0 +1,358 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <quickfix/FixFieldNumbers.h>
+
+#include "fix_encoder.h"
+#include "stress_scenario.h"
+
+namespace {
+
+// Feeding a mapping in slices keeps the first chunk close to the start of
+// the file instead of behind a full page-in.
+constexpr size_t kFileSlice = 1 << 20;
+
+constexpr char kMagic[8] = {'F', 'I', 'X', 'S', 'C', 'N', '0', '1'};
+
+// Compiled layout: FileHeader, `rows` FileRow entries, then the bodies.
+struct FileHeader {
+    char magic[8];
+    char fix_version[16];
+    char msg_type[8];
+    uint32_t time_width;
+    uint32_t reserved;
+    uint64_t rows;
+    uint64_t data_size;
+};
+
+struct FileRow {
+    uint64_t offset;
+    uint32_t size;
+    uint32_t transact_time;
+};
+
+std::string_view fixedString(const char *data, size_t size) {
+    return {data, strnlen(data, size)};
+}
+
+void writeAll(int fd, const void *data, size_t size, const std::string &path) {
+    auto *ptr = static_cast<const char *>(data);
+    while (size > 0) {
+        auto n = ::write(fd, ptr, size);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error(path + ": " + std::strerror(errno));
+        }
+        ptr += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+}  // namespace
+
+StressScenario::StressScenario(std::string msg_type, std::string header,
+                               std::function<std::string()> transact_time)
+    : m_msg_type(std::move(msg_type)),
+      m_header(std::move(header)),
+      m_transact_time(std::move(transact_time)) {}
+
+StressScenario::~StressScenario() {
+    if (m_map != nullptr)
+        ::munmap(m_map, m_map_size);
+}
+
+void StressScenario::feed(std::string_view data) {
+    if (!m_partial.empty()) {
+        auto pos = data.find('\n');
+        if (pos == std::string_view::npos) {
+            m_partial.append(data);
+            return;
+        }
+        m_partial.append(data.substr(0, pos));
+        parseLine(m_partial);
+        m_partial.clear();
+        data.remove_prefix(pos + 1);
+    }
+    for (;;) {
+        auto pos = data.find('\n');
+        if (pos == std::string_view::npos)
+            break;
+        parseLine(data.substr(0, pos));
+        data.remove_prefix(pos + 1);
+    }
+    m_partial.assign(data);
+}
+
+void StressScenario::feedFile(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error(path + ": " + std::strerror(errno));
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error(path + ": " + std::strerror(errno));
+    }
+    const auto size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return;
+    }
+    void *addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        throw std::runtime_error(path + ": " + std::strerror(errno));
+    ::madvise(addr, size, MADV_SEQUENTIAL);
+    try {
+        std::string_view data(static_cast<const char *>(addr), size);
+        while (!data.empty()) {
+            auto slice = data.substr(0, kFileSlice);
+            feed(slice);
+            data.remove_prefix(slice.size());
+        }
+    } catch (...) {
+        ::munmap(addr, size);
+        throw;
+    }
+    ::munmap(addr, size);
+}
+
+void StressScenario::finish() {
+    if (!m_partial.empty()) {
+        parseLine(m_partial);
+        m_partial.clear();
+    }
+    publish();
+    m_finished.store(true, std::memory_order::release);
+}
+
+void StressScenario::cancel() {
+    m_cancelled.store(true, std::memory_order::release);
+    m_finished.store(true, std::memory_order::release);
+}
+
+std::vector<std::shared_ptr<const StressScenario::Chunk>>
+StressScenario::chunks() const {
+    std::lock_guard lk(m_mutex);
+    return m_chunks;
+}
+
+void StressScenario::parseLine(std::string_view line) {
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    if (line.empty())
+        return;
+
+    m_fields.clear();
+    while (!line.empty()) {
+        auto pos = line.find(',');
+        auto item = line.substr(0, pos);
+        line.remove_prefix(pos == std::string_view::npos ? line.size()
+                                                          : pos + 1);
+        auto eq = item.find('=');
+        if (eq == std::string_view::npos ||
+            item.find('=', eq + 1) != std::string_view::npos)
+            continue;
+        int tag = 0;
+        auto key = item.substr(0, eq);
+        auto [ptr, ec] = std::from_chars(key.data(), key.data() + key.size(),
+                                         tag);
+        if (ec != std::errc{} || ptr != key.data() + key.size())
+            throw std::invalid_argument(std::format("invalid tag: {}", key));
+        // Framing is added per session when the row is sent.
+        if (tag == FIX::FIELD::BeginString || tag == FIX::FIELD::BodyLength ||
+            tag == FIX::FIELD::CheckSum)
+            continue;
+        m_fields.emplace_back(tag, item.substr(eq + 1));
+    }
+
+    // Same result as setting the fields on a FIX::Message: the body is in
+    // tag order and the first occurrence of a tag in the row wins.
+    constexpr auto by_tag = &std::pair<int, std::string_view>::first;
+    std::ranges::stable_sort(m_fields, {}, by_tag);
+    auto [first, last] = std::ranges::unique(m_fields, {}, by_tag);
+    m_fields.erase(first, last);
+
+    if (!m_current)
+        m_current = std::make_unique<Chunk>();
+    auto &data = m_current->data;
+    const size_t begin = data.size();
+    auto append_transact_time = [&] {
+        // Value offset inside the body, past "60=".
+        m_times.push_back(static_cast<uint32_t>(data.size() - begin + 3));
+        FixEncoder::appendField(data, FIX::FIELD::TransactTime,
+                                m_transact_time());
+    };
+    bool transact_time = false;
+    for (const auto &[tag, value] : m_fields) {
+        if (!transact_time && tag > FIX::FIELD::TransactTime) {
+            append_transact_time();
+            transact_time = true;
+        }
+        if (tag == FIX::FIELD::ExecID) {
+            FixEncoder::appendField(data, tag,
+                                    std::format("fixsim.execid.{}",
+                                                m_exec_id++));
+        } else {
+            FixEncoder::appendField(data, tag, value);
+            if (tag == FIX::FIELD::TransactTime) {
+                m_times.push_back(kNoTransactTime);
+                transact_time = true;
+            }
+        }
+    }
+    if (!transact_time)
+        append_transact_time();
+    m_ends.push_back(static_cast<uint32_t>(data.size()));
+    if (m_ends.size() == kChunkRows)
+        publish();
+}
+
+void StressScenario::publish() {
+    if (m_ends.empty())
+        return;
+    auto chunk = std::move(m_current);
+    chunk->data.shrink_to_fit();
+    chunk->bodies.reserve(m_ends.size());
+    std::string_view data(chunk->data);
+    uint32_t begin = 0;
+    for (auto end : m_ends) {
+        chunk->bodies.push_back(data.substr(begin, end - begin));
+        begin = end;
+    }
+    chunk->transact_time = std::move(m_times);
+    m_times.clear();
+    const auto rows = m_ends.size();
+    m_ends.clear();
+    {
+        std::lock_guard lk(m_mutex);
+        m_chunks.push_back(std::move(chunk));
+    }
+    m_rows.fetch_add(rows, std::memory_order::relaxed);
+}
+
+void StressScenario::compile(const std::string &path,
+                             std::string_view fix_version) const {
+    auto chunks = this->chunks();
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    fix_version.copy(header.fix_version, sizeof(header.fix_version) - 1);
+    std::string_view(m_msg_type).copy(header.msg_type,
+                                      sizeof(header.msg_type) - 1);
+    header.time_width = static_cast<uint32_t>(m_transact_time().size());
+    std::vector<FileRow> rows;
+    rows.reserve(this->rows());
+    for (const auto &chunk : chunks) {
+        for (size_t i = 0; i < chunk->bodies.size(); ++i) {
+            rows.push_back({header.data_size,
+                            static_cast<uint32_t>(chunk->bodies[i].size()),
+                            chunk->transact_time[i]});
+            header.data_size += chunk->bodies[i].size();
+        }
+    }
+    header.rows = rows.size();
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    0644);
+    if (fd < 0)
+        throw std::runtime_error(path + ": " + std::strerror(errno));
+    try {
+        writeAll(fd, &header, sizeof(header), path);
+        writeAll(fd, rows.data(), rows.size() * sizeof(FileRow), path);
+        for (const auto &chunk : chunks)
+            writeAll(fd, chunk->data.data(), chunk->data.size(), path);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+}
+
+void StressScenario::load(const std::string &path,
+                          std::string_view fix_version) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error(path + ": " + std::strerror(errno));
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error(path + ": " + std::strerror(errno));
+    }
+    const auto size = static_cast<size_t>(st.st_size);
+    if (size < sizeof(FileHeader)) {
+        ::close(fd);
+        throw std::invalid_argument(path + ": not a compiled scenario");
+    }
+    // Private and writable: stamping TransactTime copies only the pages it
+    // touches and never reaches the file.
+    void *addr =
+        ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        throw std::runtime_error(path + ": " + std::strerror(errno));
+    m_map = addr;
+    m_map_size = size;
+
+    auto *base = static_cast<char *>(addr);
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0)
+        throw std::invalid_argument(path + ": not a compiled scenario");
+    auto version = fixedString(header.fix_version, sizeof(header.fix_version));
+    if (version != fix_version)
+        throw std::invalid_argument(std::format(
+            "{}: compiled for {}, running {}", path, version, fix_version));
+    const auto time = m_transact_time();
+    if (time.size() != header.time_width)
+        throw std::invalid_argument(std::format(
+            "{}: compiled for a {}-char TransactTime, got {}", path,
+            header.time_width, time.size()));
+    // Checked without adding first, so no field of a corrupt file can wrap
+    // its way past them.
+    const size_t body_size = size - sizeof(FileHeader);
+    if (header.rows > body_size / sizeof(FileRow) ||
+        header.data_size != body_size - header.rows * sizeof(FileRow))
+        throw std::invalid_argument(path + ": truncated scenario");
+    const size_t index_size = header.rows * sizeof(FileRow);
+    m_msg_type = fixedString(header.msg_type, sizeof(header.msg_type));
+
+    auto *index = base + sizeof(FileHeader);
+    auto *data = index + index_size;
+    auto chunk = std::make_unique<Chunk>();
+    for (uint64_t i = 0; i < header.rows; ++i) {
+        FileRow row;
+        std::memcpy(&row, index + i * sizeof(FileRow), sizeof(row));
+        if (row.offset > header.data_size ||
+            row.size > header.data_size - row.offset ||
+            (row.transact_time != kNoTransactTime &&
+             (time.size() > row.size ||
+              row.transact_time > row.size - time.size())))
+            throw std::invalid_argument(path + ": corrupt scenario");
+        char *body = data + row.offset;
+        if (row.transact_time != kNoTransactTime)
+            std::memcpy(body + row.transact_time, time.data(), time.size());
+        chunk->bodies.emplace_back(body, row.size);
+        if (chunk->bodies.size() == kChunkRows) {
+            std::lock_guard lk(m_mutex);
+            m_chunks.push_back(std::move(chunk));
+            chunk = std::make_unique<Chunk>();
+        }
+    }
+    if (!chunk->bodies.empty()) {
+        std::lock_guard lk(m_mutex);
+        m_chunks.push_back(std::move(chunk));
+    }
+    m_rows.store(header.rows, std::memory_order::relaxed);
+    m_finished.store(true, std::memory_order::release);
+}
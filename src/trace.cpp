@@ -0,0 +1,132 @@
+#include <pthread.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+
+#include <nlohmann/json.hpp>
+
+#include "trace.h"
+
+TraceRing g_trace;
+
+#if __has_include(<sys/sdt.h>)
+#define FIXSIM_TRACE_SEMAPHORE(point)                                   \
+    extern "C" volatile unsigned short fixsim_##point##_semaphore       \
+        __attribute__((unused, section(".probes"))) = 0;
+FIXSIM_TRACE_POINTS(FIXSIM_TRACE_SEMAPHORE)
+#undef FIXSIM_TRACE_SEMAPHORE
+#endif
+
+namespace {
+
+void copy(char *out, size_t size, std::string_view text) {
+    const auto n = std::min(text.size(), size - 1);
+    std::memcpy(out, text.data(), n);
+    out[n] = '\0';
+}
+
+}  // namespace
+
+std::string_view traceName(TracePoint point) {
+    switch (point) {
+#define FIXSIM_TRACE_NAME(name) \
+    case TracePoint::name:      \
+        return #name;
+        FIXSIM_TRACE_POINTS(FIXSIM_TRACE_NAME)
+#undef FIXSIM_TRACE_NAME
+    }
+    return "Unknown";
+}
+
+void TraceRing::start(size_t capacity) {
+    std::lock_guard lk(m_start_mutex);
+    if (!m_events) {
+        capacity = std::bit_ceil(std::max<size_t>(capacity, 2));
+        m_events = std::make_unique<Event[]>(capacity);
+        m_mask = capacity - 1;
+    }
+    m_enabled.store(true, std::memory_order::release);
+}
+
+uint8_t TraceRing::threadIndex() {
+    // The last index is shared by every thread past kMaxThreads.
+    thread_local const uint8_t index = [this] {
+        const auto i = std::min(m_threads.fetch_add(1), kMaxThreads - 1);
+        auto &name = m_thread_names[i];
+        if (pthread_getname_np(pthread_self(), name.data(), name.size()) != 0)
+            copy(name.data(), name.size(), "unknown");
+        return static_cast<uint8_t>(i);
+    }();
+    return index;
+}
+
+void TraceRing::record(TracePoint point, std::string_view cl_ord_id,
+                       std::string_view session, int64_t detail) {
+    if (!enabled())
+        return;
+    const auto seq = m_next.fetch_add(1, std::memory_order::relaxed);
+    auto &event = m_events[seq & m_mask];
+    // 0 marks the slot as being written until the new sequence is stored.
+    event.seq.store(0, std::memory_order::relaxed);
+    std::atomic_thread_fence(std::memory_order::release);
+    event.time = std::chrono::steady_clock::now().time_since_epoch().count();
+    event.detail = detail;
+    event.point = point;
+    event.thread = threadIndex();
+    copy(event.cl_ord_id, sizeof(event.cl_ord_id), cl_ord_id);
+    copy(event.session, sizeof(event.session), session);
+    event.seq.store(seq + 1, std::memory_order::release);
+}
+
+std::string TraceRing::chromeJson() const {
+    std::lock_guard lk(m_start_mutex);
+    nlohmann::json events = nlohmann::json::array();
+    const auto threads = std::min(m_threads.load(), kMaxThreads);
+    for (size_t i = 0; i < threads; ++i) {
+        events.push_back({{"name", "thread_name"},
+                          {"ph", "M"},
+                          {"pid", 1},
+                          {"tid", i},
+                          {"args", {{"name", m_thread_names[i].data()}}}});
+    }
+    if (m_events) {
+        const auto next = m_next.load(std::memory_order::acquire);
+        const auto capacity = m_mask + 1;
+        for (auto seq = next > capacity ? next - capacity : 0; seq < next;
+             ++seq) {
+            const auto &slot = m_events[seq & m_mask];
+            if (slot.seq.load(std::memory_order::acquire) != seq + 1)
+                continue;
+            const auto time = slot.time;
+            const auto detail = slot.detail;
+            const auto point = slot.point;
+            const auto thread = slot.thread;
+            char cl_ord_id[sizeof(slot.cl_ord_id)];
+            char session[sizeof(slot.session)];
+            std::memcpy(cl_ord_id, slot.cl_ord_id, sizeof(cl_ord_id));
+            std::memcpy(session, slot.session, sizeof(session));
+            std::atomic_thread_fence(std::memory_order::acquire);
+            // Overwritten while it was copied.
+            if (slot.seq.load(std::memory_order::relaxed) != seq + 1)
+                continue;
+            cl_ord_id[sizeof(cl_ord_id) - 1] = '\0';
+            session[sizeof(session) - 1] = '\0';
+            events.push_back(
+                {{"name", traceName(point)},
+                 {"ph", "i"},
+                 {"s", "t"},
+                 {"ts", static_cast<double>(time) / 1e3},
+                 {"pid", 1},
+                 {"tid", thread},
+                 {"args",
+                  {{"cl_ord_id", cl_ord_id},
+                   {"session", session},
+                   {"detail", detail}}}});
+        }
+    }
+    return nlohmann::json{{"traceEvents", std::move(events)},
+                          {"displayTimeUnit", "ns"}}
+        .dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
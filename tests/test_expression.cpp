@@ -0,0 +1,115 @@
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <gtest/gtest.h>
+#include <quickfix/Message.h>
+
+#include "expression.h"
+
+namespace {
+
+std::string format(Decimal value) {
+    char buf[32];
+    return std::string(buf, value.format(buf));
+}
+
+std::string evaluate(std::string_view text, const FIX::Message &msg = {}) {
+    std::string out;
+    Expression(text).evaluate(msg, out);
+    return out;
+}
+
+}  // namespace
+
+TEST(DecimalTest, Parse) {
+    EXPECT_EQ(Decimal::parse("0").raw, 0);
+    EXPECT_EQ(Decimal::parse("1").raw, Decimal::kScale);
+    EXPECT_EQ(Decimal::parse("-1.5").raw, -150'000'000);
+    EXPECT_EQ(Decimal::parse(".25").raw, 25'000'000);
+    EXPECT_EQ(Decimal::parse("3.").raw, 3 * Decimal::kScale);
+    EXPECT_EQ(Decimal::parse("0.00000001").raw, 1);
+    // Places past kPlaces are cut, not rounded.
+    EXPECT_EQ(Decimal::parse("0.123456789").raw, 12'345'678);
+}
+
+TEST(DecimalTest, ParseLimits) {
+    EXPECT_EQ(Decimal::parse("92233720368.54775807").raw,
+              std::numeric_limits<int64_t>::max());
+    EXPECT_EQ(Decimal::parse("-92233720368.54775808").raw,
+              std::numeric_limits<int64_t>::min());
+    EXPECT_THROW(Decimal::parse("92233720368.54775808"),
+                 std::invalid_argument);
+    EXPECT_THROW(Decimal::parse("92233720368.99999999"),
+                 std::invalid_argument);
+    EXPECT_THROW(Decimal::parse("-92233720368.99999999"),
+                 std::invalid_argument);
+    EXPECT_THROW(Decimal::parse("92233720369"), std::invalid_argument);
+    EXPECT_THROW(Decimal::parse("99999999999999999999"),
+                 std::invalid_argument);
+}
+
+TEST(DecimalTest, ParseRejects) {
+    for (std::string_view text :
+         {"", "-", ".", "+1", "--1", "-+1", "1e5", "1.2.3", "abc", " 1"})
+        EXPECT_THROW(Decimal::parse(text), std::invalid_argument) << text;
+}
+
+TEST(DecimalTest, Format) {
+    EXPECT_EQ(format(Decimal::parse("0")), "0");
+    EXPECT_EQ(format(Decimal::parse("100")), "100");
+    EXPECT_EQ(format(Decimal::parse("1.50")), "1.5");
+    EXPECT_EQ(format(Decimal::parse("-0.00000001")), "-0.00000001");
+    EXPECT_EQ(format(Decimal{std::numeric_limits<int64_t>::min()}),
+              "-92233720368.54775808");
+}
+
+TEST(ExpressionTest, Round) {
+    EXPECT_EQ(evaluate("round(1.2345, 3)"), "1.235");
+    EXPECT_EQ(evaluate("round(1.2344, 3)"), "1.234");
+    EXPECT_EQ(evaluate("round(-1.2345, 3)"), "-1.235");
+    EXPECT_EQ(evaluate("round(2.5, 0)"), "3");
+    EXPECT_EQ(evaluate("round(-2.5, 0)"), "-3");
+    EXPECT_EQ(evaluate("round(1.23456789, 8)"), "1.23456789");
+    EXPECT_THROW(evaluate("round(92233720368.5, 0)"), std::invalid_argument);
+    EXPECT_THROW(Expression("round(1, 9)"), std::invalid_argument);
+}
+
+TEST(ExpressionTest, Div) {
+    EXPECT_EQ(evaluate("1 / 4"), "0.25");
+    EXPECT_EQ(evaluate("-1 / 4"), "-0.25");
+    // Rounded half away from zero at the last place.
+    EXPECT_EQ(evaluate("2 / 3"), "0.66666667");
+    EXPECT_EQ(evaluate("-2 / 3"), "-0.66666667");
+    EXPECT_EQ(evaluate("1 / 3"), "0.33333333");
+    EXPECT_EQ(evaluate("0.00000001 / 2"), "0.00000001");
+    EXPECT_THROW(evaluate("1 / 0"), std::invalid_argument);
+    EXPECT_THROW(evaluate("92233720368 / 0.1"), std::invalid_argument);
+}
+
+TEST(ExpressionTest, Arithmetic) {
+    EXPECT_EQ(evaluate("1 + 2 * 3"), "7");
+    EXPECT_EQ(evaluate("(1 + 2) * 3"), "9");
+    EXPECT_EQ(evaluate("-(1.5)"), "-1.5");
+    EXPECT_EQ(evaluate("0.1 + 0.2"), "0.3");
+    EXPECT_EQ(evaluate("min(3, 1, 2)"), "1");
+    EXPECT_EQ(evaluate("max(3, 1, 2)"), "3");
+    EXPECT_EQ(evaluate("abs(-2.5)"), "2.5");
+    EXPECT_THROW(evaluate("92233720368 + 1"), std::invalid_argument);
+}
+
+TEST(ExpressionTest, Inputs) {
+    FIX::Message msg;
+    msg.getHeader().setField(49, "CLIENT1");
+    msg.setField(11, "order-1");
+    msg.setField(38, "200");
+    msg.setField(44, "1.2345");
+    EXPECT_EQ(evaluate("input.38 * 0.5", msg), "100");
+    EXPECT_EQ(evaluate("round(input.44 * 1.001, 3)", msg), "1.236");
+    EXPECT_EQ(evaluate("concat(input_header.49, \"-\", input.11)", msg),
+              "CLIENT1-order-1");
+    EXPECT_THROW(evaluate("input.11 + 1", msg), std::invalid_argument);
+    EXPECT_THROW(evaluate("input.40 + 1", msg), FIX::FieldNotFound);
+}
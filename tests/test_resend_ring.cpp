@@ -0,0 +1,146 @@
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "resend_ring.h"
+
+namespace {
+
+using Frames = std::vector<std::pair<FIX::SEQNUM, std::string>>;
+
+Frames frames(const ResendRing &ring, FIX::SEQNUM begin, FIX::SEQNUM end) {
+    Frames out;
+    ring.forEach(begin, end, [&](FIX::SEQNUM seq, std::string_view frame) {
+        out.emplace_back(seq, frame);
+    });
+    return out;
+}
+
+}  // namespace
+
+TEST(ResendRingTest, Empty) {
+    ResendRing ring(16);
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.from(), 0);
+    EXPECT_EQ(ring.last(), 0);
+    EXPECT_FALSE(ring.covers(1, 1));
+    EXPECT_TRUE(frames(ring, 1, 10).empty());
+}
+
+TEST(ResendRingTest, WrapEvictsTheOldestFrames) {
+    ResendRing ring(10);
+    ring.push(1, "aaaa");
+    ring.push(2, "bbbb");
+    // 2 bytes left at the end: the frame goes to offset 0 over seq 1.
+    ring.push(3, "cccc");
+    EXPECT_EQ(ring.from(), 2);
+    EXPECT_EQ(ring.last(), 3);
+    EXPECT_EQ(frames(ring, 1, 3), (Frames{{2, "bbbb"}, {3, "cccc"}}));
+    EXPECT_FALSE(ring.covers(1, 3));
+    EXPECT_TRUE(ring.covers(2, 3));
+
+    ring.push(4, "dd");
+    EXPECT_EQ(ring.from(), 3);
+    EXPECT_EQ(frames(ring, 1, 4), (Frames{{3, "cccc"}, {4, "dd"}}));
+}
+
+TEST(ResendRingTest, FrameAtTheBufferEnd) {
+    ResendRing ring(8);
+    ring.push(1, "aaaa");
+    // Ends exactly at the capacity.
+    ring.push(2, "bbbb");
+    EXPECT_EQ(frames(ring, 1, 2), (Frames{{1, "aaaa"}, {2, "bbbb"}}));
+    ring.push(3, "cc");
+    EXPECT_EQ(frames(ring, 1, 3), (Frames{{2, "bbbb"}, {3, "cc"}}));
+    ring.push(4, "dd");
+    EXPECT_EQ(frames(ring, 1, 4), (Frames{{2, "bbbb"}, {3, "cc"}, {4, "dd"}}));
+    // Reaches into the frame at the end.
+    ring.push(5, "eeee");
+    EXPECT_EQ(frames(ring, 1, 5), (Frames{{3, "cc"}, {4, "dd"}, {5, "eeee"}}));
+    EXPECT_TRUE(ring.covers(3, 5));
+}
+
+TEST(ResendRingTest, AdminRunsGoWithTheFrameAfterThem) {
+    ResendRing ring(8);
+    ring.pushAdmin(1);
+    ring.pushAdmin(2);
+    ring.push(3, "aaaa");
+    ring.push(4, "bbbb");
+    EXPECT_TRUE(ring.covers(1, 4));
+    EXPECT_EQ(frames(ring, 1, 4),
+              (Frames{{1, ""}, {2, ""}, {3, "aaaa"}, {4, "bbbb"}}));
+
+    ring.pushAdmin(5);
+    ring.pushAdmin(6);
+    ring.push(7, "cccc");
+    EXPECT_EQ(ring.from(), 4);
+    EXPECT_TRUE(ring.covers(4, 7));
+
+    // The admin run 5-6 stays after 4 is evicted and goes with 7.
+    ring.push(8, "dddd");
+    EXPECT_EQ(ring.from(), 5);
+    EXPECT_EQ(frames(ring, 1, 8),
+              (Frames{{5, ""}, {6, ""}, {7, "cccc"}, {8, "dddd"}}));
+    ring.push(9, "eeee");
+    EXPECT_EQ(ring.from(), 8);
+    EXPECT_EQ(frames(ring, 1, 9), (Frames{{8, "dddd"}, {9, "eeee"}}));
+}
+
+TEST(ResendRingTest, AdminAtTheBufferEnd) {
+    ResendRing ring(8);
+    ring.push(1, "aaaa");
+    ring.push(2, "bbbb");
+    // Recorded at offset 8, past the last byte.
+    ring.pushAdmin(3);
+    ring.push(4, "cccc");
+    EXPECT_EQ(frames(ring, 1, 4), (Frames{{2, "bbbb"}, {3, ""}, {4, "cccc"}}));
+    // 3 belongs to the run before 4 and stays until 4 goes.
+    ring.push(5, "dddd");
+    EXPECT_EQ(frames(ring, 1, 5),
+              (Frames{{3, ""}, {4, "cccc"}, {5, "dddd"}}));
+    EXPECT_TRUE(ring.covers(3, 5));
+    ring.push(6, "eeee");
+    EXPECT_EQ(frames(ring, 1, 6), (Frames{{5, "dddd"}, {6, "eeee"}}));
+}
+
+TEST(ResendRingTest, CoversStopsAtAHole) {
+    ResendRing ring(64);
+    ring.push(1, "a");
+    ring.push(2, "b");
+    // 3 was never written by this process.
+    ring.push(4, "d");
+    ring.pushAdmin(5);
+    EXPECT_TRUE(ring.covers(1, 2));
+    EXPECT_TRUE(ring.covers(4, 5));
+    EXPECT_FALSE(ring.covers(1, 4));
+    EXPECT_FALSE(ring.covers(2, 3));
+    EXPECT_FALSE(ring.covers(3, 3));
+    EXPECT_FALSE(ring.covers(4, 6));
+    EXPECT_FALSE(ring.covers(5, 4));
+    EXPECT_EQ(frames(ring, 2, 4), (Frames{{2, "b"}, {4, "d"}}));
+}
+
+TEST(ResendRingTest, SeqGoingBackClears) {
+    ResendRing ring(64);
+    ring.push(1, "a");
+    ring.push(2, "b");
+    ring.push(3, "c");
+    ring.push(2, "x");
+    EXPECT_EQ(ring.size(), 1);
+    EXPECT_EQ(ring.from(), 2);
+    EXPECT_EQ(frames(ring, 1, 3), (Frames{{2, "x"}}));
+
+    ring.pushAdmin(1);
+    EXPECT_EQ(ring.size(), 1);
+    EXPECT_EQ(frames(ring, 1, 3), (Frames{{1, ""}}));
+}
+
+TEST(ResendRingTest, OversizedFrameEmpties) {
+    ResendRing ring(8);
+    ring.push(1, "aaaa");
+    ring.push(2, "123456789");
+    EXPECT_TRUE(ring.empty());
+    EXPECT_FALSE(ring.covers(1, 2));
+}
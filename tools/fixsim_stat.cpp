@@ -0,0 +1,132 @@
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "shm_metrics.h"
+
+// Prints the rates of a running fixsim from its metrics segment, one line
+// every interval seconds, the way vmstat does. With -s each session gets
+// a line of its own under the totals.
+//
+// fixsim-stat [-n name] [-s] [interval [count]]
+
+namespace {
+
+struct Options {
+    std::string name{"fixsim"};
+    bool sessions{false};
+    std::chrono::milliseconds interval{1000};
+    // 0 runs until interrupted.
+    uint64_t count{0};
+};
+
+Options parse(int argc, char **argv) {
+    Options opts;
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "-n") {
+            if (++i == argc)
+                throw std::invalid_argument("-n needs a value");
+            opts.name = argv[i];
+        } else if (arg == "-s") {
+            opts.sessions = true;
+        } else if (positional++ == 0) {
+            opts.interval = std::chrono::milliseconds(
+                static_cast<int64_t>(std::stod(std::string(arg)) * 1000));
+            if (opts.interval.count() <= 0)
+                throw std::invalid_argument("interval must be positive");
+        } else {
+            opts.count = std::stoull(std::string(arg));
+        }
+    }
+    return opts;
+}
+
+double rate(uint64_t now, uint64_t before, double seconds) {
+    return now >= before ? static_cast<double>(now - before) / seconds : 0;
+}
+
+void printHeader(bool sessions) {
+    std::cout << std::format("{:>10} {:>10} {:>10} {:>10} {:>8} {:>9} {:>9} "
+                             "{:>10} {:>9}\n",
+                             "orders/s", "in/s", "out/s", "stress/s", "timed",
+                             "ids", "mappings", "log_bytes", "sessions");
+    if (sessions)
+        std::cout << std::format("  {:<40} {:>10} {:>10} {:>12} {:>10}\n",
+                                 "session", "in/s", "out/s", "queued", "dropped");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    try {
+        const auto opts = parse(argc, argv);
+        ShmMetricsReader reader(opts.name);
+        ShmMetricsSample last, sample;
+        std::vector<ShmSessionMetrics> last_sessions, sessions;
+        if (!reader.read(last, last_sessions))
+            throw std::runtime_error("the segment is being rewritten");
+        uint64_t lines = 0;
+        while (opts.count == 0 || lines < opts.count) {
+            std::this_thread::sleep_for(opts.interval);
+            if (!reader.read(sample, sessions))
+                continue;
+            const auto seconds =
+                static_cast<double>(sample.time - last.time) / 1e9;
+            // fixsim has not published since the last line.
+            if (seconds <= 0)
+                continue;
+            if (lines++ % 20 == 0)
+                printHeader(opts.sessions);
+            uint64_t in = 0, out = 0, last_in = 0, last_out = 0;
+            uint32_t logged_on = 0;
+            for (size_t i = 0; i < sessions.size(); ++i) {
+                in += sessions[i].messages_in;
+                out += sessions[i].messages_out;
+                logged_on += sessions[i].logged_on;
+                if (i < last_sessions.size()) {
+                    last_in += last_sessions[i].messages_in;
+                    last_out += last_sessions[i].messages_out;
+                }
+            }
+            std::cout << std::format(
+                "{:>10.0f} {:>10.0f} {:>10.0f} {:>10.0f} {:>8} {:>9} {:>9} "
+                "{:>10} {:>9}\n",
+                rate(sample.orders_in, last.orders_in, seconds),
+                rate(in, last_in, seconds), rate(out, last_out, seconds),
+                rate(sample.stress_sent, last.stress_sent, seconds),
+                sample.timed, sample.order_ids, sample.order_mappings,
+                sample.log_backlog,
+                std::format("{}/{}", logged_on, sessions.size()));
+            if (opts.sessions) {
+                for (size_t i = 0; i < sessions.size(); ++i) {
+                    const auto &s = sessions[i];
+                    const auto &before =
+                        i < last_sessions.size() ? last_sessions[i] : s;
+                    std::cout << std::format(
+                        "  {:<40} {:>10.0f} {:>10.0f} {:>12} {:>10}{}\n",
+                        std::string_view(s.name),
+                        rate(s.messages_in, before.messages_in, seconds),
+                        rate(s.messages_out, before.messages_out, seconds),
+                        s.queued_bytes, s.dropped,
+                        s.logged_on ? (s.congested ? " congested" : "")
+                                    : " offline");
+                }
+            }
+            std::cout.flush();
+            last = sample;
+            last_sessions = sessions;
+        }
+        return 0;
+    } catch (const std::exception &e) {
+        std::cerr << argv[0] << ": " << e.what() << std::endl;
+        return 1;
+    }
+}
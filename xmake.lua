@@ -8,9 +8,11 @@ add_defines("NOT_USE_YCS_INIT_VALUE", "SPDLOG_ACTIVE_LEVEL=SPDLOG_LEVEL_DEBUG")
 
 add_repositories("my_private_repo https://github.com/fantasy-peak/xmake-repo.git")
 
-add_requires("asio asio-1-34-2", "cpp-httplib v0.18.0")
+add_requires("asio asio-1-34-2")
 add_requires("spdlog", {configs={std_format=true}})
-add_requires("yaml_cpp_struct", "nlohmann_json", "quickfix", "libuuid", "pugixml")
+add_requires("yaml_cpp_struct", "nlohmann_json", "quickfix", "libuuid", "pugixml", "zlib")
+add_requires("benchmark")
+add_requires("gtest", {configs = {main = true}})
 
 set_languages("c++23")
 add_includedirs("include")
@@ -19,5 +21,74 @@ target("fixsim")
     set_kind("binary")
     add_files("src/*.cpp")
     add_ldflags("-static-libstdc++", "-static-libgcc", {force = true})
-    add_packages("yaml_cpp_struct", "nlohmann_json", "spdlog", "quickfix", "asio", "libuuid", "pugixml", "cpp-httplib")
+    add_packages("yaml_cpp_struct", "nlohmann_json", "spdlog", "quickfix", "asio", "libuuid", "pugixml", "zlib")
+target_end()
+
+target("fixsim-client")
+    set_kind("binary")
+    add_files("client/*.cpp")
+    add_packages("yaml_cpp_struct", "nlohmann_json", "spdlog", "quickfix")
+target_end()
+
+target("fixsim-stat")
+    set_kind("binary")
+    add_files("tools/fixsim_stat.cpp", "src/shm_metrics.cpp")
+target_end()
+
+target("bench_encoder")
+    set_kind("binary")
+    set_default(false)
+    set_group("bench")
+    add_files("bench/bench_encoder.cpp", "src/fix_encoder.cpp")
+    add_packages("quickfix", "benchmark")
+target_end()
+
+target("bench_store")
+    set_kind("binary")
+    set_default(false)
+    set_group("bench")
+    add_files("bench/bench_store.cpp", "src/message_store.cpp")
+    add_packages("quickfix", "spdlog", "benchmark")
+target_end()
+
+target("bench_app")
+    set_kind("binary")
+    set_default(false)
+    set_group("bench")
+    add_files("bench/bench_app.cpp", "src/*.cpp|main.cpp")
+    add_packages("yaml_cpp_struct", "nlohmann_json", "spdlog", "quickfix", "asio", "libuuid", "pugixml", "zlib", "benchmark")
+target_end()
+
+target("bench_e2e")
+    set_kind("binary")
+    set_default(false)
+    set_group("bench")
+    add_files("bench/bench_e2e.cpp", "src/*.cpp|main.cpp")
+    add_packages("yaml_cpp_struct", "nlohmann_json", "spdlog", "quickfix", "asio", "libuuid", "pugixml", "zlib")
+target_end()
+
+target("bench_logon")
+    set_kind("binary")
+    set_default(false)
+    set_group("bench")
+    add_files("bench/bench_logon.cpp", "src/*.cpp|main.cpp")
+    add_packages("yaml_cpp_struct", "nlohmann_json", "spdlog", "quickfix", "asio", "libuuid", "pugixml", "zlib")
+target_end()
+
+target("test_expression")
+    set_kind("binary")
+    set_default(false)
+    set_group("test")
+    add_files("tests/test_expression.cpp", "src/expression.cpp")
+    add_packages("quickfix", "gtest")
+    add_tests("default")
+target_end()
+
+target("test_resend_ring")
+    set_kind("binary")
+    set_default(false)
+    set_group("test")
+    add_files("tests/test_resend_ring.cpp", "src/resend_ring.cpp")
+    add_packages("quickfix", "gtest")
+    add_tests("default")
 target_end()